@@ -0,0 +1,136 @@
+#include "champion_lists.hpp"
+#include "compression_utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t CHAMPION_LISTS_MAGIC = 0x314D4843; // "CHM1"
+constexpr uint32_t CHAMPION_LISTS_VERSION = 1;
+
+struct ChampionListsHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t listSize;
+  uint64_t termCount;
+  uint64_t fingerprint;
+  uint64_t dataSize;
+};
+
+} // namespace
+
+void ChampionLists::reset(size_t listSize, const TermDictionary &dictionary) {
+  clear();
+  m_listSize = listSize;
+  m_fingerprint = dictionary.fingerprint();
+  m_offsets.reserve(dictionary.size() + 1);
+}
+
+void ChampionLists::add(const std::vector<std::pair<int, int>> &postings,
+                        const std::vector<double> &scores) {
+  std::vector<size_t> order(postings.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  if (order.size() > m_listSize) {
+    // При равном tf предпочитаем меньший docId, чтобы выбор не зависел от
+    // реализации nth_element
+    std::nth_element(order.begin(), order.begin() + m_listSize, order.end(),
+                     [&](size_t a, size_t b) {
+                       return scores[a] > scores[b] ||
+                              (scores[a] == scores[b] && a < b);
+                     });
+    order.resize(m_listSize);
+    std::sort(order.begin(), order.end());
+  }
+
+  std::vector<std::pair<int, int>> champions;
+  champions.reserve(order.size());
+  for (size_t index : order) {
+    champions.push_back(postings[index]);
+  }
+
+  std::vector<uint8_t> encoded =
+      CompressionUtils::compressPostingList(champions);
+  m_data.insert(m_data.end(), encoded.begin(), encoded.end());
+  m_offsets.push_back(m_data.size());
+}
+
+void ChampionLists::clear() {
+  m_fingerprint = 0;
+  m_offsets.assign(1, 0);
+  m_data.clear();
+}
+
+size_t ChampionLists::memoryUsage() const {
+  return m_offsets.capacity() * sizeof(uint64_t) + m_data.capacity();
+}
+
+std::vector<std::pair<int, int>> ChampionLists::list(size_t id) const {
+  if (id + 1 >= m_offsets.size()) {
+    return {};
+  }
+  return CompressionUtils::decompressPostingList(std::vector<uint8_t>(
+      m_data.begin() + m_offsets[id], m_data.begin() + m_offsets[id + 1]));
+}
+
+bool ChampionLists::save(const std::string &filePath) const {
+  std::string tmpPath = filePath + ".tmp";
+  std::ofstream file(tmpPath, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  ChampionListsHeader header = {CHAMPION_LISTS_MAGIC, CHAMPION_LISTS_VERSION,
+                                m_listSize,           termCount(),
+                                m_fingerprint,        m_data.size()};
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(m_offsets.data()),
+             m_offsets.size() * sizeof(uint64_t));
+  file.write(reinterpret_cast<const char *>(m_data.data()), m_data.size());
+
+  file.close();
+  if (!file || std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ChampionLists::load(const std::string &filePath,
+                         const TermDictionary &dictionary, size_t listSize) {
+  clear();
+
+  std::ifstream file(filePath, std::ios::binary);
+  ChampionListsHeader header;
+  if (!file.is_open() ||
+      !file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+
+  if (header.magic != CHAMPION_LISTS_MAGIC ||
+      header.version != CHAMPION_LISTS_VERSION ||
+      header.listSize != listSize || header.termCount != dictionary.size() ||
+      header.fingerprint != dictionary.fingerprint()) {
+    return false;
+  }
+
+  std::vector<uint64_t> offsets(header.termCount + 1);
+  std::vector<uint8_t> data(header.dataSize);
+  file.read(reinterpret_cast<char *>(offsets.data()),
+            offsets.size() * sizeof(uint64_t));
+  file.read(reinterpret_cast<char *>(data.data()), data.size());
+  if (!file || offsets.front() != 0 || offsets.back() != data.size() ||
+      !std::is_sorted(offsets.begin(), offsets.end())) {
+    return false;
+  }
+
+  m_listSize = listSize;
+  m_fingerprint = header.fingerprint;
+  m_offsets = std::move(offsets);
+  m_data = std::move(data);
+  return true;
+}
@@ -0,0 +1,71 @@
+#ifndef CHAMPION_LISTS_HPP
+#define CHAMPION_LISTS_HPP
+
+#include "term_dictionary.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// ChampionLists
+// ============================================================================
+
+/**
+ * @brief Списки чемпионов: для каждого термина — до listSize документов с
+ * наибольшим нормированным tf (tf / длина документа)
+ *
+ * Списки хранятся по id термина в словаре одним массивом delta-VByte с
+ * таблицей смещений и сохраняются отдельно от основного индекса
+ * (champions.bin). Файл привязан к отпечатку словаря и размеру списков.
+ */
+class ChampionLists {
+public:
+  static constexpr size_t DEFAULT_LIST_SIZE = 32;
+
+  /**
+   * @brief Начинает построение заново
+   */
+  void reset(size_t listSize, const TermDictionary &dictionary);
+
+  /**
+   * @brief Добавляет список следующего по порядку id термина
+   * @param postings Полный список (docId, tf) по возрастанию docId
+   * @param scores Нормированный tf каждого posting
+   */
+  void add(const std::vector<std::pair<int, int>> &postings,
+           const std::vector<double> &scores);
+
+  void clear();
+
+  bool empty() const { return m_offsets.size() <= 1; }
+  size_t listSize() const { return m_listSize; }
+  size_t termCount() const {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+  size_t memoryUsage() const;
+
+  /**
+   * @return Чемпионы термина (docId, tf) по возрастанию docId
+   */
+  std::vector<std::pair<int, int>> list(size_t id) const;
+
+  bool save(const std::string &filePath) const;
+
+  /**
+   * @return false, если файла нет или он построен для другого словаря или
+   * размера списков
+   */
+  bool load(const std::string &filePath, const TermDictionary &dictionary,
+            size_t listSize);
+
+private:
+  size_t m_listSize = DEFAULT_LIST_SIZE;
+  uint64_t m_fingerprint = 0;
+  std::vector<uint64_t> m_offsets;
+  std::vector<uint8_t> m_data;
+};
+
+#endif // CHAMPION_LISTS_HPP
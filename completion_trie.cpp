@@ -0,0 +1,165 @@
+#include "completion_trie.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+void CompletionTrie::build(
+    const std::vector<std::pair<std::string, uint64_t>> &sortedEntries) {
+  clear();
+
+  for (size_t i = 1; i < sortedEntries.size(); ++i) {
+    if (!(sortedEntries[i - 1].first < sortedEntries[i].first)) {
+      throw std::invalid_argument(
+          "Completion trie input must be sorted and unique");
+    }
+  }
+
+  struct Pending {
+    uint32_t node;
+    size_t lo;
+    size_t hi;
+    size_t depth;
+  };
+
+  m_labels.push_back(0);
+  m_parents.push_back(0);
+  m_firstChild.push_back(0);
+  m_childCount.push_back(0);
+  m_termWeight.push_back(0);
+
+  std::queue<Pending> pending;
+  pending.push({0, 0, sortedEntries.size(), 0});
+
+  while (!pending.empty()) {
+    Pending current = pending.front();
+    pending.pop();
+
+    size_t lo = current.lo;
+    if (lo < current.hi && sortedEntries[lo].first.size() == current.depth) {
+      m_termWeight[current.node] = sortedEntries[lo].second;
+      lo++;
+    }
+
+    m_firstChild[current.node] = static_cast<uint32_t>(m_labels.size());
+
+    while (lo < current.hi) {
+      uint8_t label =
+          static_cast<uint8_t>(sortedEntries[lo].first[current.depth]);
+      size_t hi = lo + 1;
+      while (hi < current.hi &&
+             static_cast<uint8_t>(sortedEntries[hi].first[current.depth]) ==
+                 label) {
+        hi++;
+      }
+
+      uint32_t child = static_cast<uint32_t>(m_labels.size());
+      m_labels.push_back(label);
+      m_parents.push_back(current.node);
+      m_firstChild.push_back(0);
+      m_childCount.push_back(0);
+      m_termWeight.push_back(0);
+      m_childCount[current.node]++;
+
+      pending.push({child, lo, hi, current.depth + 1});
+      lo = hi;
+    }
+  }
+
+  m_maxWeight = m_termWeight;
+  for (size_t node = m_labels.size(); node-- > 1;) {
+    uint32_t parent = m_parents[node];
+    m_maxWeight[parent] = std::max(m_maxWeight[parent], m_maxWeight[node]);
+  }
+}
+
+void CompletionTrie::clear() {
+  m_labels.clear();
+  m_parents.clear();
+  m_firstChild.clear();
+  m_childCount.clear();
+  m_maxWeight.clear();
+  m_termWeight.clear();
+}
+
+size_t CompletionTrie::memoryUsage() const {
+  return m_labels.capacity() +
+         (m_parents.capacity() + m_firstChild.capacity() +
+          m_childCount.capacity()) *
+             sizeof(uint32_t) +
+         (m_maxWeight.capacity() + m_termWeight.capacity()) * sizeof(uint64_t);
+}
+
+int CompletionTrie::findChild(uint32_t node, uint8_t label) const {
+  auto first = m_labels.begin() + m_firstChild[node];
+  auto last = first + m_childCount[node];
+  auto it = std::lower_bound(first, last, label);
+
+  if (it == last || *it != label) {
+    return -1;
+  }
+  return static_cast<int>(it - m_labels.begin());
+}
+
+std::string CompletionTrie::pathTo(uint32_t node) const {
+  std::string path;
+  while (node != 0) {
+    path.push_back(static_cast<char>(m_labels[node]));
+    node = m_parents[node];
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+std::vector<CompletionTrie::Completion>
+CompletionTrie::complete(const std::string &prefix, size_t k) const {
+  std::vector<Completion> result;
+  if (empty() || k == 0) {
+    return result;
+  }
+
+  uint32_t node = 0;
+  for (char c : prefix) {
+    int child = findChild(node, static_cast<uint8_t>(c));
+    if (child < 0) {
+      return result;
+    }
+    node = static_cast<uint32_t>(child);
+  }
+
+  // (вес, является ли запись готовым результатом, -узел)
+  using Entry = std::tuple<uint64_t, bool, int64_t>;
+  std::priority_queue<Entry> frontier;
+
+  if (m_maxWeight[node] > 0) {
+    frontier.emplace(m_maxWeight[node], false, -static_cast<int64_t>(node));
+  }
+
+  while (!frontier.empty() && result.size() < k) {
+    auto [weight, isResult, negNode] = frontier.top();
+    frontier.pop();
+    uint32_t current = static_cast<uint32_t>(-negNode);
+
+    if (isResult) {
+      result.push_back({pathTo(current), weight});
+      continue;
+    }
+
+    if (m_termWeight[current] > 0) {
+      frontier.emplace(m_termWeight[current], true,
+                       -static_cast<int64_t>(current));
+    }
+
+    uint32_t first = m_firstChild[current];
+    for (uint32_t child = first; child < first + m_childCount[current];
+         ++child) {
+      if (m_maxWeight[child] > 0) {
+        frontier.emplace(m_maxWeight[child], false,
+                         -static_cast<int64_t>(child));
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,63 @@
+#ifndef COMPLETION_TRIE_HPP
+#define COMPLETION_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// CompletionTrie
+// ============================================================================
+
+/**
+ * @brief Компактное префиксное дерево для автодополнения
+ *
+ * Узлы хранятся в плоских массивах в порядке обхода в ширину, дети каждого
+ * узла лежат подряд и отсортированы по байту. Каждый узел помнит
+ * максимальный вес в своём поддереве, поэтому top-k дополнений извлекаются
+ * поиском по наилучшему первому без обхода всего поддерева префикса.
+ */
+class CompletionTrie {
+public:
+  struct Completion {
+    std::string text;
+    uint64_t weight;
+  };
+
+  /**
+   * @brief Строит дерево
+   * @param sortedEntries Пары (строка, вес), отсортированные по строке без
+   * повторов; вес 0 означает, что строка не предлагается
+   */
+  void
+  build(const std::vector<std::pair<std::string, uint64_t>> &sortedEntries);
+
+  void clear();
+
+  bool empty() const { return m_labels.empty(); }
+  size_t nodeCount() const { return m_labels.size(); }
+  size_t memoryUsage() const;
+
+  /**
+   * @brief Возвращает k самых тяжёлых строк с заданным префиксом
+   * @param prefix Префикс в нижнем регистре
+   * @param k Число дополнений
+   * @return Дополнения по убыванию веса
+   */
+  std::vector<Completion> complete(const std::string &prefix, size_t k) const;
+
+private:
+  int findChild(uint32_t node, uint8_t label) const;
+  std::string pathTo(uint32_t node) const;
+
+  std::vector<uint8_t> m_labels;
+  std::vector<uint32_t> m_parents;
+  std::vector<uint32_t> m_firstChild;
+  std::vector<uint32_t> m_childCount;
+  std::vector<uint64_t> m_maxWeight;
+  std::vector<uint64_t> m_termWeight;
+};
+
+#endif // COMPLETION_TRIE_HPP
@@ -1,5 +1,6 @@
 #include "compression_utils.hpp"
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 namespace CompressionUtils {
@@ -174,4 +175,177 @@ bool validateCompressedData(const std::vector<uint8_t> &data) {
   }
 }
 
+size_t countPostings(const std::vector<uint8_t> &data) {
+  size_t terminators = 0;
+  for (uint8_t byte : data) {
+    if (byte & 0x80) {
+      terminators++;
+    }
+  }
+  return terminators / 2;
+}
+
+namespace {
+
+constexpr size_t LZ_MIN_MATCH = 4;
+constexpr size_t LZ_LAST_LITERALS = 5;
+constexpr size_t LZ_MAX_OFFSET = 65535;
+constexpr int LZ_HASH_BITS = 14;
+
+uint32_t read32(const uint8_t *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t lzHash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+void writeLength(size_t length, std::vector<uint8_t> &output) {
+  while (length >= 255) {
+    output.push_back(255);
+    length -= 255;
+  }
+  output.push_back(static_cast<uint8_t>(length));
+}
+
+size_t readLength(const uint8_t *data, size_t size, size_t &pos) {
+  size_t length = 0;
+  uint8_t byte;
+  do {
+    if (pos >= size) {
+      throw std::runtime_error("LZ decode: truncated length");
+    }
+    byte = data[pos++];
+    length += byte;
+  } while (byte == 255);
+  return length;
+}
+
+void emitSequence(const uint8_t *literals, size_t literalLength,
+                  size_t offset, size_t matchLength,
+                  std::vector<uint8_t> &output) {
+  size_t matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+
+  uint8_t token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15)
+                                       << 4);
+  token |= static_cast<uint8_t>(std::min<size_t>(matchCode, 15));
+  output.push_back(token);
+
+  if (literalLength >= 15) {
+    writeLength(literalLength - 15, output);
+  }
+  output.insert(output.end(), literals, literals + literalLength);
+
+  if (matchLength == 0) {
+    return;
+  }
+
+  output.push_back(static_cast<uint8_t>(offset & 0xFF));
+  output.push_back(static_cast<uint8_t>(offset >> 8));
+
+  if (matchCode >= 15) {
+    writeLength(matchCode - 15, output);
+  }
+}
+
+} // namespace
+
+std::vector<uint8_t> lzCompress(const uint8_t *data, size_t size) {
+  std::vector<uint8_t> output;
+  output.reserve(size / 2 + 16);
+
+  std::vector<int64_t> table(size_t(1) << LZ_HASH_BITS, -1);
+
+  size_t anchor = 0;
+  size_t pos = 0;
+
+  if (size > LZ_MIN_MATCH + LZ_LAST_LITERALS) {
+    size_t limit = size - LZ_LAST_LITERALS;
+
+    while (pos + LZ_MIN_MATCH <= limit) {
+      uint32_t sequence = read32(data + pos);
+      uint32_t h = lzHash(sequence);
+      int64_t candidate = table[h];
+      table[h] = static_cast<int64_t>(pos);
+
+      if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET ||
+          read32(data + candidate) != sequence) {
+        pos++;
+        continue;
+      }
+
+      size_t matchLength = LZ_MIN_MATCH;
+      while (pos + matchLength < limit &&
+             data[candidate + matchLength] == data[pos + matchLength]) {
+        matchLength++;
+      }
+
+      emitSequence(data + anchor, pos - anchor, pos - candidate, matchLength,
+                   output);
+
+      pos += matchLength;
+      anchor = pos;
+    }
+  }
+
+  emitSequence(data + anchor, size - anchor, 0, 0, output);
+  return output;
+}
+
+std::vector<uint8_t> lzDecompress(const uint8_t *data, size_t size,
+                                  size_t originalSize) {
+  std::vector<uint8_t> output;
+  output.reserve(originalSize);
+
+  size_t pos = 0;
+  while (pos < size) {
+    uint8_t token = data[pos++];
+
+    size_t literalLength = token >> 4;
+    if (literalLength == 15) {
+      literalLength += readLength(data, size, pos);
+    }
+    if (pos + literalLength > size ||
+        output.size() + literalLength > originalSize) {
+      throw std::runtime_error("LZ decode: literals out of range");
+    }
+    output.insert(output.end(), data + pos, data + pos + literalLength);
+    pos += literalLength;
+
+    if (pos >= size) {
+      break;
+    }
+
+    if (pos + 2 > size) {
+      throw std::runtime_error("LZ decode: truncated offset");
+    }
+    size_t offset = data[pos] | (static_cast<size_t>(data[pos + 1]) << 8);
+    pos += 2;
+
+    size_t matchLength = (token & 0x0F);
+    if (matchLength == 15) {
+      matchLength += readLength(data, size, pos);
+    }
+    matchLength += LZ_MIN_MATCH;
+
+    if (offset == 0 || offset > output.size() ||
+        output.size() + matchLength > originalSize) {
+      throw std::runtime_error("LZ decode: match out of range");
+    }
+
+    size_t from = output.size() - offset;
+    for (size_t i = 0; i < matchLength; ++i) {
+      output.push_back(output[from + i]);
+    }
+  }
+
+  if (output.size() != originalSize) {
+    throw std::runtime_error("LZ decode: size mismatch");
+  }
+
+  return output;
+}
+
 } // namespace CompressionUtils
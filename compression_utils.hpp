@@ -1,6 +1,7 @@
 #ifndef COMPRESSION_UTILS_HPP
 #define COMPRESSION_UTILS_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -71,6 +72,35 @@ size_t estimateCompressedSize(const std::vector<std::pair<int, int>> &postings);
  */
 bool validateCompressedData(const std::vector<uint8_t> &data);
 
+/**
+ * @brief Считает число записей в сжатом posting list без распаковки
+ * @param data Сжатые данные
+ * @return Документная частота термина
+ */
+size_t countPostings(const std::vector<uint8_t> &data);
+
+// ============================================================================
+// LZ block compression
+// ============================================================================
+
+/**
+ * @brief Сжимает блок байтов алгоритмом семейства LZ77 (формат в духе LZ4)
+ * @param data Исходные данные
+ * @param size Размер исходных данных
+ * @return Сжатый блок
+ */
+std::vector<uint8_t> lzCompress(const uint8_t *data, size_t size);
+
+/**
+ * @brief Распаковывает блок, сжатый lzCompress
+ * @param data Сжатые данные
+ * @param size Размер сжатых данных
+ * @param originalSize Размер исходных данных
+ * @return Распакованный блок
+ */
+std::vector<uint8_t> lzDecompress(const uint8_t *data, size_t size,
+                                  size_t originalSize);
+
 } // namespace CompressionUtils
 
 #endif // COMPRESSION_UTILS_HPP
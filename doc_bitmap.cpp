@@ -0,0 +1,436 @@
+#include "doc_bitmap.hpp"
+#include "posting_iterator.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+inline size_t popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_popcountll(word));
+#else
+  size_t count = 0;
+  while (word) {
+    word &= word - 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+inline bool testBit(const std::vector<uint64_t> &bits, uint16_t low) {
+  return (bits[low >> 6] >> (low & 63)) & 1;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Container
+// ----------------------------------------------------------------------------
+
+bool DocBitmap::Container::contains(uint16_t low) const {
+  if (isBitmap()) {
+    return testBit(bits, low);
+  }
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+void DocBitmap::Container::add(uint16_t low) {
+  if (isBitmap()) {
+    uint64_t mask = uint64_t(1) << (low & 63);
+    if (!(bits[low >> 6] & mask)) {
+      bits[low >> 6] |= mask;
+      cardinality++;
+    }
+    return;
+  }
+
+  if (array.empty() || array.back() < low) {
+    array.push_back(low);
+  } else {
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (*it == low) {
+      return;
+    }
+    array.insert(it, low);
+  }
+  cardinality++;
+
+  if (array.size() > ARRAY_LIMIT) {
+    toBitmap();
+  }
+}
+
+void DocBitmap::Container::toBitmap() {
+  if (isBitmap()) {
+    return;
+  }
+  bits.assign(BITMAP_WORDS, 0);
+  for (uint16_t low : array) {
+    bits[low >> 6] |= uint64_t(1) << (low & 63);
+  }
+  array.clear();
+  array.shrink_to_fit();
+}
+
+void DocBitmap::Container::optimize() {
+  if (!isBitmap() || cardinality > ARRAY_LIMIT) {
+    return;
+  }
+  array.reserve(cardinality);
+  for (size_t word = 0; word < BITMAP_WORDS; ++word) {
+    uint64_t value = bits[word];
+    while (value) {
+      size_t bit = popcount64((value & -value) - 1);
+      array.push_back(static_cast<uint16_t>(word * 64 + bit));
+      value &= value - 1;
+    }
+  }
+  bits.clear();
+  bits.shrink_to_fit();
+}
+
+DocBitmap::Container DocBitmap::intersect(const Container &a,
+                                          const Container &b) {
+  Container result;
+  result.key = a.key;
+
+  if (a.isBitmap() && b.isBitmap()) {
+    result.bits.resize(BITMAP_WORDS);
+    for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+      result.bits[i] = a.bits[i] & b.bits[i];
+      result.cardinality += popcount64(result.bits[i]);
+    }
+    result.optimize();
+  } else if (a.isBitmap() || b.isBitmap()) {
+    const Container &array = a.isBitmap() ? b : a;
+    const Container &bitmap = a.isBitmap() ? a : b;
+    for (uint16_t low : array.array) {
+      if (testBit(bitmap.bits, low)) {
+        result.array.push_back(low);
+      }
+    }
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+  } else {
+    std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(),
+                          b.array.end(), std::back_inserter(result.array));
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+  }
+
+  return result;
+}
+
+DocBitmap::Container DocBitmap::unite(const Container &a, const Container &b) {
+  Container result;
+  result.key = a.key;
+
+  if (!a.isBitmap() && !b.isBitmap() &&
+      a.array.size() + b.array.size() <= ARRAY_LIMIT) {
+    std::set_union(a.array.begin(), a.array.end(), b.array.begin(),
+                   b.array.end(), std::back_inserter(result.array));
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+    return result;
+  }
+
+  Container left = a;
+  Container right = b;
+  left.toBitmap();
+  right.toBitmap();
+
+  result.bits.resize(BITMAP_WORDS);
+  for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+    result.bits[i] = left.bits[i] | right.bits[i];
+    result.cardinality += popcount64(result.bits[i]);
+  }
+  result.optimize();
+  return result;
+}
+
+DocBitmap::Container DocBitmap::subtract(const Container &a,
+                                         const Container &b) {
+  Container result;
+  result.key = a.key;
+
+  if (a.isBitmap()) {
+    result.bits = a.bits;
+    if (b.isBitmap()) {
+      for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+        result.bits[i] &= ~b.bits[i];
+      }
+    } else {
+      for (uint16_t low : b.array) {
+        result.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+      }
+    }
+    for (uint64_t word : result.bits) {
+      result.cardinality += popcount64(word);
+    }
+    result.optimize();
+  } else if (b.isBitmap()) {
+    for (uint16_t low : a.array) {
+      if (!testBit(b.bits, low)) {
+        result.array.push_back(low);
+      }
+    }
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+  } else {
+    std::set_difference(a.array.begin(), a.array.end(), b.array.begin(),
+                        b.array.end(), std::back_inserter(result.array));
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+  }
+
+  return result;
+}
+
+size_t DocBitmap::intersectCount(const Container &a, const Container &b) {
+  size_t count = 0;
+
+  if (a.isBitmap() && b.isBitmap()) {
+    for (size_t i = 0; i < BITMAP_WORDS; ++i) {
+      count += popcount64(a.bits[i] & b.bits[i]);
+    }
+  } else if (a.isBitmap() || b.isBitmap()) {
+    const Container &array = a.isBitmap() ? b : a;
+    const Container &bitmap = a.isBitmap() ? a : b;
+    for (uint16_t low : array.array) {
+      count += testBit(bitmap.bits, low);
+    }
+  } else {
+    auto i = a.array.begin();
+    auto j = b.array.begin();
+    while (i != a.array.end() && j != b.array.end()) {
+      if (*i < *j) {
+        ++i;
+      } else if (*j < *i) {
+        ++j;
+      } else {
+        ++count;
+        ++i;
+        ++j;
+      }
+    }
+  }
+
+  return count;
+}
+
+// ----------------------------------------------------------------------------
+// DocBitmap
+// ----------------------------------------------------------------------------
+
+DocBitmap DocBitmap::fromPostings(const std::vector<uint8_t> &postings) {
+  DocBitmap bitmap;
+  PostingIterator it(&postings);
+
+  while (it.next() != PostingIterator::NO_MORE_DOCS) {
+    bitmap.add(static_cast<uint32_t>(it.docId()));
+  }
+  return bitmap;
+}
+
+DocBitmap::Container *DocBitmap::findContainer(uint16_t key) {
+  auto it = std::lower_bound(
+      m_containers.begin(), m_containers.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+  return it != m_containers.end() && it->key == key ? &*it : nullptr;
+}
+
+const DocBitmap::Container *DocBitmap::findContainer(uint16_t key) const {
+  auto it = std::lower_bound(
+      m_containers.begin(), m_containers.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+  return it != m_containers.end() && it->key == key ? &*it : nullptr;
+}
+
+void DocBitmap::add(uint32_t docId) {
+  uint16_t key = static_cast<uint16_t>(docId >> 16);
+  uint16_t low = static_cast<uint16_t>(docId & 0xFFFF);
+
+  if (!m_containers.empty() && m_containers.back().key == key) {
+    m_containers.back().add(low);
+    return;
+  }
+
+  Container *container = findContainer(key);
+  if (!container) {
+    Container created;
+    created.key = key;
+    auto it = std::lower_bound(
+        m_containers.begin(), m_containers.end(), key,
+        [](const Container &c, uint16_t k) { return c.key < k; });
+    container = &*m_containers.insert(it, std::move(created));
+  }
+  container->add(low);
+}
+
+bool DocBitmap::contains(uint32_t docId) const {
+  const Container *container = findContainer(static_cast<uint16_t>(docId >> 16));
+  return container && container->contains(static_cast<uint16_t>(docId));
+}
+
+size_t DocBitmap::cardinality() const {
+  size_t total = 0;
+  for (const auto &container : m_containers) {
+    total += container.cardinality;
+  }
+  return total;
+}
+
+size_t DocBitmap::memoryUsage() const {
+  size_t total = m_containers.capacity() * sizeof(Container);
+  for (const auto &container : m_containers) {
+    total += container.array.capacity() * sizeof(uint16_t) +
+             container.bits.capacity() * sizeof(uint64_t);
+  }
+  return total;
+}
+
+DocBitmap DocBitmap::operator&(const DocBitmap &other) const {
+  DocBitmap result;
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i < m_containers.size() && j < other.m_containers.size()) {
+    const Container &a = m_containers[i];
+    const Container &b = other.m_containers[j];
+    if (a.key < b.key) {
+      ++i;
+    } else if (b.key < a.key) {
+      ++j;
+    } else {
+      Container merged = intersect(a, b);
+      if (merged.cardinality > 0) {
+        result.m_containers.push_back(std::move(merged));
+      }
+      ++i;
+      ++j;
+    }
+  }
+
+  return result;
+}
+
+DocBitmap DocBitmap::operator|(const DocBitmap &other) const {
+  DocBitmap result;
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i < m_containers.size() || j < other.m_containers.size()) {
+    if (j == other.m_containers.size() ||
+        (i < m_containers.size() &&
+         m_containers[i].key < other.m_containers[j].key)) {
+      result.m_containers.push_back(m_containers[i++]);
+    } else if (i == m_containers.size() ||
+               other.m_containers[j].key < m_containers[i].key) {
+      result.m_containers.push_back(other.m_containers[j++]);
+    } else {
+      result.m_containers.push_back(
+          unite(m_containers[i++], other.m_containers[j++]));
+    }
+  }
+
+  return result;
+}
+
+DocBitmap DocBitmap::andNot(const DocBitmap &other) const {
+  DocBitmap result;
+  size_t j = 0;
+
+  for (const auto &container : m_containers) {
+    while (j < other.m_containers.size() &&
+           other.m_containers[j].key < container.key) {
+      ++j;
+    }
+
+    if (j < other.m_containers.size() &&
+        other.m_containers[j].key == container.key) {
+      Container remaining = subtract(container, other.m_containers[j]);
+      if (remaining.cardinality > 0) {
+        result.m_containers.push_back(std::move(remaining));
+      }
+    } else {
+      result.m_containers.push_back(container);
+    }
+  }
+
+  return result;
+}
+
+size_t DocBitmap::andCardinality(const DocBitmap &other) const {
+  size_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i < m_containers.size() && j < other.m_containers.size()) {
+    if (m_containers[i].key < other.m_containers[j].key) {
+      ++i;
+    } else if (other.m_containers[j].key < m_containers[i].key) {
+      ++j;
+    } else {
+      count += intersectCount(m_containers[i++], other.m_containers[j++]);
+    }
+  }
+
+  return count;
+}
+
+std::vector<uint32_t> DocBitmap::toVector() const {
+  std::vector<uint32_t> result;
+  result.reserve(cardinality());
+
+  for (const auto &container : m_containers) {
+    uint32_t high = static_cast<uint32_t>(container.key) << 16;
+    if (container.isBitmap()) {
+      for (size_t word = 0; word < BITMAP_WORDS; ++word) {
+        uint64_t value = container.bits[word];
+        while (value) {
+          size_t bit = popcount64((value & -value) - 1);
+          result.push_back(high | static_cast<uint32_t>(word * 64 + bit));
+          value &= value - 1;
+        }
+      }
+    } else {
+      for (uint16_t low : container.array) {
+        result.push_back(high | low);
+      }
+    }
+  }
+
+  return result;
+}
+
+uint32_t DocBitmap::nextSetBit(uint32_t from) const {
+  uint16_t key = static_cast<uint16_t>(from >> 16);
+  auto it = std::lower_bound(
+      m_containers.begin(), m_containers.end(), key,
+      [](const Container &c, uint16_t k) { return c.key < k; });
+
+  for (; it != m_containers.end(); ++it) {
+    uint32_t high = static_cast<uint32_t>(it->key) << 16;
+    uint32_t low = it->key == key ? (from & 0xFFFF) : 0;
+
+    if (it->isBitmap()) {
+      size_t word = low >> 6;
+      uint64_t value = it->bits[word] & (~uint64_t(0) << (low & 63));
+      while (true) {
+        if (value) {
+          size_t bit = popcount64((value & -value) - 1);
+          return high | static_cast<uint32_t>(word * 64 + bit);
+        }
+        if (++word == BITMAP_WORDS) {
+          break;
+        }
+        value = it->bits[word];
+      }
+    } else {
+      auto pos = std::lower_bound(it->array.begin(), it->array.end(),
+                                  static_cast<uint16_t>(low));
+      if (pos != it->array.end()) {
+        return high | *pos;
+      }
+    }
+  }
+
+  return UINT32_MAX;
+}
@@ -0,0 +1,82 @@
+#ifndef DOC_BITMAP_HPP
+#define DOC_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// DocBitmap
+// ============================================================================
+
+/**
+ * @brief Сжатое множество docId в духе Roaring
+ *
+ * Пространство docId делится на фрагменты по 65536 значений. Разреженный
+ * фрагмент (до 4096 элементов) хранится отсортированным массивом uint16,
+ * плотный — битовой картой из 1024 слов, мощность которой считается
+ * popcount. Пересечение, объединение и разность выполняются
+ * пофрагментно, выбирая алгоритм по типам контейнеров.
+ */
+class DocBitmap {
+public:
+  DocBitmap() = default;
+
+  /**
+   * @brief Строит множество из сжатого posting list
+   */
+  static DocBitmap fromPostings(const std::vector<uint8_t> &postings);
+
+  void add(uint32_t docId);
+  bool contains(uint32_t docId) const;
+
+  bool empty() const { return m_containers.empty(); }
+  size_t cardinality() const;
+  size_t memoryUsage() const;
+
+  DocBitmap operator&(const DocBitmap &other) const;
+  DocBitmap operator|(const DocBitmap &other) const;
+  DocBitmap andNot(const DocBitmap &other) const;
+
+  /**
+   * @brief Мощность пересечения без построения результата
+   */
+  size_t andCardinality(const DocBitmap &other) const;
+
+  std::vector<uint32_t> toVector() const;
+
+  /**
+   * @brief Наименьший элемент, не меньший from
+   * @return Элемент или UINT32_MAX, если таких нет
+   */
+  uint32_t nextSetBit(uint32_t from) const;
+
+private:
+  static constexpr size_t ARRAY_LIMIT = 4096;
+  static constexpr size_t BITMAP_WORDS = 1024;
+
+  struct Container {
+    uint16_t key = 0;
+    uint32_t cardinality = 0;
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> bits;
+
+    bool isBitmap() const { return !bits.empty(); }
+    bool contains(uint16_t low) const;
+    void add(uint16_t low);
+    void toBitmap();
+    void optimize();
+  };
+
+  static Container intersect(const Container &a, const Container &b);
+  static Container unite(const Container &a, const Container &b);
+  static Container subtract(const Container &a, const Container &b);
+  static size_t intersectCount(const Container &a, const Container &b);
+
+  Container *findContainer(uint16_t key);
+  const Container *findContainer(uint16_t key) const;
+
+  std::vector<Container> m_containers;
+};
+
+#endif // DOC_BITMAP_HPP
@@ -0,0 +1,138 @@
+#include "doc_reorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+class Bisection {
+public:
+  Bisection(const std::vector<std::vector<uint32_t>> &forward,
+            size_t termCount, int iterations, size_t minPartition)
+      : m_forward(forward), m_iterations(iterations),
+        m_minPartition(std::max<size_t>(minPartition, 2)),
+        m_left(termCount, 0), m_right(termCount, 0) {}
+
+  void run(uint32_t *begin, uint32_t *end) {
+    size_t size = end - begin;
+    if (size <= m_minPartition) {
+      return;
+    }
+
+    uint32_t *middle = begin + size / 2;
+    for (int iteration = 0; iteration < m_iterations; ++iteration) {
+      if (!swapRound(begin, middle, end)) {
+        break;
+      }
+    }
+
+    run(begin, middle);
+    run(middle, end);
+  }
+
+private:
+  // Оценка битов на термин с a документами в левой части и b в правой
+  double cost(int a, int b) const {
+    return a * std::log2(m_leftSize / (a + 1.0)) +
+           b * std::log2(m_rightSize / (b + 1.0));
+  }
+
+  bool swapRound(uint32_t *begin, uint32_t *middle, uint32_t *end) {
+    m_leftSize = static_cast<double>(middle - begin);
+    m_rightSize = static_cast<double>(end - middle);
+
+    for (uint32_t *doc = begin; doc != end; ++doc) {
+      for (uint32_t term : m_forward[*doc]) {
+        (doc < middle ? m_left : m_right)[term]++;
+      }
+    }
+
+    // Выигрыш от переноса документа в другую часть
+    auto gain = [this](uint32_t doc, bool fromLeft) {
+      double total = 0.0;
+      for (uint32_t term : m_forward[doc]) {
+        int a = m_left[term];
+        int b = m_right[term];
+        total += fromLeft ? cost(a, b) - cost(a - 1, b + 1)
+                          : cost(a, b) - cost(a + 1, b - 1);
+      }
+      return total;
+    };
+
+    std::vector<std::pair<double, uint32_t *>> leftGains;
+    std::vector<std::pair<double, uint32_t *>> rightGains;
+    for (uint32_t *doc = begin; doc != middle; ++doc) {
+      leftGains.emplace_back(gain(*doc, true), doc);
+    }
+    for (uint32_t *doc = middle; doc != end; ++doc) {
+      rightGains.emplace_back(gain(*doc, false), doc);
+    }
+
+    auto byGain = [](const auto &a, const auto &b) {
+      return a.first > b.first;
+    };
+    std::sort(leftGains.begin(), leftGains.end(), byGain);
+    std::sort(rightGains.begin(), rightGains.end(), byGain);
+
+    bool swapped = false;
+    for (size_t i = 0; i < leftGains.size() && i < rightGains.size(); ++i) {
+      if (leftGains[i].first + rightGains[i].first <= 0.0) {
+        break;
+      }
+      std::swap(*leftGains[i].second, *rightGains[i].second);
+      swapped = true;
+    }
+
+    for (uint32_t *doc = begin; doc != end; ++doc) {
+      for (uint32_t term : m_forward[*doc]) {
+        m_left[term] = 0;
+        m_right[term] = 0;
+      }
+    }
+    return swapped;
+  }
+
+  const std::vector<std::vector<uint32_t>> &m_forward;
+  int m_iterations;
+  size_t m_minPartition;
+  std::vector<int> m_left;
+  std::vector<int> m_right;
+  double m_leftSize = 0.0;
+  double m_rightSize = 0.0;
+};
+
+} // namespace
+
+namespace DocReorder {
+
+std::vector<uint32_t>
+graphBisection(const std::vector<std::vector<uint32_t>> &forward,
+               size_t termCount, int iterations, size_t minPartition) {
+  std::vector<uint32_t> order(forward.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  if (!order.empty()) {
+    Bisection(forward, termCount, iterations, minPartition)
+        .run(order.data(), order.data() + order.size());
+  }
+  return order;
+}
+
+double logGapCost(const std::vector<std::vector<uint32_t>> &forward,
+                  const std::vector<uint32_t> &order, size_t termCount) {
+  std::vector<int64_t> last(termCount, -1);
+  double total = 0.0;
+
+  for (size_t position = 0; position < order.size(); ++position) {
+    for (uint32_t term : forward[order[position]]) {
+      int64_t gap = static_cast<int64_t>(position) - last[term];
+      total += std::log2(static_cast<double>(gap)) + 1.0;
+      last[term] = static_cast<int64_t>(position);
+    }
+  }
+  return total;
+}
+
+} // namespace DocReorder
@@ -0,0 +1,43 @@
+#ifndef DOC_REORDER_HPP
+#define DOC_REORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// DocReorder
+// ============================================================================
+
+namespace DocReorder {
+
+/**
+ * @brief Порядок документов рекурсивной бисекцией графа документ—термин
+ *
+ * Множество документов делится пополам, после чего несколько итераций
+ * меняют местами пары документов с наибольшим выигрышем по оценке длины
+ * логарифмических разностей docId в списках терминов; затем половины
+ * обрабатываются рекурсивно. Похожие документы оказываются рядом, и
+ * разности в delta-VByte становятся короче.
+ *
+ * @param forward Для каждого документа 0..n-1 — id его терминов
+ * @param termCount Число терминов (id меньше termCount)
+ * @param iterations Максимум итераций обменов на одном уровне
+ * @param minPartition Части не больше этого размера не делятся
+ * @return Перестановка: order[новая позиция] = старый номер
+ */
+std::vector<uint32_t>
+graphBisection(const std::vector<std::vector<uint32_t>> &forward,
+               size_t termCount, int iterations = 20,
+               size_t minPartition = 16);
+
+/**
+ * @brief Оценка размера списков в битах по логарифмам средних разностей
+ * при заданном порядке (чем меньше, тем лучше сжатие)
+ */
+double logGapCost(const std::vector<std::vector<uint32_t>> &forward,
+                  const std::vector<uint32_t> &order, size_t termCount);
+
+} // namespace DocReorder
+
+#endif // DOC_REORDER_HPP
@@ -0,0 +1,440 @@
+#include "doc_values.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t DOC_VALUES_MAGIC = 0x31535644; // "DVS1"
+constexpr uint32_t DOC_VALUES_VERSION = 1;
+
+struct DocValuesHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t columnCount;
+  uint32_t reserved;
+};
+
+bool fieldLess(const std::pair<std::string, DocValuesColumn> &entry,
+               const std::string &field) {
+  return entry.first < field;
+}
+
+template <typename T>
+void writeVector(std::ostream &out, const std::vector<T> &v) {
+  uint64_t size = v.size();
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  out.write(reinterpret_cast<const char *>(v.data()), size * sizeof(T));
+}
+
+template <typename T> bool readVector(std::istream &in, std::vector<T> &v) {
+  uint64_t size = 0;
+  if (!in.read(reinterpret_cast<char *>(&size), sizeof(size)) ||
+      size > (1ull << 40) / sizeof(T)) {
+    return false;
+  }
+  v.resize(size);
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(v.data()), size * sizeof(T)));
+}
+
+int bitWidth(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+// Число дней от 1970-01-01 до даты григорианского календаря
+int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t yearOfEra = year - era * 400;
+  int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+bool allDigits(const std::string &text, size_t begin, size_t end) {
+  if (begin >= end) {
+    return false;
+  }
+  for (size_t i = begin; i < end; ++i) {
+    if (!std::isdigit(static_cast<unsigned char>(text[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parseBound(const std::string &text, int64_t now, bool upper,
+                int64_t &value) {
+  if (text.size() == 10 && text[4] == '-' && text[7] == '-' &&
+      allDigits(text, 0, 4) && allDigits(text, 5, 7) &&
+      allDigits(text, 8, 10)) {
+    int64_t month = std::stoll(text.substr(5, 2));
+    int64_t day = std::stoll(text.substr(8, 2));
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+      return false;
+    }
+    value = daysFromCivil(std::stoll(text.substr(0, 4)), month, day) * 86400;
+    if (upper) {
+      value += 86400 - 1;
+    }
+    return true;
+  }
+
+  char unit = text.empty() ? 0 : text.back();
+  if ((unit == 'd' || unit == 'h' || unit == 'm') &&
+      allDigits(text, 0, text.size() - 1) && text.size() < 12) {
+    int64_t seconds = unit == 'd' ? 86400 : unit == 'h' ? 3600 : 60;
+    value = now - std::stoll(text.substr(0, text.size() - 1)) * seconds;
+    return true;
+  }
+
+  size_t digits = !text.empty() && text[0] == '-' ? 1 : 0;
+  if (!allDigits(text, digits, text.size()) || text.size() > 19) {
+    return false;
+  }
+  value = std::stoll(text);
+  return true;
+}
+
+} // namespace
+
+// ============================================================================
+// DocValuesColumn
+// ============================================================================
+
+class DocValuesColumn::RangeIterator : public DocIterator {
+public:
+  RangeIterator(const DocValuesColumn &column, int64_t min, int64_t max)
+      : m_column(column), m_min(min), m_max(max) {}
+
+  int docId() const override { return m_docId; }
+
+  int next() override {
+    return m_docId == NO_MORE_DOCS ? m_docId : advance(m_docId + 1);
+  }
+
+  int advance(int target) override {
+    if (m_docId >= target) {
+      return m_docId;
+    }
+
+    uint32_t doc = static_cast<uint32_t>(std::max(target, 0));
+    const auto &blocks = m_column.m_blocks;
+
+    for (size_t b = doc / BLOCK_SIZE; b < blocks.size(); ++b) {
+      const Block &block = blocks[b];
+      uint32_t first = static_cast<uint32_t>(b) * BLOCK_SIZE;
+      doc = std::max(doc, first);
+
+      if (block.count == 0 || block.max < m_min || block.min > m_max) {
+        continue;
+      }
+      bool whole = block.min >= m_min && block.max <= m_max;
+
+      for (; doc < first + BLOCK_SIZE; ++doc) {
+        if (!m_column.present(doc)) {
+          continue;
+        }
+        if (whole || inRange(block, doc - first)) {
+          m_docId = static_cast<int>(doc);
+          return m_docId;
+        }
+      }
+    }
+
+    m_docId = NO_MORE_DOCS;
+    return m_docId;
+  }
+
+private:
+  bool inRange(const Block &block, uint32_t slot) const {
+    int64_t value = static_cast<int64_t>(static_cast<uint64_t>(block.min) +
+                                         m_column.unpack(block, slot));
+    return value >= m_min && value <= m_max;
+  }
+
+  const DocValuesColumn &m_column;
+  int64_t m_min;
+  int64_t m_max;
+  int m_docId = -1;
+};
+
+void DocValuesColumn::add(int docId, int64_t value) {
+  if (docId <= m_lastDocId) {
+    throw std::invalid_argument("Doc values require increasing docIds");
+  }
+  if (!m_pending.empty() &&
+      static_cast<uint32_t>(docId) / BLOCK_SIZE !=
+          m_pending.front().first / BLOCK_SIZE) {
+    flushBlock();
+  }
+
+  m_pending.emplace_back(static_cast<uint32_t>(docId), value);
+  m_lastDocId = docId;
+}
+
+void DocValuesColumn::finish() {
+  if (!m_pending.empty()) {
+    flushBlock();
+  }
+}
+
+void DocValuesColumn::flushBlock() {
+  size_t index = m_pending.front().first / BLOCK_SIZE;
+  m_blocks.resize(index, Block{0, 0, 0, 0, 0, 0});
+
+  Block block{m_pending.front().second, m_pending.front().second, 0, 0, 0, 0};
+  for (const auto &entry : m_pending) {
+    block.min = std::min(block.min, entry.second);
+    block.max = std::max(block.max, entry.second);
+  }
+
+  int bits = bitWidth(static_cast<uint64_t>(block.max) -
+                      static_cast<uint64_t>(block.min));
+  block.bits = static_cast<uint8_t>(bits);
+  block.count = static_cast<uint16_t>(m_pending.size());
+  block.wordOffset = static_cast<uint32_t>(m_words.size());
+
+  // BLOCK_SIZE значений по bits бит занимают ровно 2 * bits слов
+  m_words.resize(m_words.size() + BLOCK_SIZE * bits / 64, 0);
+  m_present.resize((index + 1) * BLOCK_SIZE / 64, 0);
+
+  for (const auto &entry : m_pending) {
+    uint32_t slot = entry.first % BLOCK_SIZE;
+    uint64_t delta =
+        static_cast<uint64_t>(entry.second) - static_cast<uint64_t>(block.min);
+    m_present[entry.first / 64] |= 1ull << (entry.first % 64);
+
+    if (bits == 0) {
+      continue;
+    }
+    size_t bitPos = static_cast<size_t>(slot) * bits;
+    uint64_t *words = &m_words[block.wordOffset];
+    words[bitPos / 64] |= delta << (bitPos % 64);
+    if (bitPos % 64 + bits > 64) {
+      words[bitPos / 64 + 1] |= delta >> (64 - bitPos % 64);
+    }
+  }
+
+  m_blocks.push_back(block);
+  m_valueCount += m_pending.size();
+  m_pending.clear();
+}
+
+uint64_t DocValuesColumn::unpack(const Block &block, uint32_t slot) const {
+  if (block.bits == 0) {
+    return 0;
+  }
+  size_t bitPos = static_cast<size_t>(slot) * block.bits;
+  const uint64_t *words = &m_words[block.wordOffset];
+
+  uint64_t value = words[bitPos / 64] >> (bitPos % 64);
+  if (bitPos % 64 + block.bits > 64) {
+    value |= words[bitPos / 64 + 1] << (64 - bitPos % 64);
+  }
+  return block.bits == 64 ? value : value & ((1ull << block.bits) - 1);
+}
+
+bool DocValuesColumn::present(uint32_t docId) const {
+  size_t word = docId / 64;
+  return word < m_present.size() && (m_present[word] >> (docId % 64)) & 1;
+}
+
+void DocValuesColumn::clear() {
+  m_blocks.clear();
+  m_words.clear();
+  m_present.clear();
+  m_pending.clear();
+  m_valueCount = 0;
+  m_lastDocId = -1;
+}
+
+size_t DocValuesColumn::memoryUsage() const {
+  return m_blocks.capacity() * sizeof(Block) +
+         (m_words.capacity() + m_present.capacity()) * sizeof(uint64_t);
+}
+
+bool DocValuesColumn::get(int docId, int64_t &value) const {
+  if (docId < 0 || !present(static_cast<uint32_t>(docId))) {
+    return false;
+  }
+  const Block &block = m_blocks[docId / BLOCK_SIZE];
+  value = static_cast<int64_t>(static_cast<uint64_t>(block.min) +
+                               unpack(block, docId % BLOCK_SIZE));
+  return true;
+}
+
+std::unique_ptr<DocIterator> DocValuesColumn::range(int64_t min,
+                                                    int64_t max) const {
+  return std::make_unique<RangeIterator>(*this, min, max);
+}
+
+DocBitmap DocValuesColumn::rangeBitmap(int64_t min, int64_t max) const {
+  DocBitmap result;
+  RangeIterator iterator(*this, min, max);
+  while (iterator.next() != DocIterator::NO_MORE_DOCS) {
+    result.add(static_cast<uint32_t>(iterator.docId()));
+  }
+  return result;
+}
+
+size_t DocValuesColumn::estimateRange(int64_t min, int64_t max) const {
+  size_t total = 0;
+  for (const auto &block : m_blocks) {
+    if (block.count > 0 && block.max >= min && block.min <= max) {
+      total += block.count;
+    }
+  }
+  return total;
+}
+
+void DocValuesColumn::write(std::ostream &out) const {
+  uint64_t valueCount = m_valueCount;
+  out.write(reinterpret_cast<const char *>(&valueCount), sizeof(valueCount));
+  writeVector(out, m_blocks);
+  writeVector(out, m_words);
+  writeVector(out, m_present);
+}
+
+bool DocValuesColumn::read(std::istream &in) {
+  clear();
+
+  uint64_t valueCount = 0;
+  if (!in.read(reinterpret_cast<char *>(&valueCount), sizeof(valueCount)) ||
+      !readVector(in, m_blocks) || !readVector(in, m_words) ||
+      !readVector(in, m_present)) {
+    clear();
+    return false;
+  }
+
+  for (const auto &block : m_blocks) {
+    if (block.count > 0 &&
+        block.wordOffset + BLOCK_SIZE * block.bits / 64 > m_words.size()) {
+      clear();
+      return false;
+    }
+  }
+  if (m_present.size() > m_blocks.size() * BLOCK_SIZE / 64) {
+    clear();
+    return false;
+  }
+
+  m_valueCount = valueCount;
+  m_lastDocId = static_cast<int>(m_blocks.size() * BLOCK_SIZE) - 1;
+  return true;
+}
+
+// ============================================================================
+// DocValues
+// ============================================================================
+
+DocValuesColumn &DocValues::column(const std::string &field) {
+  auto it =
+      std::lower_bound(m_columns.begin(), m_columns.end(), field, fieldLess);
+  if (it == m_columns.end() || it->first != field) {
+    it = m_columns.insert(it, {field, DocValuesColumn()});
+  }
+  return it->second;
+}
+
+const DocValuesColumn *DocValues::find(const std::string &field) const {
+  auto it =
+      std::lower_bound(m_columns.begin(), m_columns.end(), field, fieldLess);
+  return it != m_columns.end() && it->first == field ? &it->second : nullptr;
+}
+
+void DocValues::finish() {
+  for (auto &entry : m_columns) {
+    entry.second.finish();
+  }
+}
+
+std::vector<std::string> DocValues::fields() const {
+  std::vector<std::string> result;
+  for (const auto &entry : m_columns) {
+    result.push_back(entry.first);
+  }
+  return result;
+}
+
+size_t DocValues::memoryUsage() const {
+  size_t total = 0;
+  for (const auto &entry : m_columns) {
+    total += entry.first.capacity() + entry.second.memoryUsage();
+  }
+  return total;
+}
+
+bool DocValues::save(const std::string &filePath) const {
+  std::ofstream file(filePath, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  DocValuesHeader header = {DOC_VALUES_MAGIC, DOC_VALUES_VERSION,
+                            static_cast<uint32_t>(m_columns.size()), 0};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  for (const auto &entry : m_columns) {
+    uint32_t nameLen = static_cast<uint32_t>(entry.first.size());
+    file.write(reinterpret_cast<const char *>(&nameLen), sizeof(nameLen));
+    file.write(entry.first.data(), nameLen);
+    entry.second.write(file);
+  }
+
+  return static_cast<bool>(file);
+}
+
+bool DocValues::load(const std::string &filePath) {
+  clear();
+
+  std::ifstream file(filePath, std::ios::binary);
+  DocValuesHeader header;
+  if (!file.is_open() ||
+      !file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != DOC_VALUES_MAGIC ||
+      header.version != DOC_VALUES_VERSION) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < header.columnCount; ++i) {
+    uint32_t nameLen = 0;
+    if (!file.read(reinterpret_cast<char *>(&nameLen), sizeof(nameLen)) ||
+        nameLen > 1024) {
+      clear();
+      return false;
+    }
+    std::string name(nameLen, '\0');
+    file.read(&name[0], nameLen);
+
+    if (!file || !column(name).read(file)) {
+      clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool parseRangeFilter(const std::string &value, int64_t now, int64_t &min,
+                      int64_t &max) {
+  size_t separator = value.find("..");
+  if (separator == std::string::npos) {
+    return false;
+  }
+
+  std::string lower = value.substr(0, separator);
+  std::string upper = value.substr(separator + 2);
+
+  min = std::numeric_limits<int64_t>::min();
+  max = std::numeric_limits<int64_t>::max();
+
+  return (lower.empty() || parseBound(lower, now, false, min)) &&
+         (upper.empty() || parseBound(upper, now, true, max));
+}
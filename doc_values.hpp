@@ -0,0 +1,138 @@
+#ifndef DOC_VALUES_HPP
+#define DOC_VALUES_HPP
+
+#include "doc_bitmap.hpp"
+#include "query_plan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// DocValuesColumn
+// ============================================================================
+
+/**
+ * @brief Числовой столбец docId -> int64 с блочной битовой упаковкой
+ *
+ * Документы разбиты на блоки по BLOCK_SIZE подряд идущих docId. Для блока
+ * хранятся min, max и ширина в битах; значения записаны как (value - min)
+ * фиксированной ширины, поэтому get() — O(1). Фильтр по диапазону
+ * пропускает блоки, чьи [min, max] не пересекаются с ним, а блоки, целиком
+ * попавшие в диапазон, отдаёт по битовой маске присутствия без распаковки.
+ */
+class DocValuesColumn {
+public:
+  static constexpr uint32_t BLOCK_SIZE = 128;
+
+  /**
+   * @brief Добавляет значение; docId должны идти по возрастанию
+   */
+  void add(int docId, int64_t value);
+
+  /**
+   * @brief Упаковывает незаполненный последний блок
+   */
+  void finish();
+
+  void clear();
+
+  bool empty() const { return m_valueCount == 0 && m_pending.empty(); }
+  size_t valueCount() const { return m_valueCount; }
+  size_t blockCount() const { return m_blocks.size(); }
+  size_t memoryUsage() const;
+
+  /**
+   * @return false, если у документа нет значения
+   */
+  bool get(int docId, int64_t &value) const;
+
+  /**
+   * @brief Итератор по документам со значением в [min, max]
+   */
+  std::unique_ptr<DocIterator> range(int64_t min, int64_t max) const;
+
+  DocBitmap rangeBitmap(int64_t min, int64_t max) const;
+
+  /**
+   * @brief Верхняя оценка числа документов диапазона по статистике блоков
+   */
+  size_t estimateRange(int64_t min, int64_t max) const;
+
+  void write(std::ostream &out) const;
+  bool read(std::istream &in);
+
+private:
+  class RangeIterator;
+
+  struct Block {
+    int64_t min;
+    int64_t max;
+    uint32_t wordOffset;
+    uint16_t count;
+    uint8_t bits;
+    uint8_t reserved;
+  };
+
+  void flushBlock();
+  uint64_t unpack(const Block &block, uint32_t slot) const;
+  bool present(uint32_t docId) const;
+
+  std::vector<Block> m_blocks;
+  std::vector<uint64_t> m_words;
+  std::vector<uint64_t> m_present;
+  std::vector<std::pair<uint32_t, int64_t>> m_pending;
+  size_t m_valueCount = 0;
+  int m_lastDocId = -1;
+};
+
+// ============================================================================
+// DocValues
+// ============================================================================
+
+/**
+ * @brief Набор именованных числовых столбцов индекса
+ */
+class DocValues {
+public:
+  /**
+   * @brief Возвращает столбец, создавая его при необходимости
+   */
+  DocValuesColumn &column(const std::string &field);
+
+  const DocValuesColumn *find(const std::string &field) const;
+
+  void finish();
+  void clear() { m_columns.clear(); }
+
+  bool empty() const { return m_columns.empty(); }
+  std::vector<std::string> fields() const;
+  size_t memoryUsage() const;
+
+  bool save(const std::string &filePath) const;
+  bool load(const std::string &filePath);
+
+private:
+  // Отсортированы по имени поля
+  std::vector<std::pair<std::string, DocValuesColumn>> m_columns;
+};
+
+/**
+ * @brief Разбирает диапазон фильтра вида lo..hi
+ *
+ * Границы необязательны; каждая — целое число, дата ГГГГ-ММ-ДД (UTC,
+ * в секундах; в верхней границе — до конца дня) или давность Nd/Nh/Nm,
+ * означающая момент now - N дней (часов, минут). Так, 7d.. — «за последние
+ * 7 дней».
+ *
+ * @return false, если запись не является диапазоном
+ */
+bool parseRangeFilter(const std::string &value, int64_t now, int64_t &min,
+                      int64_t &max);
+
+#endif // DOC_VALUES_HPP
@@ -0,0 +1,245 @@
+#include "document_store.hpp"
+#include "compression_utils.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t DOC_STORE_MAGIC = 0x31534F44; // "DOS1"
+constexpr uint32_t DOC_STORE_VERSION = 2;
+constexpr uint32_t MISSING_BLOCK = std::numeric_limits<uint32_t>::max();
+
+struct DocStoreHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t indexFingerprint;
+  uint64_t blockSize;
+  uint64_t docTableSize;
+  uint64_t blockCount;
+  uint64_t storedCount;
+  uint64_t rawSize;
+};
+
+} // namespace
+
+DocumentStore::DocumentStore(size_t blockSize) : m_blockSize(blockSize) {}
+
+void DocumentStore::add(int docId, const std::string &text) {
+  if (docId <= m_lastDocId && m_storedCount > 0) {
+    throw std::invalid_argument("Document store requires increasing docIds");
+  }
+  if (m_mapped.isOpen()) {
+    throw std::logic_error("Cannot add documents to a loaded store");
+  }
+
+  if (!m_pending.empty() && m_pending.size() + text.size() > m_blockSize) {
+    flushBlock();
+  }
+
+  if (m_ownedDocs.size() <= static_cast<size_t>(docId)) {
+    m_ownedDocs.resize(docId + 1, DocEntry{MISSING_BLOCK, 0, 0});
+  }
+
+  m_ownedDocs[docId] = {static_cast<uint32_t>(m_ownedBlocks.size()),
+                        static_cast<uint32_t>(m_pending.size()),
+                        static_cast<uint32_t>(text.size())};
+  m_pending += text;
+  m_rawSize += text.size();
+  m_lastDocId = docId;
+  m_storedCount++;
+
+  bindOwned();
+}
+
+void DocumentStore::flushBlock() {
+  if (m_pending.empty()) {
+    return;
+  }
+
+  auto compressed = CompressionUtils::lzCompress(
+      reinterpret_cast<const uint8_t *>(m_pending.data()), m_pending.size());
+
+  m_ownedBlocks.push_back({m_ownedData.size(),
+                           static_cast<uint32_t>(compressed.size()),
+                           static_cast<uint32_t>(m_pending.size())});
+  m_ownedData.insert(m_ownedData.end(), compressed.begin(), compressed.end());
+  m_pending.clear();
+
+  bindOwned();
+}
+
+void DocumentStore::finish() { flushBlock(); }
+
+void DocumentStore::bindOwned() {
+  m_docs = m_ownedDocs.data();
+  m_blocks = m_ownedBlocks.data();
+  m_data = m_ownedData.data();
+  m_docCount = m_ownedDocs.size();
+  m_blockCount = m_ownedBlocks.size();
+}
+
+void DocumentStore::clear() {
+  m_ownedDocs.clear();
+  m_ownedBlocks.clear();
+  m_ownedData.clear();
+  m_pending.clear();
+  m_mapped.close();
+  m_lastDocId = 0;
+  m_rawSize = 0;
+  m_storedCount = 0;
+  m_cachedBlock = -1;
+  m_cache.clear();
+  bindOwned();
+}
+
+size_t DocumentStore::compressedSize() const {
+  size_t total = 0;
+  for (size_t i = 0; i < m_blockCount; ++i) {
+    total += m_blocks[i].compressedSize;
+  }
+  return total;
+}
+
+bool DocumentStore::save(const std::string &filePath,
+                         uint64_t indexFingerprint) {
+  finish();
+
+  // Файл может быть отображён в память этим же объектом: пишем во
+  // временный и заменяем переименованием
+  std::string tmpPath = filePath + ".tmp";
+  std::ofstream file(tmpPath, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  DocStoreHeader header = {DOC_STORE_MAGIC,  DOC_STORE_VERSION,
+                           indexFingerprint, m_blockSize,
+                           m_docCount,       m_blockCount,
+                           m_storedCount,    m_rawSize};
+
+  size_t dataSize = m_blockCount == 0
+                        ? 0
+                        : m_blocks[m_blockCount - 1].offset +
+                              m_blocks[m_blockCount - 1].compressedSize;
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(m_blocks),
+             m_blockCount * sizeof(BlockEntry));
+  file.write(reinterpret_cast<const char *>(m_docs),
+             m_docCount * sizeof(DocEntry));
+  file.write(reinterpret_cast<const char *>(m_data), dataSize);
+
+  file.close();
+  if (!file || std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool DocumentStore::load(const std::string &filePath,
+                         uint64_t indexFingerprint) {
+  clear();
+
+  if (!m_mapped.open(filePath) || m_mapped.size() < sizeof(DocStoreHeader)) {
+    clear();
+    return false;
+  }
+
+  DocStoreHeader header;
+  std::memcpy(&header, m_mapped.data(), sizeof(header));
+
+  size_t tablesSize = sizeof(header) + header.blockCount * sizeof(BlockEntry) +
+                      header.docTableSize * sizeof(DocEntry);
+
+  if (header.magic != DOC_STORE_MAGIC || header.version != DOC_STORE_VERSION ||
+      header.indexFingerprint != indexFingerprint ||
+      m_mapped.size() < tablesSize) {
+    clear();
+    return false;
+  }
+
+  const uint8_t *base = m_mapped.data();
+  m_blocks = reinterpret_cast<const BlockEntry *>(base + sizeof(header));
+  m_docs = reinterpret_cast<const DocEntry *>(
+      base + sizeof(header) + header.blockCount * sizeof(BlockEntry));
+  m_data = base + tablesSize;
+
+  m_blockSize = header.blockSize;
+  m_docCount = header.docTableSize;
+  m_blockCount = header.blockCount;
+  m_storedCount = header.storedCount;
+  m_rawSize = header.rawSize;
+
+  if (m_blockCount > 0 &&
+      tablesSize + m_blocks[m_blockCount - 1].offset +
+              m_blocks[m_blockCount - 1].compressedSize >
+          m_mapped.size()) {
+    clear();
+    return false;
+  }
+
+  return true;
+}
+
+void DocumentStore::renumber(const std::vector<int> &order) {
+  DocumentStore renumbered(m_blockSize);
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (contains(order[i])) {
+      renumbered.add(static_cast<int>(i) + 1, get(order[i]));
+    }
+  }
+  renumbered.finish();
+
+  // Отображённый файл больше не нужен: данные теперь свои
+  clear();
+  m_ownedDocs = std::move(renumbered.m_ownedDocs);
+  m_ownedBlocks = std::move(renumbered.m_ownedBlocks);
+  m_ownedData = std::move(renumbered.m_ownedData);
+  m_lastDocId = renumbered.m_lastDocId;
+  m_rawSize = renumbered.m_rawSize;
+  m_storedCount = renumbered.m_storedCount;
+  bindOwned();
+}
+
+bool DocumentStore::contains(int docId) const {
+  return docId >= 0 && static_cast<size_t>(docId) < m_docCount &&
+         m_docs[docId].block != MISSING_BLOCK;
+}
+
+const std::vector<uint8_t> &DocumentStore::blockData(uint32_t block) const {
+  if (m_cachedBlock != static_cast<int64_t>(block)) {
+    const BlockEntry &entry = m_blocks[block];
+    m_cache = CompressionUtils::lzDecompress(
+        m_data + entry.offset, entry.compressedSize, entry.rawSize);
+    m_cachedBlock = block;
+  }
+  return m_cache;
+}
+
+std::string DocumentStore::get(int docId) const {
+  if (!contains(docId)) {
+    return "";
+  }
+
+  const DocEntry &entry = m_docs[docId];
+
+  if (entry.block >= m_blockCount) {
+    return m_pending.substr(entry.offset, entry.length);
+  }
+
+  // Кеш блока общий для всех читателей
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  const std::vector<uint8_t> &block = blockData(entry.block);
+  if (static_cast<size_t>(entry.offset) + entry.length > block.size()) {
+    return "";
+  }
+
+  return std::string(
+      reinterpret_cast<const char *>(block.data() + entry.offset),
+      entry.length);
+}
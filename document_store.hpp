@@ -0,0 +1,117 @@
+#ifndef DOCUMENT_STORE_HPP
+#define DOCUMENT_STORE_HPP
+
+#include "file_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// DocumentStore
+// ============================================================================
+
+/**
+ * @brief Хранилище текстов документов, сжатых блоками
+ *
+ * Тексты дописываются в порядке docId и склеиваются в блоки размером около
+ * blockSize, каждый из которых сжимается CompressionUtils::lzCompress.
+ * Таблица docId -> (блок, смещение, длина) позволяет получить любой
+ * документ распаковкой одного блока; последний распакованный блок
+ * кешируется под мьютексом, поэтому get() можно вызывать из нескольких
+ * потоков. Сохранённый файл отображается в память; в заголовке хранится
+ * отпечаток индекса, для которого он записан.
+ */
+class DocumentStore {
+public:
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 32 * 1024;
+
+  explicit DocumentStore(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  /**
+   * @brief Добавляет документ; docId должны идти по возрастанию
+   */
+  void add(int docId, const std::string &text);
+
+  /**
+   * @brief Сжимает незаполненный последний блок
+   */
+  void finish();
+
+  void clear();
+
+  /**
+   * @brief Задаёт размер блока для последующих add()
+   */
+  void setBlockSize(size_t blockSize) { m_blockSize = blockSize; }
+
+  bool save(const std::string &filePath, uint64_t indexFingerprint = 0);
+
+  /**
+   * @brief Загружает хранилище
+   * @return false, если файл повреждён или записан для другого индекса
+   */
+  bool load(const std::string &filePath, uint64_t indexFingerprint = 0);
+
+  /**
+   * @brief Перенумеровывает документы: новый docId i + 1 получает документ
+   * order[i]; результат держится в памяти до save()
+   */
+  void renumber(const std::vector<int> &order);
+
+  bool empty() const { return m_storedCount == 0; }
+  size_t documentCount() const { return m_storedCount; }
+  size_t blockCount() const { return m_blockCount; }
+  size_t compressedSize() const;
+  size_t rawSize() const { return m_rawSize; }
+
+  bool contains(int docId) const;
+
+  /**
+   * @brief Возвращает текст документа
+   * @return Пустая строка, если документа нет в хранилище
+   */
+  std::string get(int docId) const;
+
+private:
+  struct DocEntry {
+    uint32_t block;
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  struct BlockEntry {
+    uint64_t offset;
+    uint32_t compressedSize;
+    uint32_t rawSize;
+  };
+
+  void flushBlock();
+  void bindOwned();
+  const std::vector<uint8_t> &blockData(uint32_t block) const;
+
+  size_t m_blockSize;
+
+  std::vector<DocEntry> m_ownedDocs;
+  std::vector<BlockEntry> m_ownedBlocks;
+  std::vector<uint8_t> m_ownedData;
+  std::string m_pending;
+  int m_lastDocId = 0;
+  size_t m_rawSize = 0;
+
+  FileUtils::MappedFile m_mapped;
+  const DocEntry *m_docs = nullptr;
+  const BlockEntry *m_blocks = nullptr;
+  const uint8_t *m_data = nullptr;
+  size_t m_docCount = 0;
+  size_t m_blockCount = 0;
+  size_t m_storedCount = 0;
+
+  mutable std::mutex m_cacheMutex;
+  mutable int64_t m_cachedBlock = -1;
+  mutable std::vector<uint8_t> m_cache;
+};
+
+#endif // DOCUMENT_STORE_HPP
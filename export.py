@@ -8,6 +8,7 @@ from bs4 import BeautifulSoup
 CONFIG_FILE = "config.yaml"
 OUTPUT_DIR = "dataset_txt"
 REGISTRY_FILE = "urls.txt"
+NUMERIC_FIELDS = ["download_timestamp"]
 
 BAD_URL_PATTERNS = [
     "/tegi/", "/tags/", "/category/", "/author/",
@@ -66,7 +67,9 @@ def run_export():
         os.remove(REGISTRY_FILE)
 
     with open(REGISTRY_FILE, "w", encoding="utf-8") as reg:
-        cursor = collection.find({}, {"url": 1, "raw_html": 1})
+        projection = {"url": 1, "raw_html": 1}
+        projection.update({field: 1 for field in NUMERIC_FIELDS})
+        cursor = collection.find({}, projection)
 
         doc_id = 0
         exported_count = 0
@@ -89,7 +92,12 @@ def run_export():
                 with open(filename, "w", encoding="utf-8") as f:
                     f.write(clean_text)
 
-                reg.write(f"{doc_id}\t{url}\n")
+                fields = "".join(
+                    f"\t{field}={int(doc[field])}"
+                    for field in NUMERIC_FIELDS
+                    if isinstance(doc.get(field), (int, float))
+                )
+                reg.write(f"{doc_id}\t{url}{fields}\n")
 
                 doc_id += 1
                 exported_count += 1
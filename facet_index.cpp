@@ -0,0 +1,83 @@
+#include "facet_index.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool valueLess(const std::pair<std::string, DocBitmap> &entry,
+               const std::string &value) {
+  return entry.first < value;
+}
+
+} // namespace
+
+void FacetIndex::add(int docId, const std::string &value) {
+  if (docId < 0 || value.empty()) {
+    return;
+  }
+
+  auto it =
+      std::lower_bound(m_values.begin(), m_values.end(), value, valueLess);
+  if (it == m_values.end() || it->first != value) {
+    it = m_values.insert(it, {value, DocBitmap()});
+  }
+  it->second.add(static_cast<uint32_t>(docId));
+}
+
+void FacetIndex::clear() { m_values.clear(); }
+
+size_t FacetIndex::memoryUsage() const {
+  size_t total = m_values.capacity() * sizeof(m_values[0]);
+  for (const auto &entry : m_values) {
+    total += entry.first.capacity() + entry.second.memoryUsage();
+  }
+  return total;
+}
+
+const DocBitmap *FacetIndex::documents(const std::string &value) const {
+  auto it =
+      std::lower_bound(m_values.begin(), m_values.end(), value, valueLess);
+  return it != m_values.end() && it->first == value ? &it->second : nullptr;
+}
+
+std::vector<FacetIndex::FacetCount>
+FacetIndex::counts(const DocBitmap &results, size_t limit) const {
+  std::vector<FacetCount> counts;
+
+  for (const auto &entry : m_values) {
+    size_t count = results.andCardinality(entry.second);
+    if (count > 0) {
+      counts.push_back({entry.first, count});
+    }
+  }
+
+  std::sort(counts.begin(), counts.end(),
+            [](const FacetCount &a, const FacetCount &b) {
+              return a.count != b.count ? a.count > b.count
+                                        : a.value < b.value;
+            });
+  if (counts.size() > limit) {
+    counts.resize(limit);
+  }
+  return counts;
+}
+
+std::string extractHost(const std::string &url) {
+  size_t begin = url.find("://");
+  begin = begin == std::string::npos ? 0 : begin + 3;
+
+  size_t end = url.find_first_of("/?#", begin);
+  std::string host = TextUtils::toLowerCase(
+      url.substr(begin, end == std::string::npos ? std::string::npos
+                                                  : end - begin));
+
+  size_t at = host.rfind('@');
+  if (at != std::string::npos) {
+    host = host.substr(at + 1);
+  }
+  if (host.compare(0, 4, "www.") == 0) {
+    host = host.substr(4);
+  }
+  return host;
+}
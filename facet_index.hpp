@@ -0,0 +1,61 @@
+#ifndef FACET_INDEX_HPP
+#define FACET_INDEX_HPP
+
+#include "doc_bitmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// FacetIndex
+// ============================================================================
+
+/**
+ * @brief Фасеты по источнику документа: для каждого хоста — DocBitmap
+ *
+ * Хост извлекается из URL один раз при построении, поэтому фильтр site:
+ * и подсчёт фасетов для выдачи сводятся к пересечению битовых множеств
+ * и popcount без разбора URL.
+ */
+class FacetIndex {
+public:
+  struct FacetCount {
+    std::string value;
+    size_t count;
+  };
+
+  void add(int docId, const std::string &value);
+  void clear();
+
+  bool empty() const { return m_values.empty(); }
+  size_t valueCount() const { return m_values.size(); }
+  size_t memoryUsage() const;
+
+  /**
+   * @return Множество документов значения или nullptr
+   */
+  const DocBitmap *documents(const std::string &value) const;
+
+  /**
+   * @brief Считает документы выдачи по каждому значению
+   * @param results Множество документов выдачи
+   * @param limit Максимальное число значений
+   * @return Значения с ненулевым счётчиком по убыванию счётчика
+   */
+  std::vector<FacetCount> counts(const DocBitmap &results, size_t limit) const;
+
+private:
+  // Отсортированы по значению
+  std::vector<std::pair<std::string, DocBitmap>> m_values;
+};
+
+/**
+ * @brief Хост URL без схемы, пути и префикса www., в нижнем регистре
+ * (как get_source_name в main.py)
+ */
+std::string extractHost(const std::string &url);
+
+#endif // FACET_INDEX_HPP
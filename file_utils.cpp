@@ -6,6 +6,14 @@
 #include <cstdlib>
 #include <filesystem>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILE_UTILS_HAVE_MMAP 1
+#endif
+
 namespace fs = std::filesystem;
 
 namespace FileUtils {
@@ -438,4 +446,56 @@ bool moveFile(const std::string &sourcePath, const std::string &destPath) {
   }
 }
 
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &filePath) {
+  close();
+
+#ifdef FILE_UTILS_HAVE_MMAP
+  int fd = ::open(filePath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  m_data = static_cast<const uint8_t *>(addr);
+  m_size = static_cast<size_t>(st.st_size);
+  m_mapped = true;
+  return true;
+#else
+  m_buffer = readBinaryFile(filePath);
+  if (m_buffer.empty()) {
+    return false;
+  }
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+  return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef FILE_UTILS_HAVE_MMAP
+  if (m_mapped && m_data) {
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+  m_buffer.clear();
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+}
+
 } // namespace FileUtils
@@ -1,6 +1,8 @@
 #ifndef FILE_UTILS_H
 #define FILE_UTILS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -25,6 +27,28 @@ bool saveKeyValueFile(const std::string &filePath,
 bool saveKeyValueFile(const std::string &filePath,
                       const std::map<int, int> &data);
 
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool open(const std::string &filePath);
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_mapped = false;
+  std::vector<uint8_t> m_buffer;
+};
+
 }
 
 #endif
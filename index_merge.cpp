@@ -0,0 +1,421 @@
+#include "index_merge.hpp"
+#include "compression_utils.hpp"
+#include "doc_values.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char INDEX_FILE[] = "inverted_index.bin";
+const char LENGTHS_FILE[] = "doc_lengths.txt";
+const char NAMES_FILE[] = "doc_names.txt";
+const char VALUES_FILE[] = "doc_values.bin";
+// Глобальные docId шардов (SearchEngine::setShard) после слияния неверны:
+// без столбца docId слитого индекса сам служит глобальным
+const char GLOBAL_ID_FIELD[] = "global_id";
+// Пишутся слиянием во временные файлы и заменяют прежние вместе
+const char *const OUTPUT_FILES[] = {LENGTHS_FILE, NAMES_FILE, VALUES_FILE,
+                                    INDEX_FILE};
+// Строятся при загрузке; старые копии в каталоге результата не подходят
+const char *const DERIVED_FILES[] = {"spell_index.bin", "doc_store.bin",
+                                     "hot_index.bin", "champions.bin"};
+
+// Последовательное чтение inverted_index.bin: заголовок термина, затем его
+// список порциями
+class PostingsReader {
+public:
+  bool open(const std::string &path, size_t bufferSize) {
+    m_path = path;
+    m_buffer.resize(std::max<size_t>(bufferSize, 1));
+    m_file.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+    m_file.open(path, std::ios::binary);
+    return m_file.is_open();
+  }
+
+  /**
+   * @brief Переходит к следующему термину; список предыдущего должен быть
+   * прочитан целиком
+   */
+  bool next() {
+    uint32_t termLen = 0;
+    if (!m_file.read(reinterpret_cast<char *>(&termLen), sizeof(termLen))) {
+      if (m_file.gcount() > 0) {
+        return fail("truncated term header");
+      }
+      m_done = true;
+      return false;
+    }
+
+    std::string term(termLen, '\0');
+    m_file.read(&term[0], termLen);
+    m_file.read(reinterpret_cast<char *>(&m_remaining), sizeof(m_remaining));
+    if (!m_file) {
+      return fail("truncated term header");
+    }
+    if (m_hasTerm && term <= m_term) {
+      return fail("terms are not sorted, save the index again");
+    }
+
+    m_term = std::move(term);
+    m_hasTerm = true;
+    return true;
+  }
+
+  size_t read(uint8_t *data, size_t size) {
+    size = std::min<size_t>(size, m_remaining);
+    m_file.read(reinterpret_cast<char *>(data), size);
+    size_t count = static_cast<size_t>(m_file.gcount());
+    m_remaining -= static_cast<uint32_t>(count);
+    return count;
+  }
+
+  bool fail(const std::string &error) {
+    m_error = error;
+    m_done = true;
+    return false;
+  }
+
+  bool done() const { return m_done; }
+  const std::string &error() const { return m_error; }
+  const std::string &path() const { return m_path; }
+  const std::string &term() const { return m_term; }
+  uint32_t remaining() const { return m_remaining; }
+
+private:
+  std::string m_path;
+  std::vector<char> m_buffer;
+  std::ifstream m_file;
+  std::string m_term;
+  std::string m_error;
+  uint32_t m_remaining = 0;
+  bool m_hasTerm = false;
+  bool m_done = false;
+};
+
+// Копирует список входа, сдвигая docId на offset. lastDocId — последний
+// docId термина, уже записанный в результат.
+bool appendList(PostingsReader &reader, int offset, int &lastDocId,
+                std::ofstream &out, std::vector<uint8_t> &chunk,
+                uint32_t &written) {
+  if (reader.remaining() == 0) {
+    return true;
+  }
+
+  // Первая разность списка — абсолютный docId входа
+  int docId = 0;
+  int shift = 0;
+  uint8_t byte = 0;
+  do {
+    if (reader.read(&byte, 1) != 1) {
+      return false;
+    }
+    docId |= (byte & 0x7F) << shift;
+    shift += 7;
+  } while (!(byte & 0x80));
+
+  std::vector<uint8_t> head;
+  CompressionUtils::vbyteEncode(docId + offset - lastDocId, head);
+  out.write(reinterpret_cast<const char *>(head.data()), head.size());
+  written += static_cast<uint32_t>(head.size());
+
+  // Остальные байты копируются как есть; разности docId суммируются, чтобы
+  // знать последний docId. После первой разности идёт частота.
+  bool delta = false;
+  int value = 0;
+  shift = 0;
+  while (reader.remaining() > 0) {
+    size_t count = reader.read(chunk.data(), chunk.size());
+    if (count == 0) {
+      return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      value |= (chunk[i] & 0x7F) << shift;
+      shift += 7;
+      if (chunk[i] & 0x80) {
+        if (delta) {
+          docId += value;
+        }
+        delta = !delta;
+        value = 0;
+        shift = 0;
+      }
+    }
+    out.write(reinterpret_cast<const char *>(chunk.data()), count);
+    written += static_cast<uint32_t>(count);
+  }
+
+  lastDocId = docId + offset;
+  return true;
+}
+
+// Наибольший docId и число документов по doc_lengths.txt
+bool scanLengths(const std::string &path, int &maxDocId, size_t &count) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  maxDocId = 0;
+  count = 0;
+  int docId = 0;
+  int length = 0;
+  while (file >> docId >> length) {
+    maxDocId = std::max(maxDocId, docId);
+    count++;
+  }
+  return true;
+}
+
+// Переписывает строки «docId значение» со сдвигом docId
+bool appendShifted(const std::string &path, int offset, std::ofstream &out) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    int docId = 0;
+    if (!(fields >> docId)) {
+      continue;
+    }
+    std::string value;
+    std::getline(fields, value);
+    out << docId + offset << value << "\n";
+  }
+  return true;
+}
+
+std::string tmpPath(const std::string &outputDir, const char *file) {
+  return (fs::path(outputDir) / file).string() + ".tmp";
+}
+
+// Столбцы doc_values.bin (simhash, static_rank, поля реестра) не
+// восстанавливаются из списков: значения переносятся со сдвигом docId.
+// Без столбцов файл outputPath не создаётся
+bool mergeDocValues(const std::vector<std::string> &inputDirs,
+                    const std::vector<int> &offsets,
+                    const std::vector<int> &maxDocIds,
+                    const std::string &outputPath) {
+  std::vector<DocValues> inputs(inputDirs.size());
+  std::set<std::string> fields;
+  for (size_t i = 0; i < inputDirs.size(); ++i) {
+    fs::path path = fs::path(inputDirs[i]) / VALUES_FILE;
+    if (!fs::exists(path)) {
+      std::cerr << "Warning: No doc values in " << inputDirs[i] << "\n";
+      continue;
+    }
+    if (!inputs[i].load(path.string())) {
+      std::cerr << "Error: Cannot load doc values from " << path << "\n";
+      return false;
+    }
+    for (const auto &field : inputs[i].fields()) {
+      if (field != GLOBAL_ID_FIELD) {
+        fields.insert(field);
+      }
+    }
+  }
+
+  if (fields.empty()) {
+    return true;
+  }
+
+  DocValues merged;
+  for (const auto &field : fields) {
+    DocValuesColumn &column = merged.column(field);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const DocValuesColumn *source = inputs[i].find(field);
+      if (!source) {
+        continue;
+      }
+      for (int docId = 1; docId <= maxDocIds[i]; ++docId) {
+        int64_t value = 0;
+        if (source->get(docId, value)) {
+          column.add(docId + offsets[i], value);
+        }
+      }
+    }
+  }
+  merged.finish();
+  return merged.save(outputPath);
+}
+
+} // namespace
+
+namespace IndexMerge {
+
+bool mergeIndexes(const std::vector<std::string> &inputDirs,
+                  const std::string &outputDir, MergeStats &stats,
+                  size_t bufferSize) {
+  stats = MergeStats();
+  stats.inputs = inputDirs.size();
+
+  std::error_code error;
+  fs::create_directories(outputDir, error);
+  for (const auto &input : inputDirs) {
+    if (fs::equivalent(input, outputDir, error)) {
+      std::cerr << "Error: Output directory must differ from inputs\n";
+      return false;
+    }
+  }
+
+  // Сдвиг docId входа — сумма наибольших docId предыдущих входов
+  std::vector<int> offsets;
+  std::vector<int> maxDocIds;
+  int offset = 0;
+  for (const auto &input : inputDirs) {
+    int maxDocId = 0;
+    size_t count = 0;
+    std::string path = (fs::path(input) / LENGTHS_FILE).string();
+    if (!scanLengths(path, maxDocId, count)) {
+      std::cerr << "Error: Cannot load document lengths from " << path
+                << std::endl;
+      return false;
+    }
+    offsets.push_back(offset);
+    maxDocIds.push_back(maxDocId);
+    offset += maxDocId;
+    stats.documents += count;
+  }
+
+  // Результат пишется во временные файлы и заменяет прежний только после
+  // слияния списков: оборванное слияние не оставляет смешанный индекс
+  auto fail = [&]() {
+    for (const char *file : OUTPUT_FILES) {
+      fs::remove(tmpPath(outputDir, file), error);
+    }
+    return false;
+  };
+
+  std::ofstream lengths(tmpPath(outputDir, LENGTHS_FILE));
+  std::ofstream names(tmpPath(outputDir, NAMES_FILE));
+  for (size_t i = 0; i < inputDirs.size(); ++i) {
+    fs::path input(inputDirs[i]);
+    if (!appendShifted((input / LENGTHS_FILE).string(), offsets[i],
+                       lengths)) {
+      std::cerr << "Error: Cannot read " << (input / LENGTHS_FILE) << "\n";
+      return fail();
+    }
+    if (!appendShifted((input / NAMES_FILE).string(), offsets[i], names)) {
+      std::cerr << "Warning: No document names in " << input << "\n";
+    }
+  }
+  lengths.close();
+  names.close();
+  if (!lengths || !names) {
+    std::cerr << "Error: Cannot write metadata to " << outputDir << "\n";
+    return fail();
+  }
+  if (!mergeDocValues(inputDirs, offsets, maxDocIds,
+                      tmpPath(outputDir, VALUES_FILE))) {
+    std::cerr << "Error: Cannot merge doc values into " << outputDir << "\n";
+    return fail();
+  }
+
+  std::vector<std::unique_ptr<PostingsReader>> readers;
+  for (const auto &input : inputDirs) {
+    readers.push_back(std::make_unique<PostingsReader>());
+    std::string path = (fs::path(input) / INDEX_FILE).string();
+    if (!readers.back()->open(path, bufferSize)) {
+      std::cerr << "Error: Cannot load inverted index from " << path
+                << std::endl;
+      return fail();
+    }
+    readers.back()->next();
+  }
+
+  std::string indexTmpPath = tmpPath(outputDir, INDEX_FILE);
+  std::ofstream out(indexTmpPath, std::ios::binary);
+  if (!out.is_open()) {
+    std::cerr << "Error: Cannot create " << indexTmpPath << std::endl;
+    return fail();
+  }
+  std::vector<uint8_t> chunk(std::max<size_t>(bufferSize, 1));
+
+  while (true) {
+    for (const auto &reader : readers) {
+      if (!reader->error().empty()) {
+        std::cerr << "Error: " << reader->path() << ": " << reader->error()
+                  << std::endl;
+        return fail();
+      }
+    }
+
+    // Входов немного: наименьший термин ищется линейным проходом
+    const std::string *smallest = nullptr;
+    for (const auto &reader : readers) {
+      if (!reader->done() && (!smallest || reader->term() < *smallest)) {
+        smallest = &reader->term();
+      }
+    }
+    if (!smallest) {
+      break;
+    }
+    std::string term = *smallest;
+
+    // Длина списка известна после копирования: место под неё заполняется
+    // потом
+    uint32_t termLen = static_cast<uint32_t>(term.size());
+    out.write(reinterpret_cast<const char *>(&termLen), sizeof(termLen));
+    out.write(term.data(), termLen);
+    std::streampos sizePosition = out.tellp();
+    uint32_t written = 0;
+    out.write(reinterpret_cast<const char *>(&written), sizeof(written));
+
+    int lastDocId = 0;
+    for (size_t i = 0; i < readers.size(); ++i) {
+      PostingsReader &reader = *readers[i];
+      if (reader.done() || reader.term() != term) {
+        continue;
+      }
+      if (!appendList(reader, offsets[i], lastDocId, out, chunk, written)) {
+        reader.fail("truncated posting list");
+        break;
+      }
+      reader.next();
+    }
+
+    out.seekp(sizePosition);
+    out.write(reinterpret_cast<const char *>(&written), sizeof(written));
+    out.seekp(0, std::ios::end);
+
+    stats.terms++;
+    stats.postingBytes += written;
+  }
+
+  out.close();
+  if (!out) {
+    std::cerr << "Error: Cannot write " << indexTmpPath << std::endl;
+    return fail();
+  }
+
+  for (const char *file : OUTPUT_FILES) {
+    fs::path target = fs::path(outputDir) / file;
+    std::string source = tmpPath(outputDir, file);
+    if (!fs::exists(source)) {
+      fs::remove(target, error);
+      continue;
+    }
+    fs::rename(source, target, error);
+    if (error) {
+      std::cerr << "Error: Cannot replace " << target << std::endl;
+      return fail();
+    }
+  }
+
+  for (const char *file : DERIVED_FILES) {
+    fs::remove(fs::path(outputDir) / file, error);
+  }
+  return true;
+}
+
+} // namespace IndexMerge
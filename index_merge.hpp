@@ -0,0 +1,49 @@
+#ifndef INDEX_MERGE_HPP
+#define INDEX_MERGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// IndexMerge
+// ============================================================================
+
+namespace IndexMerge {
+
+constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+struct MergeStats {
+  size_t inputs = 0;
+  size_t documents = 0;
+  size_t terms = 0;
+  uint64_t postingBytes = 0;
+};
+
+/**
+ * @brief Сливает независимо построенные индексы в один
+ *
+ * Документы входа i получают docId, сдвинутые на сумму наибольших docId
+ * предыдущих входов. Словари сливаются k-путевым слиянием отсортированных
+ * inverted_index.bin; списки термина копируются по порядку входов без
+ * распаковки — перекодируется только первая разность каждого списка, а
+ * остальные байты проходят через буфер с подсчётом последнего docId.
+ * Память — буфер чтения на вход плюс один буфер копирования.
+ *
+ * Сливаются inverted_index.bin, doc_lengths.txt, doc_names.txt и столбцы
+ * doc_values.bin (значения по docId со сдвигом). Столбец global_id шардов
+ * отбрасывается: глобальным становится docId результата. Остальные
+ * структуры строятся заново при загрузке результата.
+ *
+ * @param inputDirs Каталоги индексов (термины в файлах по возрастанию)
+ * @param outputDir Каталог результата (создаётся, не совпадает со входами)
+ * @param bufferSize Размер буфера на вход
+ */
+bool mergeIndexes(const std::vector<std::string> &inputDirs,
+                  const std::string &outputDir, MergeStats &stats,
+                  size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+} // namespace IndexMerge
+
+#endif // INDEX_MERGE_HPP
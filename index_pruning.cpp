@@ -0,0 +1,116 @@
+#include "index_pruning.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_set>
+
+namespace {
+
+// Непустые списки без оставленных postings сохраняют лучший
+void keepBest(const std::vector<IndexPruning::ScoredList> &lists,
+              std::vector<std::vector<bool>> &keep) {
+  for (size_t term = 0; term < lists.size(); ++term) {
+    const auto &list = lists[term];
+    if (list.empty() ||
+        std::find(keep[term].begin(), keep[term].end(), true) !=
+            keep[term].end()) {
+      continue;
+    }
+    auto best = std::max_element(list.begin(), list.end(),
+                                 [](const auto &a, const auto &b) {
+                                   return a.score < b.score;
+                                 });
+    keep[term][best - list.begin()] = true;
+  }
+}
+
+} // namespace
+
+namespace IndexPruning {
+
+std::vector<std::vector<bool>> termCentric(const std::vector<ScoredList> &lists,
+                                           size_t k, double epsilon) {
+  std::vector<std::vector<bool>> keep;
+  keep.reserve(lists.size());
+  std::vector<double> scores;
+
+  for (const auto &list : lists) {
+    keep.emplace_back(list.size(), true);
+    if (list.size() <= k || k == 0) {
+      continue;
+    }
+
+    scores.clear();
+    for (const auto &posting : list) {
+      scores.push_back(posting.score);
+    }
+    std::nth_element(scores.begin(), scores.begin() + (k - 1), scores.end(),
+                     std::greater<double>());
+    double threshold = epsilon * scores[k - 1];
+
+    for (size_t i = 0; i < list.size(); ++i) {
+      keep.back()[i] = list[i].score >= threshold;
+    }
+  }
+  return keep;
+}
+
+std::vector<std::vector<bool>>
+documentCentric(const std::vector<ScoredList> &lists, double fraction) {
+  struct Contribution {
+    int docId;
+    double score;
+    size_t term;
+    size_t index;
+  };
+
+  std::vector<Contribution> contributions;
+  std::vector<std::vector<bool>> keep;
+  keep.reserve(lists.size());
+  for (size_t term = 0; term < lists.size(); ++term) {
+    keep.emplace_back(lists[term].size(), false);
+    for (size_t i = 0; i < lists[term].size(); ++i) {
+      contributions.push_back(
+          {lists[term][i].docId, lists[term][i].score, term, i});
+    }
+  }
+
+  std::sort(contributions.begin(), contributions.end(),
+            [](const Contribution &a, const Contribution &b) {
+              return a.docId != b.docId ? a.docId < b.docId
+                                        : a.score > b.score;
+            });
+
+  for (size_t begin = 0; begin < contributions.size();) {
+    size_t end = begin;
+    while (end < contributions.size() &&
+           contributions[end].docId == contributions[begin].docId) {
+      ++end;
+    }
+    size_t take = std::min<size_t>(
+        static_cast<size_t>(std::ceil(fraction * (end - begin))), end - begin);
+    for (size_t i = begin; i < begin + take; ++i) {
+      keep[contributions[i].term][contributions[i].index] = true;
+    }
+    begin = end;
+  }
+
+  keepBest(lists, keep);
+  return keep;
+}
+
+double recall(const std::vector<int> &expected, const std::vector<int> &found) {
+  if (expected.empty()) {
+    return 1.0;
+  }
+
+  std::unordered_set<int> foundSet(found.begin(), found.end());
+  size_t hits = 0;
+  for (int docId : expected) {
+    hits += foundSet.count(docId);
+  }
+  return static_cast<double>(hits) / expected.size();
+}
+
+} // namespace IndexPruning
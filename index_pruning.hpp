@@ -0,0 +1,52 @@
+#ifndef INDEX_PRUNING_HPP
+#define INDEX_PRUNING_HPP
+
+#include <cstddef>
+#include <vector>
+
+// ============================================================================
+// IndexPruning
+// ============================================================================
+
+/**
+ * @brief Статическое прореживание инвертированного индекса
+ *
+ * Оба метода получают списки с уже посчитанным вкладом каждого posting в
+ * оценку документа и возвращают маски оставляемых postings; epsilon и
+ * fraction лежат в [0, 1]. В каждом непустом списке остаётся хотя бы один
+ * posting, чтобы термин не пропал из прореженного индекса.
+ */
+namespace IndexPruning {
+
+struct ScoredPosting {
+  int docId;
+  double score;
+};
+
+using ScoredList = std::vector<ScoredPosting>;
+
+/**
+ * @brief Прореживание по термину (Carmel и др.): порог списка —
+ * epsilon * k-я по величине оценка в нём
+ *
+ * Для однословных запросов верхние k документов сохраняются точно.
+ */
+std::vector<std::vector<bool>> termCentric(const std::vector<ScoredList> &lists,
+                                           size_t k, double epsilon);
+
+/**
+ * @brief Прореживание по документу (Büttcher, Clarke): у каждого документа
+ * остаётся доля fraction его терминов с наибольшим вкладом
+ */
+std::vector<std::vector<bool>>
+documentCentric(const std::vector<ScoredList> &lists, double fraction);
+
+/**
+ * @brief Доля документов эталонной выдачи, найденных в проверяемой
+ * @return 1 для пустого эталона
+ */
+double recall(const std::vector<int> &expected, const std::vector<int> &found);
+
+} // namespace IndexPruning
+
+#endif // INDEX_PRUNING_HPP
@@ -0,0 +1,52 @@
+#include "levenshtein_automaton.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+LevenshteinAutomaton::LevenshteinAutomaton(const std::string &word,
+                                           int maxEdits)
+    : m_word(TextUtils::stringToCodes(word)), m_maxEdits(maxEdits) {
+  if (maxEdits < 0 || maxEdits > 2) {
+    throw std::invalid_argument("Levenshtein automaton supports 0-2 edits");
+  }
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::start() const {
+  State state(m_word.size() + 1);
+  uint8_t cap = static_cast<uint8_t>(m_maxEdits + 1);
+
+  for (size_t i = 0; i < state.size(); ++i) {
+    state[i] = static_cast<uint8_t>(std::min<size_t>(i, cap));
+  }
+  return state;
+}
+
+LevenshteinAutomaton::State
+LevenshteinAutomaton::step(const State &state, uint32_t codepoint) const {
+  State next(state.size());
+  uint8_t cap = static_cast<uint8_t>(m_maxEdits + 1);
+
+  next[0] = std::min<uint8_t>(state[0] + 1, cap);
+
+  for (size_t i = 1; i < state.size(); ++i) {
+    uint8_t substitution = state[i - 1] + (m_word[i - 1] == codepoint ? 0 : 1);
+    uint8_t insertion = state[i] + 1;
+    uint8_t deletion = next[i - 1] + 1;
+    next[i] = std::min({substitution, insertion, deletion, cap});
+  }
+
+  return next;
+}
+
+bool LevenshteinAutomaton::isMatch(const State &state) const {
+  return state.back() <= m_maxEdits;
+}
+
+bool LevenshteinAutomaton::canMatch(const State &state) const {
+  return *std::min_element(state.begin(), state.end()) <= m_maxEdits;
+}
+
+int LevenshteinAutomaton::distance(const State &state) const {
+  return state.back();
+}
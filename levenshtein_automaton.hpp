@@ -0,0 +1,55 @@
+#ifndef LEVENSHTEIN_AUTOMATON_HPP
+#define LEVENSHTEIN_AUTOMATON_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// LevenshteinAutomaton
+// ============================================================================
+
+/**
+ * @brief Автомат Левенштейна для слова и допустимого числа правок
+ *
+ * Состояние - строка матрицы редакционного расстояния, обрезанная сверху
+ * значением maxEdits + 1. Переход по символу стоит O(длина слова), поэтому
+ * обход отсортированного словаря переиспользует состояния общих префиксов
+ * и отбрасывает поддеревья, из которых совпадение уже недостижимо.
+ */
+class LevenshteinAutomaton {
+public:
+  using State = std::vector<uint8_t>;
+
+  LevenshteinAutomaton(const std::string &word, int maxEdits);
+
+  State start() const;
+
+  /**
+   * @brief Переход по кодовой точке
+   */
+  State step(const State &state, uint32_t codepoint) const;
+
+  /**
+   * @brief Принимает ли автомат прочитанную строку
+   */
+  bool isMatch(const State &state) const;
+
+  /**
+   * @brief Может ли какое-либо продолжение привести к совпадению
+   */
+  bool canMatch(const State &state) const;
+
+  /**
+   * @brief Расстояние до слова для принимающего состояния
+   */
+  int distance(const State &state) const;
+
+  int maxEdits() const { return m_maxEdits; }
+
+private:
+  std::vector<uint32_t> m_word;
+  int m_maxEdits;
+};
+
+#endif // LEVENSHTEIN_AUTOMATON_HPP
@@ -1,21 +1,270 @@
+#include "index_merge.hpp"
 #include "search_engine.hpp"
+#include "shard_service.hpp"
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 int main(int argc, char *argv[]) {
   std::string configDir = ".";
-
-  if (argc > 1) {
-    configDir = argv[1];
-  }
+  SearchEngine::DocOrder docOrder = SearchEngine::DocOrder::Directory;
+  double staticWeight = 0.0;
+  std::string reorder;
+  SearchEngine::DuplicatePolicy duplicates =
+      SearchEngine::DuplicatePolicy::Keep;
+  std::string prune;
+  double pruneLevel = 0.0;
+  std::string queriesPath;
+  bool hotTier = false;
+  bool fuzzyFallback = false;
+  SearchEngine::ScoringModel scoring = SearchEngine::ScoringModel::TfIdf;
+  size_t partitions = 1;
+  size_t indexThreads = 0;
+  bool directPostings = true;
+  size_t shard = 0;
+  size_t shardCount = 1;
+  SearchEngine::ShardBy shardBy = SearchEngine::ShardBy::DocId;
+  std::string serveSocket;
+  std::vector<std::string> shardSockets;
 
   try {
+    // merge ВЫХОД ВХОД1 ВХОД2 ... — слияние каталогов индексов
+    if (argc > 1 && std::string(argv[1]) == "merge") {
+      if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " merge OUTPUT INPUT...\n";
+        return 1;
+      }
+      std::vector<std::string> inputs(argv + 3, argv + argc);
+      IndexMerge::MergeStats stats;
+      if (!IndexMerge::mergeIndexes(inputs, argv[2], stats)) {
+        return 1;
+      }
+      std::cout << "Merged " << stats.inputs << " indexes: "
+                << stats.documents << " documents, " << stats.terms
+                << " terms, " << stats.postingBytes << " posting bytes\n";
+      return 0;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+
+      if (arg.compare(0, 8, "--order=") == 0) {
+        std::string order = arg.substr(8);
+        if (order == "recency") {
+          docOrder = SearchEngine::DocOrder::Recency;
+        } else if (order == "depth") {
+          docOrder = SearchEngine::DocOrder::UrlDepth;
+        } else if (order == "length") {
+          docOrder = SearchEngine::DocOrder::Length;
+        } else if (order != "directory") {
+          std::cerr << "Unknown document order: " << order << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 10, "--reorder=") == 0) {
+        reorder = arg.substr(10);
+        if (reorder != "url" && reorder != "bisection") {
+          std::cerr << "Unknown reorder method: " << reorder << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 13, "--duplicates=") == 0) {
+        std::string policy = arg.substr(13);
+        if (policy == "skip") {
+          duplicates = SearchEngine::DuplicatePolicy::Skip;
+        } else if (policy == "collapse") {
+          duplicates = SearchEngine::DuplicatePolicy::Collapse;
+        } else if (policy != "keep") {
+          std::cerr << "Unknown duplicate policy: " << policy << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 8, "--prune=") == 0) {
+        // --prune=term[:epsilon] или --prune=doc[:доля терминов]
+        prune = arg.substr(8);
+        size_t colon = prune.find(':');
+        if (colon != std::string::npos) {
+          pruneLevel = std::stod(prune.substr(colon + 1));
+          prune.resize(colon);
+        } else {
+          pruneLevel = prune == "doc" ? 0.3 : 0.5;
+        }
+        if (prune != "term" && prune != "doc") {
+          std::cerr << "Unknown pruning method: " << prune << "\n";
+          return 1;
+        }
+        if (!(pruneLevel >= 0.0 && pruneLevel <= 1.0)) {
+          std::cerr << "Pruning level must be in [0, 1]\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 10, "--queries=") == 0) {
+        queriesPath = arg.substr(10);
+      } else if (arg.compare(0, 10, "--scoring=") == 0) {
+        std::string model = arg.substr(10);
+        if (model == "bm25") {
+          scoring = SearchEngine::ScoringModel::Bm25;
+        } else if (model == "bm25+") {
+          scoring = SearchEngine::ScoringModel::Bm25Plus;
+        } else if (model == "count") {
+          scoring = SearchEngine::ScoringModel::Count;
+        } else if (model != "tfidf") {
+          std::cerr << "Unknown scoring model: " << model << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 13, "--partitions=") == 0) {
+        partitions = std::stoul(arg.substr(13));
+      } else if (arg.compare(0, 16, "--index-threads=") == 0) {
+        indexThreads = std::stoul(arg.substr(16));
+      } else if (arg.compare(0, 11, "--postings=") == 0) {
+        std::string mode = arg.substr(11);
+        if (mode == "pairs") {
+          directPostings = false;
+        } else if (mode != "direct") {
+          std::cerr << "Unknown posting accumulation: " << mode << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 8, "--shard=") == 0) {
+        // --shard=номер/число шардов
+        std::string spec = arg.substr(8);
+        size_t slash = spec.find('/');
+        if (slash == std::string::npos) {
+          std::cerr << "Expected --shard=I/N\n";
+          return 1;
+        }
+        shard = std::stoul(spec.substr(0, slash));
+        shardCount = std::stoul(spec.substr(slash + 1));
+      } else if (arg.compare(0, 11, "--shard-by=") == 0) {
+        std::string by = arg.substr(11);
+        if (by == "hash") {
+          shardBy = SearchEngine::ShardBy::Hash;
+        } else if (by != "docid") {
+          std::cerr << "Unknown shard partitioning: " << by << "\n";
+          return 1;
+        }
+      } else if (arg.compare(0, 8, "--serve=") == 0) {
+        serveSocket = arg.substr(8);
+      } else if (arg.compare(0, 14, "--coordinator=") == 0) {
+        // Сокеты шардов через запятую
+        std::stringstream sockets(arg.substr(14));
+        std::string socket;
+        while (std::getline(sockets, socket, ',')) {
+          if (!socket.empty()) {
+            shardSockets.push_back(socket);
+          }
+        }
+      } else if (arg == "--hot") {
+        hotTier = true;
+      } else if (arg == "--fuzzy-fallback") {
+        fuzzyFallback = true;
+      } else if (arg.compare(0, 16, "--static-weight=") == 0) {
+        staticWeight = std::stod(arg.substr(16));
+      } else {
+        configDir = arg;
+      }
+    }
+
+    // Кластеры дубликатов у каждого шарда свои: выдача и статистика
+    // разошлись бы с единым индексом
+    if ((shardCount > 1 || !serveSocket.empty()) &&
+        duplicates != SearchEngine::DuplicatePolicy::Keep) {
+      std::cerr << "--shard and --serve require --duplicates=keep\n";
+      return 1;
+    }
+
+    if (!shardSockets.empty()) {
+      ShardCoordinator coordinator(shardSockets);
+      if (!coordinator.connect()) {
+        return 1;
+      }
+
+      std::string query;
+      while (std::cout << "Query: " && std::getline(std::cin, query) &&
+             query != "exit") {
+        auto results = coordinator.searchTfIdf(query, 10);
+        for (size_t i = 0; i < results.size(); ++i) {
+          std::cout << i + 1 << ". doc " << results[i].docId << " ("
+                    << results[i].score << ")\n";
+        }
+      }
+      return 0;
+    }
+
     SearchEngine engine(configDir);
+    engine.setDocOrder(docOrder, staticWeight);
+    engine.setDuplicatePolicy(duplicates);
+    engine.setScoringModel(scoring);
+    engine.setFuzzyFallback(fuzzyFallback);
+    engine.setHotTier(hotTier && prune.empty());
+    engine.setQueryPartitions(partitions);
+    engine.setIndexThreads(indexThreads);
+    engine.setDirectPostings(directPostings);
+    engine.setShard(shard, shardCount, shardBy);
 
     if (!engine.initialize()) {
       std::cerr << "Failed to initialize search engine.\n";
       return 1;
     }
 
+    if (!reorder.empty()) {
+      if (!engine.loadIndex()) {
+        std::cerr << "No index found. Build it first.\n";
+        return 1;
+      }
+
+      auto stats = engine.reorderDocuments(
+          reorder == "url" ? SearchEngine::ReorderMethod::Url
+                           : SearchEngine::ReorderMethod::GraphBisection);
+      std::cout << "Postings: " << stats.postings << "\n";
+      std::cout << "Bits per posting: " << stats.bitsPerPostingBefore()
+                << " -> " << stats.bitsPerPostingAfter() << "\n";
+      return engine.saveIndex() ? 0 : 1;
+    }
+
+    if (!prune.empty()) {
+      if (!engine.loadIndex()) {
+        std::cerr << "No index found. Build it first.\n";
+        return 1;
+      }
+
+      std::vector<std::string> queries;
+      std::ifstream queriesFile(queriesPath);
+      std::string query;
+      while (std::getline(queriesFile, query)) {
+        if (!query.empty()) {
+          queries.push_back(query);
+        }
+      }
+
+      auto stats = engine.pruneIndex(
+          prune == "term" ? SearchEngine::PruneMethod::TermCentric
+                          : SearchEngine::PruneMethod::DocumentCentric,
+          pruneLevel, queries);
+      std::cout << "Postings: " << stats.postingsBefore << " -> "
+                << stats.postingsAfter << "\n";
+      std::cout << "Bytes: " << stats.bytesBefore << " -> " << stats.bytesAfter
+                << "\n";
+      if (!stats.saved) {
+        return 1;
+      }
+      std::cout << "Recall@10: " << stats.recall << " over " << stats.queries
+                << " queries\n";
+      return 0;
+    }
+
+    if (!serveSocket.empty()) {
+      if (!engine.loadIndex()) {
+        std::cerr << "No index found. Build it first.\n";
+        return 1;
+      }
+
+      ShardServer server(engine, serveSocket);
+      if (!server.listen()) {
+        return 1;
+      }
+      std::cout << "Serving shard on " << serveSocket << "\n";
+      server.serve();
+      return 0;
+    }
+
     engine.run();
 
   } catch (const std::exception &e) {
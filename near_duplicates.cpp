@@ -0,0 +1,121 @@
+#include "near_duplicates.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Финализатор splitmix64: FNV коротких слов плохо перемешивает старшие биты
+uint64_t mix(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+} // namespace
+
+uint64_t simHash(const std::map<std::string, int> &termFrequencies) {
+  int64_t weights[64] = {};
+
+  for (const auto &entry : termFrequencies) {
+    uint64_t hash = mix(TextUtils::wordHash(entry.first));
+    for (int bit = 0; bit < 64; ++bit) {
+      weights[bit] += (hash >> bit) & 1 ? entry.second : -entry.second;
+    }
+  }
+
+  uint64_t fingerprint = 0;
+  for (int bit = 0; bit < 64; ++bit) {
+    if (weights[bit] > 0) {
+      fingerprint |= 1ULL << bit;
+    }
+  }
+  return fingerprint;
+}
+
+int hammingDistance(uint64_t a, uint64_t b) {
+  return __builtin_popcountll(a ^ b);
+}
+
+DuplicateClusters::DuplicateClusters(int maxDistance)
+    : m_maxDistance(std::max(0, std::min(maxDistance, 15))),
+      m_bandCount(static_cast<size_t>(m_maxDistance) + 1),
+      m_bandWidth(64 / m_bandCount) {}
+
+uint32_t DuplicateClusters::bandKey(size_t band, uint64_t fingerprint) const {
+  size_t shift = band * m_bandWidth;
+  size_t width = band + 1 == m_bandCount ? 64 - shift : m_bandWidth;
+  uint64_t bits = fingerprint >> shift;
+  if (width < 64) {
+    bits &= (1ULL << width) - 1;
+  }
+  // Старшие 4 бита ключа — номер полосы, полоса шире 28 бит хешируется
+  return static_cast<uint32_t>(band << 28) |
+         static_cast<uint32_t>(width <= 28 ? bits : bits % 0xFFFFFFB);
+}
+
+int DuplicateClusters::find(uint64_t fingerprint) const {
+  for (size_t band = 0; band < m_bandCount; ++band) {
+    auto it = m_bands.find(bandKey(band, fingerprint));
+    if (it == m_bands.end()) {
+      continue;
+    }
+    for (const auto &candidate : it->second) {
+      if (hammingDistance(candidate.second, fingerprint) <= m_maxDistance) {
+        return candidate.first;
+      }
+    }
+  }
+  return -1;
+}
+
+int DuplicateClusters::add(int docId, uint64_t fingerprint) {
+  int best = find(fingerprint);
+
+  if (best < 0) {
+    for (size_t band = 0; band < m_bandCount; ++band) {
+      m_bands[bandKey(band, fingerprint)].emplace_back(docId, fingerprint);
+    }
+    return docId;
+  }
+
+  m_duplicates.add(static_cast<uint32_t>(docId));
+  m_representatives.emplace_back(static_cast<uint32_t>(docId),
+                                 static_cast<uint32_t>(best));
+  m_clusterSizes[static_cast<uint32_t>(best)]++;
+  return best;
+}
+
+void DuplicateClusters::clear() {
+  m_bands.clear();
+  m_duplicates = DocBitmap();
+  m_representatives.clear();
+  m_clusterSizes.clear();
+}
+
+int DuplicateClusters::representative(int docId) const {
+  if (!isDuplicate(docId)) {
+    return docId;
+  }
+  auto it = std::lower_bound(
+      m_representatives.begin(), m_representatives.end(),
+      std::make_pair(static_cast<uint32_t>(docId), uint32_t(0)));
+  return static_cast<int>(it->second);
+}
+
+size_t DuplicateClusters::clusterSize(int docId) const {
+  auto it = m_clusterSizes.find(static_cast<uint32_t>(docId));
+  return it == m_clusterSizes.end() ? 1 : it->second + 1;
+}
+
+size_t DuplicateClusters::memoryUsage() const {
+  size_t total = m_duplicates.memoryUsage() +
+                 m_representatives.capacity() * sizeof(m_representatives[0]) +
+                 m_clusterSizes.size() * 2 * sizeof(uint32_t);
+  for (const auto &entry : m_bands) {
+    total += sizeof(entry) + entry.second.capacity() * sizeof(entry.second[0]);
+  }
+  return total;
+}
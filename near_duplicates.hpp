@@ -0,0 +1,87 @@
+#ifndef NEAR_DUPLICATES_HPP
+#define NEAR_DUPLICATES_HPP
+
+#include "doc_bitmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 64-битный SimHash документа: знак суммы ±tf по каждому биту хешей
+ * терминов
+ */
+uint64_t simHash(const std::map<std::string, int> &termFrequencies);
+
+int hammingDistance(uint64_t a, uint64_t b);
+
+// ============================================================================
+// DuplicateClusters
+// ============================================================================
+
+/**
+ * @brief Кластеры почти-дубликатов по SimHash с LSH-разбиением на полосы
+ *
+ * Отпечаток делится на maxDistance + 1 полос; по принципу Дирихле отпечатки
+ * на расстоянии Хэмминга не больше maxDistance совпадают хотя бы в одной
+ * полосе, поэтому кандидаты ищутся по точному совпадению полос. В таблицах
+ * хранятся только представители кластеров (первый документ кластера).
+ * Документы-дубликаты помечены в DocBitmap, а представитель каждого
+ * дубликата лежит в отсортированном по docId массиве.
+ */
+class DuplicateClusters {
+public:
+  static constexpr int DEFAULT_MAX_DISTANCE = 3;
+
+  explicit DuplicateClusters(int maxDistance = DEFAULT_MAX_DISTANCE);
+
+  /**
+   * @return Представитель кластера, похожего на отпечаток, или -1
+   */
+  int find(uint64_t fingerprint) const;
+
+  /**
+   * @brief Добавляет документ; docId должны идти по возрастанию
+   * @return docId представителя кластера (сам docId, если похожих нет)
+   */
+  int add(int docId, uint64_t fingerprint);
+
+  void clear();
+
+  bool isDuplicate(int docId) const {
+    return docId >= 0 && m_duplicates.contains(static_cast<uint32_t>(docId));
+  }
+
+  size_t duplicateCount() const { return m_representatives.size(); }
+
+  /**
+   * @return Представитель кластера документа (сам docId для представителей
+   * и одиночных документов)
+   */
+  int representative(int docId) const;
+
+  /**
+   * @return Число документов в кластере представителя (1 — дубликатов нет)
+   */
+  size_t clusterSize(int docId) const;
+
+  size_t memoryUsage() const;
+
+private:
+  uint32_t bandKey(size_t band, uint64_t fingerprint) const;
+
+  int m_maxDistance;
+  size_t m_bandCount;
+  size_t m_bandWidth;
+  std::unordered_map<uint32_t, std::vector<std::pair<int, uint64_t>>> m_bands;
+  DocBitmap m_duplicates;
+  // (дубликат, представитель) по возрастанию дубликата
+  std::vector<std::pair<uint32_t, uint32_t>> m_representatives;
+  std::unordered_map<uint32_t, uint32_t> m_clusterSizes;
+};
+
+#endif // NEAR_DUPLICATES_HPP
@@ -0,0 +1,175 @@
+#include "ngram_index.hpp"
+#include "compression_utils.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t WORD_BEGIN = 0x02;
+constexpr uint32_t WORD_END = 0x03;
+
+uint64_t packGram(uint32_t a, uint32_t b, uint32_t c) {
+  return (static_cast<uint64_t>(a & 0x1FFFFF) << 42) |
+         (static_cast<uint64_t>(b & 0x1FFFFF) << 21) |
+         static_cast<uint64_t>(c & 0x1FFFFF);
+}
+
+void appendGrams(const std::vector<uint32_t> &codes,
+                 std::vector<uint64_t> &grams) {
+  for (size_t i = 0; i + 3 <= codes.size(); ++i) {
+    grams.push_back(packGram(codes[i], codes[i + 1], codes[i + 2]));
+  }
+}
+
+std::vector<uint32_t> intersectSorted(const std::vector<uint32_t> &a,
+                                      const std::vector<uint32_t> &b) {
+  std::vector<uint32_t> result;
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(result));
+  return result;
+}
+
+} // namespace
+
+void NgramIndex::build(const TermDictionary &dictionary) {
+  clear();
+
+  std::vector<std::pair<uint64_t, uint32_t>> pairs;
+  std::vector<uint64_t> grams;
+
+  dictionary.forEach(
+      0, dictionary.size(), [&](size_t id, const std::string &term) {
+        std::vector<uint32_t> padded = {WORD_BEGIN};
+        auto codes = TextUtils::stringToCodes(term);
+        padded.insert(padded.end(), codes.begin(), codes.end());
+        padded.push_back(WORD_END);
+
+        grams.clear();
+        appendGrams(padded, grams);
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+        for (uint64_t gram : grams) {
+          pairs.emplace_back(gram, static_cast<uint32_t>(id));
+        }
+        return true;
+      });
+
+  std::sort(pairs.begin(), pairs.end());
+
+  uint32_t lastId = 0;
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    if (i == 0 || pairs[i].first != pairs[i - 1].first) {
+      m_keys.push_back(pairs[i].first);
+      m_offsets.push_back(static_cast<uint32_t>(m_postings.size()));
+      lastId = 0;
+    }
+    CompressionUtils::vbyteEncode(static_cast<int>(pairs[i].second - lastId),
+                                  m_postings);
+    lastId = pairs[i].second;
+  }
+  m_offsets.push_back(static_cast<uint32_t>(m_postings.size()));
+
+  m_keys.shrink_to_fit();
+  m_offsets.shrink_to_fit();
+  m_postings.shrink_to_fit();
+}
+
+void NgramIndex::clear() {
+  m_keys.clear();
+  m_offsets.clear();
+  m_postings.clear();
+}
+
+size_t NgramIndex::memoryUsage() const {
+  return m_keys.capacity() * sizeof(uint64_t) +
+         m_offsets.capacity() * sizeof(uint32_t) + m_postings.capacity();
+}
+
+std::vector<uint32_t> NgramIndex::decodeList(size_t index) const {
+  std::vector<uint32_t> ids;
+  size_t offset = m_offsets[index];
+  size_t end = m_offsets[index + 1];
+  uint32_t id = 0;
+
+  while (offset < end) {
+    id += CompressionUtils::vbyteDecode(m_postings, offset);
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+bool NgramIndex::candidates(const std::string &pattern,
+                            std::vector<uint32_t> &candidates) const {
+  candidates.clear();
+
+  std::vector<uint32_t> codes = TextUtils::stringToCodes(pattern);
+  std::vector<uint64_t> grams;
+  std::vector<uint32_t> segment;
+
+  if (codes.empty() || (codes.front() != '*' && codes.front() != '?')) {
+    segment.push_back(WORD_BEGIN);
+  }
+
+  for (uint32_t code : codes) {
+    if (code == '*' || code == '?') {
+      appendGrams(segment, grams);
+      segment.clear();
+    } else {
+      segment.push_back(code);
+    }
+  }
+  if (codes.empty() || (codes.back() != '*' && codes.back() != '?')) {
+    segment.push_back(WORD_END);
+  }
+  appendGrams(segment, grams);
+
+  if (grams.empty() || m_keys.empty()) {
+    return false;
+  }
+
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+  std::vector<size_t> lists;
+  for (uint64_t gram : grams) {
+    auto it = std::lower_bound(m_keys.begin(), m_keys.end(), gram);
+    if (it == m_keys.end() || *it != gram) {
+      return true;
+    }
+    lists.push_back(it - m_keys.begin());
+  }
+
+  std::sort(lists.begin(), lists.end(), [this](size_t a, size_t b) {
+    return m_offsets[a + 1] - m_offsets[a] < m_offsets[b + 1] - m_offsets[b];
+  });
+
+  candidates = decodeList(lists[0]);
+  for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+    candidates = intersectSorted(candidates, decodeList(lists[i]));
+  }
+
+  return true;
+}
+
+bool NgramIndex::matchWildcard(const std::string &pattern,
+                               const TermDictionary &dictionary, size_t limit,
+                               std::vector<size_t> &ids) const {
+  std::vector<uint32_t> found;
+  if (!candidates(pattern, found)) {
+    return false;
+  }
+
+  std::vector<size_t> matching;
+  for (uint32_t id : found) {
+    if (id < dictionary.size() &&
+        wildcardMatch(pattern, dictionary.term(id))) {
+      matching.push_back(id);
+    }
+  }
+
+  ids = dictionary.mostFrequent(matching, limit);
+  return true;
+}
@@ -0,0 +1,64 @@
+#ifndef NGRAM_INDEX_HPP
+#define NGRAM_INDEX_HPP
+
+#include "term_dictionary.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// NgramIndex
+// ============================================================================
+
+/**
+ * @brief Триграммный индекс над словарём терминов
+ *
+ * Каждый термин дополняется маркерами начала и конца и разбивается на
+ * триграммы кодовых точек. Для каждой триграммы хранится сжатый
+ * (delta + VByte) список идентификаторов терминов. Шаблон с ведущим '*'
+ * раскрывается пересечением списков триграмм его литеральных частей и
+ * последующей проверкой только отобранных строк словаря.
+ */
+class NgramIndex {
+public:
+  void build(const TermDictionary &dictionary);
+  void clear();
+
+  bool empty() const { return m_keys.empty(); }
+  size_t gramCount() const { return m_keys.size(); }
+  size_t memoryUsage() const;
+
+  /**
+   * @brief Кандидаты для шаблона по пересечению триграмм
+   * @param pattern Шаблон с '*' и '?'
+   * @param candidates Отсортированные идентификаторы терминов, содержащих все
+   * триграммы шаблона
+   * @return false если в шаблоне нет ни одной полной триграммы и индекс не
+   * может сузить поиск
+   */
+  bool candidates(const std::string &pattern,
+                  std::vector<uint32_t> &candidates) const;
+
+  /**
+   * @brief Раскрывает шаблон через триграммы с проверкой по словарю
+   * @param pattern Шаблон с '*' и '?'
+   * @param dictionary Словарь, по которому построен индекс
+   * @param limit Максимальное число терминов (остаются самые частые)
+   * @param ids Идентификаторы подходящих терминов в порядке словаря
+   * @return false если индекс не может сузить поиск для этого шаблона
+   */
+  bool matchWildcard(const std::string &pattern,
+                     const TermDictionary &dictionary, size_t limit,
+                     std::vector<size_t> &ids) const;
+
+private:
+  std::vector<uint32_t> decodeList(size_t index) const;
+
+  std::vector<uint64_t> m_keys;
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint8_t> m_postings;
+};
+
+#endif // NGRAM_INDEX_HPP
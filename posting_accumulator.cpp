@@ -0,0 +1,126 @@
+#include "posting_accumulator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void PostingAccumulator::add(const std::string &term, int docId,
+                             int frequency) {
+  auto inserted =
+      m_termIds.emplace(term, static_cast<uint32_t>(m_buffers.size()));
+  if (inserted.second) {
+    uint64_t slice = allocate(MIN_SLICE);
+    m_buffers.push_back({static_cast<uint32_t>(slice / ALIGNMENT), slice,
+                         slice + MIN_SLICE - sizeof(uint32_t),
+                         static_cast<uint32_t>(MIN_SLICE), 0, 0});
+  }
+
+  TermBuffer &buffer = m_buffers[inserted.first->second];
+  if (docId <= buffer.lastDocId) {
+    throw std::invalid_argument("Posting accumulator requires increasing "
+                                "docIds per term");
+  }
+  writeVByte(buffer, docId - buffer.lastDocId);
+  writeVByte(buffer, frequency);
+  buffer.lastDocId = docId;
+}
+
+uint64_t PostingAccumulator::allocate(size_t size) {
+  if (m_blockUsed + size > BLOCK_SIZE) {
+    m_blocks.push_back(std::make_unique<uint8_t[]>(BLOCK_SIZE));
+    m_blockUsed = 0;
+  }
+  uint64_t position = (m_blocks.size() - 1) * BLOCK_SIZE + m_blockUsed;
+  m_blockUsed += size;
+  return position;
+}
+
+void PostingAccumulator::writeByte(TermBuffer &buffer, uint8_t byte) {
+  if (buffer.write == buffer.limit) {
+    // Срез заполнен: в его последних байтах — адрес следующего
+    size_t sliceSize = std::min<size_t>(buffer.sliceSize * 2, MAX_SLICE);
+    uint64_t next = allocate(sliceSize);
+    uint32_t link = static_cast<uint32_t>(next / ALIGNMENT);
+    std::memcpy(at(buffer.limit), &link, sizeof(link));
+
+    buffer.write = next;
+    buffer.limit = next + sliceSize - sizeof(uint32_t);
+    buffer.sliceSize = static_cast<uint32_t>(sliceSize);
+  }
+  *at(buffer.write++) = byte;
+  buffer.size++;
+}
+
+void PostingAccumulator::writeVByte(TermBuffer &buffer, int value) {
+  if (value < 0) {
+    throw std::invalid_argument("VByte encoding requires non-negative values");
+  }
+  while (value >= 128) {
+    writeByte(buffer, static_cast<uint8_t>(value & 0x7F));
+    value >>= 7;
+  }
+  writeByte(buffer, static_cast<uint8_t>(value | 0x80));
+}
+
+std::vector<uint8_t> PostingAccumulator::read(const TermBuffer &buffer) const {
+  std::vector<uint8_t> data(buffer.size);
+
+  uint64_t position = static_cast<uint64_t>(buffer.first) * ALIGNMENT;
+  size_t sliceSize = MIN_SLICE;
+  size_t copied = 0;
+  while (true) {
+    size_t available = sliceSize - sizeof(uint32_t);
+    size_t count = std::min(available, data.size() - copied);
+    std::memcpy(data.data() + copied, at(position), count);
+    copied += count;
+    if (copied == data.size()) {
+      break;
+    }
+
+    uint32_t link = 0;
+    std::memcpy(&link, at(position + available), sizeof(link));
+    position = static_cast<uint64_t>(link) * ALIGNMENT;
+    sliceSize = std::min(sliceSize * 2, MAX_SLICE);
+  }
+  return data;
+}
+
+std::vector<uint8_t>
+PostingAccumulator::postings(const std::string &term) const {
+  auto it = m_termIds.find(term);
+  return it == m_termIds.end() ? std::vector<uint8_t>()
+                               : read(m_buffers[it->second]);
+}
+
+void PostingAccumulator::finish(
+    const std::function<void(const std::string &, std::vector<uint8_t>)>
+        &callback) {
+  std::vector<const std::pair<const std::string, uint32_t> *> terms;
+  terms.reserve(m_termIds.size());
+  for (const auto &entry : m_termIds) {
+    terms.push_back(&entry);
+  }
+  std::sort(terms.begin(), terms.end(),
+            [](const auto *a, const auto *b) { return a->first < b->first; });
+
+  for (const auto *entry : terms) {
+    callback(entry->first, read(m_buffers[entry->second]));
+  }
+  clear();
+}
+
+void PostingAccumulator::clear() {
+  m_blocks.clear();
+  m_blockUsed = BLOCK_SIZE;
+  m_termIds.clear();
+  m_buffers.clear();
+}
+
+size_t PostingAccumulator::memoryUsage() const {
+  size_t total = m_blocks.size() * BLOCK_SIZE +
+                 m_buffers.capacity() * sizeof(TermBuffer);
+  for (const auto &entry : m_termIds) {
+    total += sizeof(entry) + entry.first.capacity();
+  }
+  return total;
+}
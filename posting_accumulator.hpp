@@ -0,0 +1,87 @@
+#ifndef POSTING_ACCUMULATOR_HPP
+#define POSTING_ACCUMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// PostingAccumulator
+// ============================================================================
+
+/**
+ * @brief Накопление posting lists сразу в delta-VByte без сортировки
+ *
+ * Документы индексируются по возрастанию docId, поэтому пара (разность
+ * docId, tf) дописывается в байтовый буфер термина сразу при обработке
+ * документа. Буфер термина — цепочка срезов в общей арене блоков: первый
+ * срез мал, каждый следующий вдвое больше (до MAX_SLICE), а последние
+ * 4 байта заполненного среза хранят адрес следующего. Несжатые пары и их
+ * сортировка не нужны, а результат побайтно совпадает с
+ * CompressionUtils::compressPostingList.
+ */
+class PostingAccumulator {
+public:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+  static constexpr size_t MIN_SLICE = 8;
+  static constexpr size_t MAX_SLICE = 4096;
+
+  /**
+   * @brief Добавляет документ в список термина
+   * @throws std::invalid_argument если docId не больше предыдущего docId
+   * термина
+   */
+  void add(const std::string &term, int docId, int frequency);
+
+  /**
+   * @brief Сжатый список термина (пусто, если термина нет)
+   */
+  std::vector<uint8_t> postings(const std::string &term) const;
+
+  /**
+   * @brief Отдаёт списки всех терминов по возрастанию термина и очищает
+   * накопитель
+   */
+  void finish(
+      const std::function<void(const std::string &, std::vector<uint8_t>)>
+          &callback);
+
+  void clear();
+
+  size_t termCount() const { return m_buffers.size(); }
+  size_t memoryUsage() const;
+
+private:
+  struct TermBuffer {
+    uint32_t first;     // начало первого среза (в единицах ALIGNMENT)
+    uint64_t write;     // позиция записи в арене
+    uint64_t limit;     // конец данных текущего среза
+    uint32_t sliceSize; // размер текущего среза
+    uint32_t size;      // байт в списке
+    int lastDocId;
+  };
+
+  static constexpr size_t ALIGNMENT = 8;
+
+  uint64_t allocate(size_t size);
+  uint8_t *at(uint64_t position) {
+    return m_blocks[position / BLOCK_SIZE].get() + position % BLOCK_SIZE;
+  }
+  const uint8_t *at(uint64_t position) const {
+    return m_blocks[position / BLOCK_SIZE].get() + position % BLOCK_SIZE;
+  }
+  void writeByte(TermBuffer &buffer, uint8_t byte);
+  void writeVByte(TermBuffer &buffer, int value);
+  std::vector<uint8_t> read(const TermBuffer &buffer) const;
+
+  std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+  size_t m_blockUsed = BLOCK_SIZE;
+  std::unordered_map<std::string, uint32_t> m_termIds;
+  std::vector<TermBuffer> m_buffers;
+};
+
+#endif // POSTING_ACCUMULATOR_HPP
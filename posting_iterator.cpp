@@ -0,0 +1,156 @@
+#include "posting_iterator.hpp"
+#include "compression_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <random>
+
+PostingIterator::PostingIterator(const std::vector<uint8_t> *data)
+    : m_data(data), m_offset(0), m_base(0), m_docId(-1), m_freq(0) {}
+
+PostingIterator::PostingIterator(const std::vector<uint8_t> *data,
+                                 Position start)
+    : m_data(data), m_offset(start.offset), m_base(start.previousDocId),
+      m_docId(-1), m_freq(0) {}
+
+int PostingIterator::next() {
+  if (!m_data || m_offset >= m_data->size()) {
+    m_docId = NO_MORE_DOCS;
+    m_freq = 0;
+    return m_docId;
+  }
+
+  int delta = CompressionUtils::vbyteDecode(*m_data, m_offset);
+  m_freq = CompressionUtils::vbyteDecode(*m_data, m_offset);
+  m_docId = (m_docId < 0 ? m_base : m_docId) + delta;
+  return m_docId;
+}
+
+int PostingIterator::advance(int target) {
+  while (m_docId < target) {
+    next();
+  }
+  return m_docId;
+}
+
+std::vector<std::pair<int, int>>
+unionPostingLists(const std::vector<const std::vector<uint8_t> *> &lists) {
+  std::vector<PostingIterator> iterators;
+  iterators.reserve(lists.size());
+
+  using HeapEntry = std::pair<int, size_t>;
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                      std::greater<HeapEntry>>
+      heap;
+
+  size_t expectedSize = 0;
+  for (const auto *list : lists) {
+    if (!list || list->empty()) {
+      continue;
+    }
+    iterators.emplace_back(list);
+    expectedSize = std::max(expectedSize, list->size() / 2);
+  }
+
+  for (size_t i = 0; i < iterators.size(); ++i) {
+    heap.push({iterators[i].next(), i});
+  }
+
+  std::vector<std::pair<int, int>> result;
+  result.reserve(expectedSize);
+
+  while (!heap.empty()) {
+    int docId = heap.top().first;
+    int freq = 0;
+
+    while (!heap.empty() && heap.top().first == docId) {
+      size_t idx = heap.top().second;
+      heap.pop();
+
+      freq += iterators[idx].freq();
+      if (iterators[idx].next() != PostingIterator::NO_MORE_DOCS) {
+        heap.push({iterators[idx].docId(), idx});
+      }
+    }
+
+    result.emplace_back(docId, freq);
+  }
+
+  return result;
+}
+
+UnionEstimate
+estimateUnionSize(const std::vector<const std::vector<uint8_t> *> &lists,
+                  size_t samples, uint64_t seed) {
+  std::vector<double> sizes;
+  double total = 0.0;
+  for (const auto *list : lists) {
+    sizes.push_back(
+        static_cast<double>(list ? CompressionUtils::countPostings(*list) : 0));
+    total += sizes.back();
+  }
+
+  if (total == 0.0) {
+    return {0.0, 0.0};
+  }
+
+  size_t sampleCount = std::max<size_t>(samples, 1);
+  std::mt19937_64 rng(seed);
+  std::discrete_distribution<size_t> pickList(sizes.begin(), sizes.end());
+
+  struct Sample {
+    size_t list;
+    size_t rank;
+    int docId;
+  };
+  std::vector<Sample> drawn(sampleCount);
+  for (auto &sample : drawn) {
+    sample.list = pickList(rng);
+    std::uniform_int_distribution<size_t> pickRank(
+        0, static_cast<size_t>(sizes[sample.list]) - 1);
+    sample.rank = pickRank(rng);
+  }
+
+  // Один проход по каждому списку до наибольшего выбранного ранга
+  std::sort(drawn.begin(), drawn.end(), [](const Sample &a, const Sample &b) {
+    return a.list != b.list ? a.list < b.list : a.rank < b.rank;
+  });
+  for (size_t i = 0; i < drawn.size();) {
+    size_t list = drawn[i].list;
+    PostingIterator it(lists[list]);
+    it.next();
+    size_t position = 0;
+
+    for (; i < drawn.size() && drawn[i].list == list; ++i) {
+      while (position < drawn[i].rank) {
+        it.next();
+        position++;
+      }
+      drawn[i].docId = it.docId();
+    }
+  }
+
+  // Выборка засчитывается, если список — канонический представитель
+  // документа, то есть документа нет ни в одном списке с меньшим номером
+  std::sort(drawn.begin(), drawn.end(), [](const Sample &a, const Sample &b) {
+    return a.docId < b.docId;
+  });
+  std::vector<bool> covered(drawn.size(), false);
+  for (size_t j = 0; j + 1 < lists.size(); ++j) {
+    PostingIterator it(lists[j]);
+    for (size_t s = 0; s < drawn.size(); ++s) {
+      if (!covered[s] && drawn[s].list > j &&
+          it.advance(drawn[s].docId) == drawn[s].docId) {
+        covered[s] = true;
+      }
+    }
+  }
+
+  double hits =
+      static_cast<double>(std::count(covered.begin(), covered.end(), false));
+  double p = hits / sampleCount;
+
+  return {total * p, 1.96 * total * std::sqrt(p * (1.0 - p) / sampleCount)};
+}
@@ -0,0 +1,99 @@
+#ifndef POSTING_ITERATOR_HPP
+#define POSTING_ITERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// PostingIterator
+// ============================================================================
+
+/**
+ * @brief Ленивый обход сжатого posting list без полной распаковки
+ *
+ * До первого вызова next() итератор стоит на позиции -1; после исчерпания
+ * списка docId() возвращает NO_MORE_DOCS.
+ */
+class PostingIterator {
+public:
+  static constexpr int NO_MORE_DOCS = std::numeric_limits<int>::max();
+
+  /**
+   * @brief Точка входа в середину списка: смещение очередного posting и
+   * docId перед ним (база для его delta)
+   */
+  struct Position {
+    size_t offset = 0;
+    int previousDocId = 0;
+  };
+
+  explicit PostingIterator(const std::vector<uint8_t> *data);
+  PostingIterator(const std::vector<uint8_t> *data, Position start);
+
+  int docId() const { return m_docId; }
+  int freq() const { return m_freq; }
+
+  /**
+   * @brief Переходит к следующему документу
+   * @return Новый docId или NO_MORE_DOCS
+   */
+  int next();
+
+  /**
+   * @brief Переходит к первому документу с docId >= target
+   * @return Новый docId или NO_MORE_DOCS
+   */
+  int advance(int target);
+
+  /**
+   * @brief Позиция, с которой продолжится обход после текущего документа
+   */
+  Position position() const {
+    return {m_offset, m_docId < 0 ? m_base : m_docId};
+  }
+
+private:
+  const std::vector<uint8_t> *m_data;
+  size_t m_offset;
+  int m_base;
+  int m_docId;
+  int m_freq;
+};
+
+// ============================================================================
+// Multiway union
+// ============================================================================
+
+/**
+ * @brief Объединяет несколько сжатых posting lists через кучу по docId
+ * @param lists Сжатые списки (nullptr пропускаются)
+ * @return Отсортированные пары (docId, суммарная частота)
+ */
+std::vector<std::pair<int, int>>
+unionPostingLists(const std::vector<const std::vector<uint8_t> *> &lists);
+
+struct UnionEstimate {
+  double size;
+  double errorBound; // полуширина 95% доверительного интервала
+};
+
+/**
+ * @brief Оценивает мощность объединения списков выборкой Карпа-Луби
+ *
+ * Случайный posting выбирается пропорционально размерам списков и
+ * засчитывается, если его документа нет в списках с меньшим номером.
+ * Выборки разрешаются одним последовательным проходом по каждому списку,
+ * память — O(samples) вместо множества результатов.
+ *
+ * @param lists Непустые сжатые списки
+ * @param samples Число выборок
+ * @param seed Зерно генератора (оценка воспроизводима)
+ */
+UnionEstimate
+estimateUnionSize(const std::vector<const std::vector<uint8_t> *> &lists,
+                  size_t samples, uint64_t seed);
+
+#endif // POSTING_ITERATOR_HPP
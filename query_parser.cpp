@@ -0,0 +1,522 @@
+#include "query_parser.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+QueryNode QueryNode::makeTerm(std::string term) {
+  QueryNode node;
+  node.type = Type::Term;
+  node.term = std::move(term);
+  return node;
+}
+
+QueryNode QueryNode::makeOperator(Type type, std::vector<QueryNode> children) {
+  QueryNode node;
+  node.type = type;
+  node.children = std::move(children);
+  return node;
+}
+
+QueryNode QueryNode::makeFilter(std::string field, std::string value) {
+  QueryNode node;
+  node.type = Type::Filter;
+  node.field = std::move(field);
+  node.term = std::move(value);
+  return node;
+}
+
+std::string QueryNode::toString() const {
+  if (type == Type::Term) {
+    return term;
+  }
+  if (type == Type::Filter) {
+    return field + ":" + term;
+  }
+
+  std::string result = type == Type::And  ? "(AND"
+                       : type == Type::Or ? "(OR"
+                                          : "(NOT";
+  for (const auto &child : children) {
+    result += " " + child.toString();
+  }
+  return result + ")";
+}
+
+namespace QueryParser {
+
+namespace {
+
+enum class TokenKind { Word, LeftParen, RightParen, And, Or, Not, Plus, Minus };
+
+struct Token {
+  TokenKind kind;
+  std::string text;
+};
+
+std::vector<Token> lex(const std::string &query) {
+  std::vector<Token> tokens;
+  size_t i = 0;
+
+  auto isSpace = [](char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+  };
+
+  while (i < query.size()) {
+    char c = query[i];
+
+    if (isSpace(c)) {
+      ++i;
+      continue;
+    }
+    if (c == '(' || c == ')') {
+      tokens.push_back(
+          {c == '(' ? TokenKind::LeftParen : TokenKind::RightParen, ""});
+      ++i;
+      continue;
+    }
+    if ((c == '+' || c == '-' || c == '!') && i + 1 < query.size() &&
+        !isSpace(query[i + 1]) && query[i + 1] != ')') {
+      tokens.push_back({c == '+'   ? TokenKind::Plus
+                        : c == '-' ? TokenKind::Minus
+                                   : TokenKind::Not,
+                        ""});
+      ++i;
+      continue;
+    }
+
+    size_t start = i;
+    while (i < query.size() && !isSpace(query[i]) && query[i] != '(' &&
+           query[i] != ')') {
+      ++i;
+    }
+    std::string word = query.substr(start, i - start);
+
+    if (word == "AND" || word == "&&") {
+      tokens.push_back({TokenKind::And, ""});
+    } else if (word == "OR" || word == "||") {
+      tokens.push_back({TokenKind::Or, ""});
+    } else if (word == "NOT") {
+      tokens.push_back({TokenKind::Not, ""});
+    } else {
+      tokens.push_back({TokenKind::Word, word});
+    }
+  }
+
+  return tokens;
+}
+
+enum class Occur { Required, Excluded, Optional };
+
+bool isFieldName(const std::string &name) {
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+    return false;
+  }
+  return std::all_of(name.begin(), name.end(), [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  });
+}
+
+class Parser {
+public:
+  explicit Parser(std::vector<Token> tokens) : m_tokens(std::move(tokens)) {}
+
+  QueryNode parseQuery() {
+    if (m_tokens.empty()) {
+      return QueryNode();
+    }
+
+    QueryNode node = parseOr();
+    if (m_pos < m_tokens.size()) {
+      throw std::invalid_argument("Unexpected ')' in query");
+    }
+    return node;
+  }
+
+private:
+  bool peek(TokenKind kind) const {
+    return m_pos < m_tokens.size() && m_tokens[m_pos].kind == kind;
+  }
+
+  QueryNode parseOr() {
+    std::vector<QueryNode> children = {parseAnd()};
+    while (peek(TokenKind::Or)) {
+      ++m_pos;
+      children.push_back(parseAnd());
+    }
+    return children.size() == 1
+               ? std::move(children[0])
+               : QueryNode::makeOperator(QueryNode::Type::Or,
+                                         std::move(children));
+  }
+
+  QueryNode parseAnd() {
+    std::vector<QueryNode> children = {parseSequence()};
+    while (peek(TokenKind::And)) {
+      ++m_pos;
+      children.push_back(parseSequence());
+    }
+    return children.size() == 1
+               ? std::move(children[0])
+               : QueryNode::makeOperator(QueryNode::Type::And,
+                                         std::move(children));
+  }
+
+  QueryNode parseSequence() {
+    std::vector<QueryNode> required;
+    std::vector<QueryNode> excluded;
+    std::vector<QueryNode> optional;
+    std::vector<QueryNode> filters;
+    size_t start = m_pos;
+
+    while (m_pos < m_tokens.size() && !peek(TokenKind::Or) &&
+           !peek(TokenKind::And) && !peek(TokenKind::RightParen)) {
+      Occur occur = Occur::Optional;
+      QueryNode node;
+      if (!parseItem(occur, node)) {
+        continue;
+      }
+      if (node.type == QueryNode::Type::Filter && occur == Occur::Optional) {
+        // Фильтр без префикса сужает выдачу, не отменяя необязательных слов
+        filters.push_back(std::move(node));
+      } else if (occur == Occur::Required) {
+        required.push_back(std::move(node));
+      } else if (occur == Occur::Excluded) {
+        excluded.push_back(
+            QueryNode::makeOperator(QueryNode::Type::Not, {std::move(node)}));
+      } else {
+        optional.push_back(std::move(node));
+      }
+    }
+
+    if (m_pos == start) {
+      throw std::invalid_argument("Missing operand in query");
+    }
+
+    std::vector<QueryNode> conjunction = std::move(required);
+    if (conjunction.empty() && !optional.empty()) {
+      conjunction.push_back(
+          optional.size() == 1
+              ? std::move(optional[0])
+              : QueryNode::makeOperator(QueryNode::Type::Or,
+                                        std::move(optional)));
+    }
+    for (auto &node : filters) {
+      conjunction.push_back(std::move(node));
+    }
+
+    if (excluded.empty()) {
+      if (conjunction.size() == 1) {
+        return std::move(conjunction[0]);
+      }
+      if (conjunction.empty()) {
+        return QueryNode();
+      }
+    }
+
+    for (auto &node : excluded) {
+      conjunction.push_back(std::move(node));
+    }
+    return QueryNode::makeOperator(QueryNode::Type::And,
+                                   std::move(conjunction));
+  }
+
+  /**
+   * @return false если элемент не содержит ни одного термина
+   */
+  bool parseItem(Occur &occur, QueryNode &node) {
+    if (m_pos >= m_tokens.size()) {
+      throw std::invalid_argument("Missing operand in query");
+    }
+
+    TokenKind kind = m_tokens[m_pos].kind;
+
+    if (kind == TokenKind::Not) {
+      ++m_pos;
+      Occur inner = Occur::Optional;
+      bool valid = parseItem(inner, node);
+      if (valid && inner == Occur::Excluded) {
+        node = QueryNode::makeOperator(QueryNode::Type::Not, {std::move(node)});
+      }
+      occur = Occur::Excluded;
+      return valid;
+    }
+
+    if (kind == TokenKind::Plus || kind == TokenKind::Minus) {
+      occur = kind == TokenKind::Plus ? Occur::Required : Occur::Excluded;
+      ++m_pos;
+    }
+
+    return parsePrimary(node);
+  }
+
+  bool parsePrimary(QueryNode &node) {
+    if (m_pos >= m_tokens.size()) {
+      throw std::invalid_argument("Missing operand in query");
+    }
+
+    const Token &token = m_tokens[m_pos];
+
+    if (token.kind == TokenKind::LeftParen) {
+      ++m_pos;
+      node = parseOr();
+      if (!peek(TokenKind::RightParen)) {
+        throw std::invalid_argument("Missing ')' in query");
+      }
+      ++m_pos;
+      return true;
+    }
+
+    if (token.kind != TokenKind::Word) {
+      throw std::invalid_argument("Missing operand in query");
+    }
+    ++m_pos;
+
+    std::string lower = TextUtils::toLowerCase(token.text);
+    if (lower.compare(0, 5, "site:") == 0 && lower.size() > 5) {
+      std::string host = lower.substr(5);
+      if (host.compare(0, 4, "www.") == 0) {
+        host = host.substr(4);
+      }
+      node = QueryNode::makeFilter("site", host);
+      return true;
+    }
+
+    size_t colon = lower.find(':');
+    if (colon != std::string::npos &&
+        lower.find("..", colon) != std::string::npos &&
+        isFieldName(lower.substr(0, colon))) {
+      node = QueryNode::makeFilter(lower.substr(0, colon),
+                                   lower.substr(colon + 1));
+      return true;
+    }
+
+    std::vector<std::string> parsed = TextUtils::tokenizeQuery(token.text);
+    if (parsed.empty()) {
+      return false;
+    }
+
+    node = QueryNode::makeTerm(parsed[0]);
+    return true;
+  }
+
+  std::vector<Token> m_tokens;
+  size_t m_pos = 0;
+};
+
+using DocFrequency = std::function<size_t(const std::string &)>;
+
+bool matchesNothing(const QueryNode &node) {
+  if (node.isEmpty()) {
+    return true;
+  }
+  if (node.type != QueryNode::Type::And) {
+    return false;
+  }
+  return std::all_of(node.children.begin(), node.children.end(),
+                     [](const QueryNode &child) {
+                       return child.type == QueryNode::Type::Not;
+                     });
+}
+
+size_t estimate(const QueryNode &node, const DocFrequency &docFrequency) {
+  switch (node.type) {
+  case QueryNode::Type::Term:
+    return docFrequency(node.term);
+  case QueryNode::Type::Filter:
+    return docFrequency(node.toString());
+  case QueryNode::Type::Not:
+    return estimate(node.children[0], docFrequency);
+  case QueryNode::Type::Or: {
+    size_t total = 0;
+    for (const auto &child : node.children) {
+      total += estimate(child, docFrequency);
+    }
+    return total;
+  }
+  case QueryNode::Type::And: {
+    size_t best = 0;
+    bool found = false;
+    for (const auto &child : node.children) {
+      if (child.type != QueryNode::Type::Not) {
+        size_t cost = estimate(child, docFrequency);
+        best = found ? std::min(best, cost) : cost;
+        found = true;
+      }
+    }
+    return best;
+  }
+  }
+  return 0;
+}
+
+void sortByEstimate(std::vector<QueryNode> &nodes,
+                    const DocFrequency &docFrequency) {
+  std::vector<std::pair<size_t, size_t>> order;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    order.emplace_back(estimate(nodes[i], docFrequency), i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<size_t, size_t> &a,
+                      const std::pair<size_t, size_t> &b) {
+                     return a.first < b.first;
+                   });
+
+  std::vector<QueryNode> sorted;
+  sorted.reserve(nodes.size());
+  for (const auto &entry : order) {
+    sorted.push_back(std::move(nodes[entry.second]));
+  }
+  nodes = std::move(sorted);
+}
+
+void appendUnique(std::vector<QueryNode> &nodes, std::set<std::string> &seen,
+                  QueryNode node) {
+  if (seen.insert(node.toString()).second) {
+    nodes.push_back(std::move(node));
+  }
+}
+
+QueryNode rewriteNot(QueryNode child, const DocFrequency &docFrequency) {
+  if (child.type == QueryNode::Type::Not) {
+    return std::move(child.children[0]);
+  }
+
+  // NOT пустого множества ничего не исключает, а отрицание AND без
+  // ограничений не совпадает ни с чем
+  if (child.isEmpty()) {
+    return QueryNode::makeOperator(QueryNode::Type::And, {});
+  }
+  if (child.type == QueryNode::Type::And && child.children.empty()) {
+    return QueryNode();
+  }
+
+  if (child.type == QueryNode::Type::Or) {
+    std::vector<QueryNode> negated;
+    for (auto &grandChild : child.children) {
+      negated.push_back(rewriteNot(std::move(grandChild), docFrequency));
+    }
+    return rewrite(
+        QueryNode::makeOperator(QueryNode::Type::And, std::move(negated)),
+        docFrequency);
+  }
+
+  if (child.type == QueryNode::Type::And && !child.children.empty() &&
+      matchesNothing(child)) {
+    std::vector<QueryNode> positive;
+    for (auto &grandChild : child.children) {
+      positive.push_back(std::move(grandChild.children[0]));
+    }
+    return rewrite(
+        QueryNode::makeOperator(QueryNode::Type::Or, std::move(positive)),
+        docFrequency);
+  }
+
+  return QueryNode::makeOperator(QueryNode::Type::Not, {std::move(child)});
+}
+
+} // namespace
+
+QueryNode parse(const std::string &query) {
+  return Parser(lex(query)).parseQuery();
+}
+
+QueryNode rewrite(QueryNode node, const DocFrequency &docFrequency) {
+  if (node.type == QueryNode::Type::Term ||
+      node.type == QueryNode::Type::Filter) {
+    return node;
+  }
+
+  if (node.type == QueryNode::Type::Not) {
+    return rewriteNot(rewrite(std::move(node.children[0]), docFrequency),
+                      docFrequency);
+  }
+
+  std::vector<QueryNode> flat;
+  for (auto &child : node.children) {
+    QueryNode rewritten = rewrite(std::move(child), docFrequency);
+    if (rewritten.type == node.type) {
+      for (auto &grandChild : rewritten.children) {
+        flat.push_back(std::move(grandChild));
+      }
+    } else {
+      flat.push_back(std::move(rewritten));
+    }
+  }
+
+  std::set<std::string> seen;
+
+  if (node.type == QueryNode::Type::Or) {
+    std::vector<QueryNode> children;
+    for (auto &child : flat) {
+      if (!matchesNothing(child)) {
+        appendUnique(children, seen, std::move(child));
+      }
+    }
+
+    if (children.size() == 1) {
+      return std::move(children[0]);
+    }
+    sortByEstimate(children, docFrequency);
+    return QueryNode::makeOperator(QueryNode::Type::Or, std::move(children));
+  }
+
+  std::vector<QueryNode> positive;
+  std::vector<QueryNode> negative;
+  for (auto &child : flat) {
+    if (child.type == QueryNode::Type::Not) {
+      appendUnique(negative, seen, std::move(child));
+    } else if (matchesNothing(child)) {
+      return QueryNode();
+    } else {
+      appendUnique(positive, seen, std::move(child));
+    }
+  }
+
+  // A AND NOT A
+  for (const auto &excluded : negative) {
+    if (seen.count(excluded.children[0].toString())) {
+      return QueryNode();
+    }
+  }
+
+  if (positive.size() == 1 && negative.empty()) {
+    return std::move(positive[0]);
+  }
+
+  sortByEstimate(positive, docFrequency);
+  sortByEstimate(negative, docFrequency);
+  for (auto &child : negative) {
+    positive.push_back(std::move(child));
+  }
+  return QueryNode::makeOperator(QueryNode::Type::And, std::move(positive));
+}
+
+std::vector<std::string> positiveTerms(const QueryNode &node) {
+  std::vector<std::string> terms;
+
+  std::function<void(const QueryNode &)> collect = [&](const QueryNode &n) {
+    if (n.type == QueryNode::Type::Term) {
+      terms.push_back(n.term);
+    } else if (n.type != QueryNode::Type::Not) {
+      for (const auto &child : n.children) {
+        collect(child);
+      }
+    }
+  };
+  collect(node);
+
+  std::sort(terms.begin(), terms.end());
+  terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+  return terms;
+}
+
+bool isOperator(const std::string &word) {
+  return word == "AND" || word == "OR" || word == "NOT" || word == "&&" ||
+         word == "||";
+}
+
+} // namespace QueryParser
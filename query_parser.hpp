@@ -0,0 +1,93 @@
+#ifndef QUERY_PARSER_HPP
+#define QUERY_PARSER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// QueryNode
+// ============================================================================
+
+/**
+ * @brief Узел дерева булева запроса
+ *
+ * Пустой OR (без детей) не совпадает ни с одним документом. NOT встречается
+ * только внутри AND и означает исключение; AND без положительных детей
+ * ничего не находит, так как множество всех документов не перебирается.
+ */
+struct QueryNode {
+  enum class Type { Term, Filter, And, Or, Not };
+
+  Type type = Type::Or;
+  std::string term; // для Filter — значение поля
+  std::string field;
+  std::vector<QueryNode> children;
+
+  static QueryNode makeTerm(std::string term);
+  static QueryNode makeFilter(std::string field, std::string value);
+  static QueryNode makeOperator(Type type, std::vector<QueryNode> children);
+
+  bool isEmpty() const { return type == Type::Or && children.empty(); }
+
+  /**
+   * @brief Каноническая запись в виде S-выражения, например (AND a (NOT b))
+   */
+  std::string toString() const;
+};
+
+// ============================================================================
+// QueryParser
+// ============================================================================
+
+namespace QueryParser {
+
+/**
+ * @brief Разбирает булев запрос в дерево
+ *
+ * Грамматика (операторы — только заглавными, либо &&, ||, !):
+ *   orExpr  := andExpr ( OR andExpr )*
+ *   andExpr := seqExpr ( AND seqExpr )*
+ *   seqExpr := item+
+ *   item    := [+|-] primary | NOT item
+ *   primary := '(' orExpr ')' | термин
+ * Последовательность без операторов трактуется как раньше: +x обязателен,
+ * -x и NOT x исключаются, остальные термины объединяются по OR и
+ * игнорируются при наличии обязательных. Фильтры site:host и диапазоны
+ * field:lo..hi становятся узлами Filter и без префикса всегда сужают
+ * выдачу, не отменяя необязательных терминов.
+ *
+ * @throws std::invalid_argument при несбалансированных скобках или
+ * отсутствующем операнде
+ */
+QueryNode parse(const std::string &query);
+
+/**
+ * @brief Упрощает дерево перед выполнением
+ *
+ * Сливает вложенные AND/OR, убирает повторы, проталкивает NOT через OR
+ * и двойное отрицание, сворачивает заведомо пустые ветви и упорядочивает
+ * детей по возрастанию документной частоты.
+ *
+ * @param docFrequency Оценка числа документов с термином (для фильтра
+ * передаётся запись вида site:host или field:lo..hi)
+ */
+QueryNode rewrite(QueryNode node,
+                  const std::function<size_t(const std::string &)>
+                      &docFrequency);
+
+/**
+ * @brief Собирает термины, влияющие на совпадение положительно (не под NOT);
+ * фильтры не включаются
+ */
+std::vector<std::string> positiveTerms(const QueryNode &node);
+
+/**
+ * @brief Проверяет, является ли слово оператором запроса
+ */
+bool isOperator(const std::string &word);
+
+} // namespace QueryParser
+
+#endif // QUERY_PARSER_HPP
@@ -0,0 +1,302 @@
+#include "query_plan.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace {
+
+class EmptyIterator : public DocIterator {
+public:
+  int docId() const override { return m_docId; }
+  int next() override { return m_docId = NO_MORE_DOCS; }
+  int advance(int) override { return m_docId = NO_MORE_DOCS; }
+
+private:
+  int m_docId = -1;
+};
+
+class TermIterator : public DocIterator {
+public:
+  TermIterator(const std::vector<uint8_t> *data,
+               PostingIterator::Position start)
+      : m_postings(data, start) {}
+
+  int docId() const override { return m_postings.docId(); }
+  int freq() const override { return m_postings.freq(); }
+  int next() override { return m_postings.next(); }
+  int advance(int target) override { return m_postings.advance(target); }
+
+private:
+  PostingIterator m_postings;
+};
+
+class BitmapIterator : public DocIterator {
+public:
+  explicit BitmapIterator(const DocBitmap *bitmap) : m_bitmap(bitmap) {}
+
+  int docId() const override { return m_docId; }
+
+  int next() override {
+    return m_docId == NO_MORE_DOCS ? m_docId : advance(m_docId + 1);
+  }
+
+  int advance(int target) override {
+    if (m_docId >= target) {
+      return m_docId;
+    }
+    uint32_t doc = m_bitmap->nextSetBit(static_cast<uint32_t>(target));
+    m_docId = doc >= static_cast<uint32_t>(NO_MORE_DOCS)
+                  ? NO_MORE_DOCS
+                  : static_cast<int>(doc);
+    return m_docId;
+  }
+
+private:
+  const DocBitmap *m_bitmap;
+  int m_docId = -1;
+};
+
+class OrIterator : public DocIterator {
+public:
+  explicit OrIterator(std::vector<std::unique_ptr<DocIterator>> children)
+      : m_children(std::move(children)) {}
+
+  int docId() const override { return m_docId; }
+
+  int freq() const override {
+    int total = 0;
+    for (const auto &child : m_children) {
+      if (child->docId() == m_docId) {
+        total += child->freq();
+      }
+    }
+    return total;
+  }
+
+  int next() override {
+    return m_docId == NO_MORE_DOCS ? m_docId : advance(m_docId + 1);
+  }
+
+  int advance(int target) override {
+    if (m_docId >= target) {
+      return m_docId;
+    }
+
+    if (!m_started) {
+      for (size_t i = 0; i < m_children.size(); ++i) {
+        int doc = m_children[i]->advance(target);
+        if (doc != NO_MORE_DOCS) {
+          m_heap.push({doc, i});
+        }
+      }
+      m_started = true;
+    }
+
+    while (!m_heap.empty() && m_heap.top().first < target) {
+      size_t idx = m_heap.top().second;
+      m_heap.pop();
+      int doc = m_children[idx]->advance(target);
+      if (doc != NO_MORE_DOCS) {
+        m_heap.push({doc, idx});
+      }
+    }
+
+    m_docId = m_heap.empty() ? NO_MORE_DOCS : m_heap.top().first;
+    return m_docId;
+  }
+
+private:
+  using HeapEntry = std::pair<int, size_t>;
+
+  std::vector<std::unique_ptr<DocIterator>> m_children;
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                      std::greater<HeapEntry>>
+      m_heap;
+  bool m_started = false;
+  int m_docId = -1;
+};
+
+class AndIterator : public DocIterator {
+public:
+  AndIterator(std::vector<std::unique_ptr<DocIterator>> required,
+              std::vector<std::unique_ptr<DocIterator>> excluded)
+      : m_required(std::move(required)), m_excluded(std::move(excluded)) {}
+
+  int docId() const override { return m_docId; }
+
+  int next() override {
+    return m_docId == NO_MORE_DOCS ? m_docId : advance(m_docId + 1);
+  }
+
+  int advance(int target) override {
+    if (m_docId >= target) {
+      return m_docId;
+    }
+    if (m_required.empty()) {
+      return m_docId = NO_MORE_DOCS;
+    }
+
+    int candidate = m_required[0]->advance(target);
+
+    while (candidate != NO_MORE_DOCS) {
+      int next = candidate;
+
+      for (size_t i = 1; i < m_required.size(); ++i) {
+        int doc = m_required[i]->advance(candidate);
+        if (doc > candidate) {
+          next = doc;
+          break;
+        }
+      }
+
+      if (next == candidate && isExcluded(candidate)) {
+        next = candidate + 1;
+      }
+
+      if (next == candidate) {
+        return m_docId = candidate;
+      }
+      candidate = m_required[0]->advance(next);
+    }
+
+    return m_docId = NO_MORE_DOCS;
+  }
+
+private:
+  bool isExcluded(int doc) {
+    for (auto &excluded : m_excluded) {
+      if (excluded->advance(doc) == doc) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<DocIterator>> m_required;
+  std::vector<std::unique_ptr<DocIterator>> m_excluded;
+  int m_docId = -1;
+};
+
+class ClipIterator : public DocIterator {
+public:
+  ClipIterator(std::unique_ptr<DocIterator> inner, int begin, int end)
+      : m_inner(std::move(inner)), m_begin(begin), m_end(end) {}
+
+  int docId() const override { return m_docId; }
+  int freq() const override { return m_inner->freq(); }
+
+  int next() override {
+    if (m_docId == NO_MORE_DOCS) {
+      return m_docId;
+    }
+    return bound(m_docId < 0 ? m_inner->advance(m_begin) : m_inner->next());
+  }
+
+  int advance(int target) override {
+    if (m_docId >= target) {
+      return m_docId;
+    }
+    return bound(m_inner->advance(std::max(target, m_begin)));
+  }
+
+private:
+  int bound(int doc) { return m_docId = doc >= m_end ? NO_MORE_DOCS : doc; }
+
+  std::unique_ptr<DocIterator> m_inner;
+  int m_begin;
+  int m_end;
+  int m_docId = -1;
+};
+
+} // namespace
+
+namespace QueryPlan {
+
+std::unique_ptr<DocIterator> compile(const QueryNode &node,
+                                     const PostingLookup &lookup,
+                                     const FilterLookup &filters,
+                                     const SkipLookup &skips) {
+  switch (node.type) {
+  case QueryNode::Type::Filter: {
+    auto iterator = filters ? filters(node.field, node.term) : nullptr;
+    if (!iterator) {
+      return std::make_unique<EmptyIterator>();
+    }
+    return iterator;
+  }
+
+  case QueryNode::Type::Term: {
+    std::vector<std::unique_ptr<DocIterator>> lists;
+    for (const auto *list : lookup(node.term)) {
+      if (list && !list->empty()) {
+        lists.push_back(std::make_unique<TermIterator>(
+            list, skips ? skips(list) : PostingIterator::Position()));
+      }
+    }
+    if (lists.empty()) {
+      return std::make_unique<EmptyIterator>();
+    }
+    if (lists.size() == 1) {
+      return std::move(lists[0]);
+    }
+    return std::make_unique<OrIterator>(std::move(lists));
+  }
+
+  case QueryNode::Type::Or: {
+    if (node.children.empty()) {
+      return std::make_unique<EmptyIterator>();
+    }
+    std::vector<std::unique_ptr<DocIterator>> children;
+    for (const auto &child : node.children) {
+      children.push_back(compile(child, lookup, filters, skips));
+    }
+    return std::make_unique<OrIterator>(std::move(children));
+  }
+
+  case QueryNode::Type::And: {
+    std::vector<std::unique_ptr<DocIterator>> required;
+    std::vector<std::unique_ptr<DocIterator>> excluded;
+    for (const auto &child : node.children) {
+      if (child.type == QueryNode::Type::Not) {
+        excluded.push_back(
+            compile(child.children[0], lookup, filters, skips));
+      } else {
+        required.push_back(compile(child, lookup, filters, skips));
+      }
+    }
+    return std::make_unique<AndIterator>(std::move(required),
+                                         std::move(excluded));
+  }
+
+  case QueryNode::Type::Not:
+    // Отрицание вне AND не перечислимо без множества всех документов
+    return std::make_unique<EmptyIterator>();
+  }
+
+  return std::make_unique<EmptyIterator>();
+}
+
+std::unique_ptr<DocIterator> clip(std::unique_ptr<DocIterator> iterator,
+                                  int begin, int end) {
+  return std::make_unique<ClipIterator>(std::move(iterator), begin, end);
+}
+
+std::unique_ptr<DocIterator> iterate(const DocBitmap *bitmap) {
+  if (!bitmap || bitmap->empty()) {
+    return std::make_unique<EmptyIterator>();
+  }
+  return std::make_unique<BitmapIterator>(bitmap);
+}
+
+std::vector<int> collect(DocIterator &iterator, size_t limit) {
+  std::vector<int> docIds;
+  while (docIds.size() < limit &&
+         iterator.next() != DocIterator::NO_MORE_DOCS) {
+    docIds.push_back(iterator.docId());
+  }
+  return docIds;
+}
+
+} // namespace QueryPlan
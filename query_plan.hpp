@@ -0,0 +1,101 @@
+#ifndef QUERY_PLAN_HPP
+#define QUERY_PLAN_HPP
+
+#include "doc_bitmap.hpp"
+#include "posting_iterator.hpp"
+#include "query_parser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// DocIterator
+// ============================================================================
+
+/**
+ * @brief Узел плана выполнения булева запроса
+ *
+ * Как и PostingIterator, до первого next() стоит на -1, после исчерпания
+ * возвращает NO_MORE_DOCS. advance(target) никогда не двигается назад.
+ */
+class DocIterator {
+public:
+  static constexpr int NO_MORE_DOCS = PostingIterator::NO_MORE_DOCS;
+
+  virtual ~DocIterator() = default;
+
+  virtual int docId() const = 0;
+
+  /**
+   * @brief Частота термина в текущем документе (сумма по раскрытиям);
+   * 0 для пересечений
+   */
+  virtual int freq() const { return 0; }
+
+  virtual int next() = 0;
+  virtual int advance(int target) = 0;
+};
+
+/**
+ * @brief Возвращает сжатые posting lists термина (раскрытия шаблона или
+ * нечёткого поиска дают несколько списков; nullptr допустим)
+ */
+using PostingLookup = std::function<std::vector<const std::vector<uint8_t> *>(
+    const std::string &term)>;
+
+/**
+ * @brief Возвращает итератор по документам фильтра поля (nullptr — пусто)
+ */
+using FilterLookup = std::function<std::unique_ptr<DocIterator>(
+    const std::string &field, const std::string &value)>;
+
+/**
+ * @brief Возвращает позицию, с которой начинать обход сжатого списка (для
+ * обхода одного диапазона docId; позиция по умолчанию — начало списка)
+ */
+using SkipLookup = std::function<PostingIterator::Position(
+    const std::vector<uint8_t> *list)>;
+
+namespace QueryPlan {
+
+/**
+ * @brief Компилирует переписанное дерево запроса в дерево итераторов
+ *
+ * Термин становится итератором по сжатому списку (или объединением по
+ * куче для раскрытых терминов), AND — пересечением с перескоками через
+ * advance() в порядке детей и проверкой исключений, OR — объединением по
+ * куче, фильтр — итератором из FilterLookup. Порядок детей AND задаётся
+ * QueryParser::rewrite.
+ */
+std::unique_ptr<DocIterator> compile(const QueryNode &node,
+                                     const PostingLookup &lookup,
+                                     const FilterLookup &filters = {},
+                                     const SkipLookup &skips = {});
+
+/**
+ * @brief Ограничивает итератор диапазоном docId [begin, end)
+ *
+ * Первый next() перескакивает к begin через advance(); документы от end и
+ * дальше не перечисляются.
+ */
+std::unique_ptr<DocIterator> clip(std::unique_ptr<DocIterator> iterator,
+                                  int begin, int end);
+
+/**
+ * @brief Итератор по документам DocBitmap (nullptr или пустое — пусто)
+ */
+std::unique_ptr<DocIterator> iterate(const DocBitmap *bitmap);
+
+/**
+ * @brief Выбирает документы итератора по возрастанию docId
+ * @param limit Максимальное число документов
+ */
+std::vector<int> collect(DocIterator &iterator, size_t limit = SIZE_MAX);
+
+} // namespace QueryPlan
+
+#endif // QUERY_PLAN_HPP
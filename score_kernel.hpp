@@ -0,0 +1,105 @@
+#ifndef SCORE_KERNEL_HPP
+#define SCORE_KERNEL_HPP
+
+#include "compression_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// ScoreKernel
+// ============================================================================
+
+/**
+ * @brief Поблочная оценка postings для накопления «термин за термином»
+ *
+ * Список декодируется блоками по BLOCK_SIZE в отдельные массивы docId и tf.
+ * Блок обрабатывается группами по LANES: длины документов собираются из
+ * плотного массива, оценки считаются в независимых дорожках одним и тем
+ * же выражением без ветвлений (такой цикл компилятор векторизует), затем
+ * раскладываются в плотный аккумулятор по docId. Модель оценки —
+ * параметр шаблона (model(tf, длина), см. Scoring::TermScorer), поэтому
+ * её формула встраивается в цикл.
+ *
+ * Дорожки считаются в double, а не во float: так оценки совпадают бит в
+ * бит с оценками документ-за-документом (rankByPlan), и курсоры страниц
+ * остаются согласованными между двумя путями.
+ */
+namespace ScoreKernel {
+
+constexpr size_t BLOCK_SIZE = 128;
+constexpr size_t LANES = 8;
+
+/**
+ * @brief Декодирует следующий блок delta-VByte списка
+ * @param offset Позиция в data, сдвигается за блок
+ * @param lastDocId Последний декодированный docId, обновляется
+ * @return Число postings в блоке (0 в конце списка)
+ */
+inline size_t decodeBlock(const std::vector<uint8_t> &data, size_t &offset,
+                          int &lastDocId, int *docIds, int *tfs) {
+  size_t count = 0;
+  while (count < BLOCK_SIZE && offset < data.size()) {
+    lastDocId += CompressionUtils::vbyteDecode(data, offset);
+    docIds[count] = lastDocId;
+    tfs[count] = CompressionUtils::vbyteDecode(data, offset);
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Добавляет оценки блока в аккумулятор
+ *
+ * docId внутри одного списка различны, поэтому запись в аккумулятор не
+ * конфликтует между дорожками.
+ *
+ * @param lengths Длина документа по docId (плотный массив)
+ * @param accumulator Сумма оценок по docId (плотный массив)
+ */
+template <typename Model>
+void scoreBlock(const Model &model, const int *docIds, const int *tfs,
+                size_t count, const double *lengths, double *accumulator) {
+  size_t i = 0;
+  for (; i + LANES <= count; i += LANES) {
+    double tf[LANES];
+    double length[LANES];
+    double score[LANES];
+
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      tf[lane] = tfs[i + lane];
+      length[lane] = lengths[docIds[i + lane]];
+    }
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      score[lane] = model(tf[lane], length[lane]);
+    }
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      accumulator[docIds[i + lane]] += score[lane];
+    }
+  }
+
+  for (; i < count; ++i) {
+    accumulator[docIds[i]] += model(tfs[i], lengths[docIds[i]]);
+  }
+}
+
+/**
+ * @brief Оценивает весь сжатый список блоками
+ */
+template <typename Model>
+void scoreList(const Model &model, const std::vector<uint8_t> &data,
+               const double *lengths, double *accumulator) {
+  int docIds[BLOCK_SIZE];
+  int tfs[BLOCK_SIZE];
+  size_t offset = 0;
+  int lastDocId = 0;
+
+  while (size_t count = decodeBlock(data, offset, lastDocId, docIds, tfs)) {
+    scoreBlock(model, docIds, tfs, count, lengths, accumulator);
+  }
+}
+
+} // namespace ScoreKernel
+
+#endif // SCORE_KERNEL_HPP
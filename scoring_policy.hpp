@@ -0,0 +1,132 @@
+#ifndef SCORING_POLICY_HPP
+#define SCORING_POLICY_HPP
+
+#include <cmath>
+#include <limits>
+
+// ============================================================================
+// Scoring
+// ============================================================================
+
+/**
+ * @brief Политики оценки документов для ранжирующих обходов
+ *
+ * Политика — класс со статическими функциями:
+ * - weight(df, N) — вес термина, считается один раз на запрос;
+ * - score(weight, tf, длина, средняя длина) — вклад одного posting;
+ * - bound(weight, границы списка, средняя длина) — верхняя граница вклада
+ *   термина в оценку любого документа.
+ * RATIO_MONOTONE означает, что вклад не убывает с ростом tf / длина, и
+ * худший из чемпионов термина ограничивает вклад остальных документов.
+ * Обходы инстанцируются для каждой политики, так что константы вроде k1 и
+ * b подставляются в цикл оценки при компиляции.
+ */
+namespace Scoring {
+
+/**
+ * @brief Границы списка термина для оценки сверху; значения по умолчанию
+ * годятся для любого списка (раскрытия шаблонов)
+ */
+struct TermBounds {
+  double maxRatio = 1.0; // max tf / длина
+  double maxTf = std::numeric_limits<double>::infinity();
+  double minLength = 1.0; // min длина документа в списке
+};
+
+/**
+ * @brief tf / длина * log(N / df)
+ */
+struct TfIdf {
+  static constexpr bool RATIO_MONOTONE = true;
+
+  static double weight(double docFrequency, double docCount) {
+    return std::log(docCount / docFrequency);
+  }
+  static double score(double weight, double tf, double length, double) {
+    return tf / length * weight;
+  }
+  static double bound(double weight, const TermBounds &bounds, double) {
+    return weight * bounds.maxRatio;
+  }
+};
+
+/**
+ * @brief Okapi BM25 (k1 = 1.2, b = 0.75)
+ */
+struct Bm25 {
+  static constexpr bool RATIO_MONOTONE = false;
+  static constexpr double K1 = 1.2;
+  static constexpr double B = 0.75;
+
+  static double weight(double docFrequency, double docCount) {
+    return std::log(1.0 + (docCount - docFrequency + 0.5) /
+                              (docFrequency + 0.5));
+  }
+  static double saturation(double tf, double length, double averageLength) {
+    return tf * (K1 + 1.0) /
+           (tf + K1 * (1.0 - B + B * length / averageLength));
+  }
+  static double score(double weight, double tf, double length,
+                      double averageLength) {
+    return weight * saturation(tf, length, averageLength);
+  }
+  // Насыщение растёт с tf и убывает с длиной документа
+  static double bound(double weight, const TermBounds &bounds,
+                      double averageLength) {
+    if (std::isinf(bounds.maxTf)) {
+      return weight * (K1 + 1.0);
+    }
+    return weight * saturation(bounds.maxTf, bounds.minLength, averageLength);
+  }
+};
+
+/**
+ * @brief BM25+ (Lv, Zhai): к насыщению добавляется delta = 1, чтобы
+ * длинные документы с термином не проигрывали документам без него
+ */
+struct Bm25Plus {
+  static constexpr bool RATIO_MONOTONE = false;
+  static constexpr double DELTA = 1.0;
+
+  static double weight(double docFrequency, double docCount) {
+    return std::log((docCount + 1.0) / docFrequency);
+  }
+  static double score(double weight, double tf, double length,
+                      double averageLength) {
+    return weight * (Bm25::saturation(tf, length, averageLength) + DELTA);
+  }
+  static double bound(double weight, const TermBounds &bounds,
+                      double averageLength) {
+    return Bm25::bound(weight, bounds, averageLength) + weight * DELTA;
+  }
+};
+
+/**
+ * @brief Сумма tf терминов запроса без нормализации
+ */
+struct Count {
+  static constexpr bool RATIO_MONOTONE = false;
+
+  static double weight(double, double) { return 1.0; }
+  static double score(double, double tf, double, double) { return tf; }
+  static double bound(double, const TermBounds &bounds, double) {
+    return bounds.maxTf;
+  }
+};
+
+/**
+ * @brief Вклад posting по политике с весом термина, зафиксированным на
+ * запрос (модель для ScoreKernel)
+ */
+template <typename Policy> struct TermScorer {
+  double weight;
+  double averageLength;
+
+  double operator()(double tf, double length) const {
+    return Policy::score(weight, tf, length, averageLength);
+  }
+};
+
+} // namespace Scoring
+
+#endif // SCORING_POLICY_HPP
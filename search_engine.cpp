@@ -1,17 +1,167 @@
 #include "search_engine.hpp"
 #include "compression_utils.hpp"
+#include "doc_reorder.hpp"
 #include "file_utils.hpp"
+#include "index_pruning.hpp"
+#include "posting_accumulator.hpp"
+#include "posting_iterator.hpp"
+#include "query_plan.hpp"
+#include "score_kernel.hpp"
 #include "text_utils.hpp"
 
 #include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+const char STATIC_RANK_FIELD[] = "static_rank";
+const char SIMHASH_FIELD[] = "simhash";
+const char GLOBAL_ID_FIELD[] = "global_id";
+
+using PostingsMap = CustomHashMap<std::string, std::vector<uint8_t>>;
+
+// Единственная точка выбора политики во время выполнения: дальше запрос
+// идёт по специализации обхода
+template <typename Callback>
+auto withScoringPolicy(SearchEngine::ScoringModel model, Callback &&callback) {
+  switch (model) {
+  case SearchEngine::ScoringModel::Bm25:
+    return callback(Scoring::Bm25());
+  case SearchEngine::ScoringModel::Bm25Plus:
+    return callback(Scoring::Bm25Plus());
+  case SearchEngine::ScoringModel::Count:
+    return callback(Scoring::Count());
+  case SearchEngine::ScoringModel::TfIdf:
+    break;
+  }
+  return callback(Scoring::TfIdf());
+}
+
+// Формат inverted_index.bin: длина термина, термин, длина списка, список.
+// Термины пишутся по возрастанию, чтобы файлы можно было сливать потоково.
+bool writePostings(std::ostream &file, const PostingsMap &index) {
+  std::vector<const std::pair<std::string, std::vector<uint8_t>> *> entries;
+  entries.reserve(index.size());
+  for (const auto &entry : index) {
+    entries.push_back(&entry);
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const auto *a, const auto *b) { return a->first < b->first; });
+
+  for (const auto *entry : entries) {
+    const std::string &term = entry->first;
+    const std::vector<uint8_t> &data = entry->second;
+
+    uint32_t termLen = term.size();
+    file.write(reinterpret_cast<const char *>(&termLen), sizeof(termLen));
+    file.write(term.c_str(), termLen);
+
+    uint32_t dataSize = data.size();
+    file.write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
+    file.write(reinterpret_cast<const char *>(data.data()), dataSize);
+  }
+  return static_cast<bool>(file);
+}
+
+bool readPostings(std::istream &file, PostingsMap &index) {
+  index = PostingsMap();
+
+  while (file.peek() != EOF) {
+
+    uint32_t termLen;
+    if (!file.read(reinterpret_cast<char *>(&termLen), sizeof(termLen))) {
+      break;
+    }
+
+    std::string term(termLen, 0);
+    file.read(&term[0], termLen);
+
+    uint32_t dataSize;
+    file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+
+    std::vector<uint8_t> data(dataSize);
+    file.read(reinterpret_cast<char *>(data.data()), dataSize);
+
+    index.insert(term, std::move(data));
+  }
+  return true;
+}
+
+bool writePostingsFile(const std::string &path, const PostingsMap &index) {
+  std::ofstream file(path, std::ios::binary);
+  return file.is_open() && writePostings(file, index);
+}
+
+bool readPostingsFile(const std::string &path, PostingsMap &index) {
+  std::ifstream file(path, std::ios::binary);
+  return file.is_open() && readPostings(file, index);
+}
+
+constexpr uint32_t HOT_TIER_MAGIC = 0x31544F48; // "HOT1"
+constexpr uint32_t HOT_TIER_VERSION = 1;
+
+// hot_index.bin — заголовок и списки в формате inverted_index.bin.
+// Заголовок описывает полный индекс, из которого прорежен горячий уровень:
+// после перестроения или перенумерации файл не подходит.
+struct HotTierHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  uint64_t documents;
+  uint64_t totalLength;
+};
+constexpr double STATIC_RANK_SCALE = 1000000.0;
+
+/**
+ * @brief Номер документа в реестре по имени файла <id>.txt, иначе -1
+ */
+int fileStemId(const std::string &fileName) {
+  std::string stem = fs::path(fileName).stem().string();
+  if (stem.empty() ||
+      stem.find_first_not_of("0123456789") != std::string::npos ||
+      stem.size() >= 10) {
+    return -1;
+  }
+  return std::stoi(stem);
+}
+
+/**
+ * @brief Число непустых сегментов пути URL
+ */
+int urlDepth(const std::string &url) {
+  size_t begin = url.find("://");
+  begin = begin == std::string::npos ? 0 : begin + 3;
+  size_t end = url.find_first_of("?#", begin);
+  std::string path = url.substr(begin, end - begin);
+
+  int depth = 0;
+  size_t slash = path.find('/');
+  while (slash != std::string::npos) {
+    size_t next = path.find('/', slash + 1);
+    size_t length =
+        (next == std::string::npos ? path.size() : next) - slash - 1;
+    depth += length > 0 ? 1 : 0;
+    slash = next;
+  }
+  return depth;
+}
+
+} // namespace
+
 size_t Hasher::operator()(const std::string &key) const {
   size_t hash = 0;
   for (unsigned char c : key) {
@@ -31,6 +181,11 @@ SearchEngine::SearchEngine(const std::string &configDir) : m_totalDocsCount(0) {
   m_config.docNamesPath = configDir + "/doc_names.txt";
   m_config.docLengthsPath = configDir + "/doc_lengths.txt";
   m_config.docUrlsPath = configDir + "/urls.txt";
+  m_config.spellIndexPath = configDir + "/spell_index.bin";
+  m_config.docStorePath = configDir + "/doc_store.bin";
+  m_config.docValuesPath = configDir + "/doc_values.bin";
+  m_config.hotIndexPath = configDir + "/hot_index.bin";
+  m_config.championsPath = configDir + "/champions.bin";
 }
 
 SearchEngine::SearchEngine(const std::string &dataDir,
@@ -44,6 +199,11 @@ SearchEngine::SearchEngine(const std::string &dataDir,
   m_config.docNamesPath = indexDir + "/doc_names.txt";
   m_config.docLengthsPath = indexDir + "/doc_lengths.txt";
   m_config.docUrlsPath = indexDir + "/urls.txt";
+  m_config.spellIndexPath = indexDir + "/spell_index.bin";
+  m_config.docStorePath = indexDir + "/doc_store.bin";
+  m_config.docValuesPath = indexDir + "/doc_values.bin";
+  m_config.hotIndexPath = indexDir + "/hot_index.bin";
+  m_config.championsPath = indexDir + "/champions.bin";
 }
 
 bool SearchEngine::initialize() {
@@ -72,7 +232,7 @@ void SearchEngine::run() {
     std::cin >> choice;
     std::cin.ignore();
 
-    if (choice == 4) {
+    if (choice == 6) {
       std::cout << "Exiting...\n";
       break;
     }
@@ -104,6 +264,26 @@ void SearchEngine::run() {
       performTfIdfSearch();
       break;
 
+    case 4:
+      if (m_invertedIndex.size() == 0) {
+        if (!loadIndex()) {
+          std::cout << "No index found. Please rebuild (option 1).\n";
+          continue;
+        }
+      }
+      performBooleanRankedSearch();
+      break;
+
+    case 5:
+      if (m_invertedIndex.size() == 0) {
+        if (!loadIndex()) {
+          std::cout << "No index found. Please rebuild (option 1).\n";
+          continue;
+        }
+      }
+      performAutocomplete();
+      break;
+
     default:
       std::cout << "Invalid choice. Please try again.\n";
     }
@@ -123,18 +303,48 @@ void SearchEngine::indexDocuments() {
   m_invertedIndex = CustomHashMap<std::string, std::vector<uint8_t>>();
   m_docNames = CustomHashMap<int, std::string>();
   m_docLengths = CustomHashMap<int, int>();
+  m_documentStore.clear();
+  m_documentStore.setBlockSize(m_config.docStoreBlockSize);
 
   std::map<std::string, std::vector<std::pair<int, int>>> tempPostings;
+  PostingAccumulator accumulator;
 
   int docId = 0;
   int filesProcessed = 0;
+  std::vector<std::pair<std::string, int64_t>> ordered;
+  std::vector<int64_t> staticRanks;
+  std::vector<std::pair<int, uint64_t>> fingerprints;
+  std::vector<std::pair<int, int>> globalIds;
+  size_t skippedDuplicates = 0;
+
+  // Глобальный docId — позиция в общем порядке документов
+  auto inShard = [this](const std::string &file, int globalId) {
+    if (m_config.shardCount <= 1) {
+      return true;
+    }
+    uint64_t key =
+        m_config.shardBy == ShardBy::Hash
+            ? TextUtils::wordHash(fs::path(file).filename().string())
+            : static_cast<uint64_t>(globalId - 1);
+    return key % m_config.shardCount == m_config.shard;
+  };
+  m_duplicates = DuplicateClusters(m_config.duplicateDistance);
 
   try {
+    std::vector<std::string> files;
     for (const auto &entry : fs::directory_iterator(m_config.dataDir)) {
-      if (entry.path().extension() != ".txt") {
-        continue;
+      if (entry.path().extension() == ".txt") {
+        files.push_back(entry.path().string());
       }
+    }
 
+    ordered = orderDocuments(std::move(files));
+    int globalId = 0;
+    for (const auto &entry : ordered) {
+      const std::string &file = entry.first;
+      if (!inShard(file, ++globalId)) {
+        continue;
+      }
       docId++;
       filesProcessed++;
 
@@ -143,13 +353,36 @@ void SearchEngine::indexDocuments() {
                   << std::flush;
       }
 
-      DocumentStats stats = processDocument(entry.path().string(), docId);
+      DocumentStats stats = processDocument(file, docId);
+
+      if (stats.fingerprinted) {
+        if (m_config.duplicatePolicy == DuplicatePolicy::Skip &&
+            m_duplicates.find(stats.fingerprint) >= 0) {
+          docId--;
+          skippedDuplicates++;
+          continue;
+        }
+        m_duplicates.add(docId, stats.fingerprint);
+        fingerprints.emplace_back(docId, stats.fingerprint);
+      }
+      staticRanks.push_back(entry.second);
+      if (m_config.shardCount > 1) {
+        globalIds.emplace_back(docId, globalId);
+      }
 
       m_docNames.insert(docId, stats.filename);
       m_docLengths.insert(docId, stats.wordCount);
 
+      if (m_config.buildDocStore) {
+        m_documentStore.add(docId, stats.content);
+      }
+
       for (const auto &termFreq : stats.termFrequencies) {
-        tempPostings[termFreq.first].emplace_back(docId, termFreq.second);
+        if (m_config.directPostings) {
+          accumulator.add(termFreq.first, docId, termFreq.second);
+        } else {
+          tempPostings[termFreq.first].emplace_back(docId, termFreq.second);
+        }
       }
     }
   } catch (const std::exception &e) {
@@ -161,27 +394,127 @@ void SearchEngine::indexDocuments() {
   std::cout << "\n\nDocuments processed: " << m_totalDocsCount << "\n";
   std::cout << "Building inverted index...\n";
 
-  int termsProcessed = 0;
-  for (auto &entry : tempPostings) {
-    const std::string &term = entry.first;
-    auto &postings = entry.second;
+  if (m_config.directPostings) {
+    // Списки сжаты уже при обработке документов: остаётся склеить срезы
+    std::cout << "Posting buffers: " << accumulator.memoryUsage()
+              << " bytes\n";
+    size_t inserted = 0;
+    accumulator.finish(
+        [this, &inserted](const std::string &term, std::vector<uint8_t> data) {
+          m_invertedIndex.insert(term, std::move(data));
+          if (++inserted % 1000 == 0) {
+            std::cout << "Compressed " << inserted << " terms...\r"
+                      << std::flush;
+          }
+        });
+  } else {
+    // Списки сортируются и сжимаются по диапазонам терминов, каждый — в свою
+    // заранее выделенную ячейку; вставка идёт по порядку терминов, поэтому
+    // результат не зависит от числа потоков
+    using TermPostings = std::pair<const std::string,
+                                   std::vector<std::pair<int, int>>>;
+    std::vector<TermPostings *> terms;
+    terms.reserve(tempPostings.size());
+    size_t totalPostings = 0;
+    for (auto &entry : tempPostings) {
+      terms.push_back(&entry);
+      totalPostings += entry.second.size();
+    }
+    std::vector<std::vector<uint8_t>> compressed(terms.size());
+
+    size_t threads = m_config.indexThreads > 0
+                         ? m_config.indexThreads
+                         : std::max(1u, std::thread::hardware_concurrency());
+
+    // Диапазонов больше, чем потоков, и они близки по числу postings, чтобы
+    // длинные списки не задерживали один поток
+    std::vector<size_t> bounds = {0};
+    size_t rangePostings = totalPostings / (threads * 4) + 1;
+    size_t accumulated = 0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+      accumulated += terms[i]->second.size();
+      if (accumulated >= rangePostings) {
+        bounds.push_back(i + 1);
+        accumulated = 0;
+      }
+    }
+    if (bounds.back() != terms.size()) {
+      bounds.push_back(terms.size());
+    }
 
-    std::sort(postings.begin(), postings.end());
+    auto compressRange = [&](size_t range) {
+      for (size_t i = bounds[range]; i < bounds[range + 1]; ++i) {
+        auto &postings = terms[i]->second;
+        std::sort(postings.begin(), postings.end());
+        compressed[i] = CompressionUtils::compressPostingList(postings);
+        std::vector<std::pair<int, int>>().swap(postings);
+      }
+    };
+
+    if (threads <= 1) {
+      for (size_t range = 0; range + 1 < bounds.size(); ++range) {
+        compressRange(range);
+      }
+    } else {
+      ThreadPool pool(threads);
+      std::vector<std::future<void>> pending;
+      for (size_t range = 0; range + 1 < bounds.size(); ++range) {
+        pending.push_back(
+            pool.submit([&compressRange, range] { compressRange(range); }));
+      }
+      for (auto &result : pending) {
+        result.get();
+      }
+    }
 
-    std::vector<uint8_t> compressed =
-        CompressionUtils::compressPostingList(postings);
+    for (size_t i = 0; i < terms.size(); ++i) {
+      m_invertedIndex.insert(terms[i]->first, std::move(compressed[i]));
 
-    m_invertedIndex.insert(term, std::move(compressed));
+      if ((i + 1) % 1000 == 0) {
+        std::cout << "Compressed " << i + 1 << " terms...\r" << std::flush;
+      }
+    }
+  }
 
-    termsProcessed++;
-    if (termsProcessed % 1000 == 0) {
-      std::cout << "Compressed " << termsProcessed << " terms...\r"
-                << std::flush;
+  m_documentStore.finish();
+  buildTermDictionary();
+  buildChampionLists();
+  buildFacetIndex();
+  buildDocValues();
+  if (m_config.docOrder != DocOrder::Directory) {
+    DocValuesColumn &ranks = m_docValues.column(STATIC_RANK_FIELD);
+    ranks.clear();
+    for (size_t i = 0; i < staticRanks.size(); ++i) {
+      ranks.add(static_cast<int>(i + 1), staticRanks[i]);
+    }
+    ranks.finish();
+  }
+  if (!fingerprints.empty()) {
+    DocValuesColumn &hashes = m_docValues.column(SIMHASH_FIELD);
+    hashes.clear();
+    for (const auto &entry : fingerprints) {
+      hashes.add(entry.first, static_cast<int64_t>(entry.second));
+    }
+    hashes.finish();
+  }
+  if (!globalIds.empty()) {
+    DocValuesColumn &ids = m_docValues.column(GLOBAL_ID_FIELD);
+    ids.clear();
+    for (const auto &entry : globalIds) {
+      ids.add(entry.first, entry.second);
     }
+    ids.finish();
   }
+  loadStaticScores();
+  buildDuplicateClusters();
+  buildLengthTable();
+  buildPartitions();
+  m_spellIndex.build(m_termDictionary, m_config.spellMaxEdits);
 
   std::cout << "\n\nIndexing completed!\n";
   std::cout << "Total documents: " << m_totalDocsCount << "\n";
+  std::cout << "Near-duplicates: " << m_duplicates.duplicateCount()
+            << " (skipped " << skippedDuplicates << ")\n";
   std::cout << "Total unique terms: " << m_invertedIndex.size() << "\n";
 }
 
@@ -209,33 +542,65 @@ SearchEngine::processDocument(const std::string &filePath, int docId) {
     stats.termFrequencies[token]++;
   }
 
+  // У коротких документов SimHash слишком неустойчив
+  if (m_config.duplicatePolicy != DuplicatePolicy::Keep &&
+      stats.termFrequencies.size() >= m_config.minFingerprintTerms) {
+    stats.fingerprinted = true;
+    stats.fingerprint = simHash(stats.termFrequencies);
+  }
+
+  if (m_config.buildDocStore) {
+    stats.content = std::move(content);
+  }
+
   return stats;
 }
 
 bool SearchEngine::saveIndex() {
   std::cout << "\n=== Saving Index ===\n";
 
-  std::ofstream invFile(m_config.invIndexPath, std::ios::binary);
-  if (!invFile.is_open()) {
+  // Прореженные списки не должны затереть полный индекс
+  if (m_hotTierLoaded) {
+    std::cerr << "Error: Hot tier is loaded, full index is not in memory\n";
+    return false;
+  }
+
+  if (!writePostingsFile(m_config.invIndexPath, m_invertedIndex)) {
     std::cerr << "Error: Cannot save inverted index to "
               << m_config.invIndexPath << std::endl;
     return false;
   }
+  std::cout << "Inverted index saved: " << m_config.invIndexPath << "\n";
 
-  for (auto &entry : m_invertedIndex) {
-    const std::string &term = entry.first;
-    const std::vector<uint8_t> &data = entry.second;
+  // Горячий уровень прорежен из прежнего индекса
+  std::error_code error;
+  fs::remove(m_config.hotIndexPath, error);
 
-    uint32_t termLen = term.size();
-    invFile.write(reinterpret_cast<const char *>(&termLen), sizeof(termLen));
-    invFile.write(term.c_str(), termLen);
+  if (!m_spellIndex.save(m_config.spellIndexPath)) {
+    std::cerr << "Warning: Cannot save spelling index\n";
+  }
 
-    uint32_t dataSize = data.size();
-    invFile.write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
-    invFile.write(reinterpret_cast<const char *>(data.data()), dataSize);
+  if (!m_championLists.empty() &&
+      !m_championLists.save(m_config.championsPath)) {
+    std::cerr << "Warning: Cannot save champion lists\n";
+  }
+
+  if (!m_documentStore.empty()) {
+    if (m_documentStore.save(m_config.docStorePath, indexFingerprint())) {
+      std::cout << "Document store saved: " << m_config.docStorePath << " ("
+                << m_documentStore.compressedSize() << " of "
+                << m_documentStore.rawSize() << " bytes)\n";
+    } else {
+      std::cerr << "Warning: Cannot save document store\n";
+    }
+  }
+
+  if (m_docValues.save(m_config.docValuesPath)) {
+    std::cout << "Doc values saved: " << m_config.docValuesPath << " ("
+              << m_docValues.fields().size() << " fields)\n";
+  } else {
+    std::cerr << "Warning: Cannot save doc values\n";
   }
-  invFile.close();
-  std::cout << "Inverted index saved: " << m_config.invIndexPath << "\n";
 
   std::ofstream lenFile(m_config.docLengthsPath);
   if (!lenFile.is_open()) {
@@ -266,45 +631,110 @@ bool SearchEngine::saveIndex() {
 bool SearchEngine::loadIndex() {
   std::cout << "\n=== Loading Index ===\n";
 
-  std::ifstream invFile(m_config.invIndexPath, std::ios::binary);
-  if (!invFile.is_open()) {
+  m_hotTierLoaded = false;
+  if (!readPostingsFile(m_config.invIndexPath, m_invertedIndex)) {
     std::cerr << "Error: Cannot load inverted index from "
               << m_config.invIndexPath << std::endl;
     return false;
   }
+  std::cout << "Inverted index loaded: " << m_invertedIndex.size()
+            << " terms\n";
 
-  m_invertedIndex = CustomHashMap<std::string, std::vector<uint8_t>>();
+  // Длины документов нужны словарю для границ оценки терминов
+  if (!loadIndexMetadata()) {
+    return false;
+  }
 
-  while (invFile.peek() != EOF) {
+  buildTermDictionary();
 
-    uint32_t termLen;
-    if (!invFile.read(reinterpret_cast<char *>(&termLen), sizeof(termLen))) {
-      break;
-    }
+  if (!m_spellIndex.load(m_config.spellIndexPath, m_termDictionary)) {
+    m_spellIndex.build(m_termDictionary, m_config.spellMaxEdits);
+  }
 
-    std::string term(termLen, 0);
-    invFile.read(&term[0], termLen);
+  if (m_config.championListSize == 0 ||
+      !m_championLists.load(m_config.championsPath, m_termDictionary,
+                            m_config.championListSize)) {
+    buildChampionLists();
+  }
 
-    uint32_t dataSize;
-    invFile.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
+  if (fs::exists(m_config.docStorePath) &&
+      !m_documentStore.load(m_config.docStorePath, indexFingerprint())) {
+    std::cerr << "Warning: Document store was built for another index\n";
+    m_documentStore.clear();
+  }
 
-    std::vector<uint8_t> data(dataSize);
-    invFile.read(reinterpret_cast<char *>(data.data()), dataSize);
+  m_totalDocsCount = m_docLengths.size();
+  buildFacetIndex();
+  if (!m_docValues.load(m_config.docValuesPath)) {
+    buildDocValues();
+  }
+  loadStaticScores();
+  buildDuplicateClusters();
+  buildLengthTable();
+
+  // Словарь уже построен по полному индексу: df и idf не меняются.
+  // Чемпионы выбраны из полных списков, и первая страница разошлась бы с
+  // остальными, поэтому с горячим уровнем они не используются
+  if (m_config.useHotTier && loadHotTier()) {
+    m_championLists.clear();
+  }
+  buildPartitions();
+
+  std::cout << "Total documents: " << m_totalDocsCount << "\n";
+  std::cout << "Index loaded successfully!\n";
 
-    m_invertedIndex.insert(term, std::move(data));
+  return true;
+}
+
+bool SearchEngine::loadHotTier() {
+  std::ifstream file(m_config.hotIndexPath, std::ios::binary);
+  HotTierHeader header;
+  if (!file.is_open() ||
+      !file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
   }
-  invFile.close();
-  std::cout << "Inverted index loaded: " << m_invertedIndex.size()
-            << " terms\n";
 
-  if (!loadIndexMetadata()) {
+  // Чужой горячий уровень вернул бы docId, которых нет в индексе
+  if (header.magic != HOT_TIER_MAGIC || header.version != HOT_TIER_VERSION ||
+      header.fingerprint != m_termDictionary.fingerprint() ||
+      header.documents != static_cast<uint64_t>(m_totalDocsCount) ||
+      header.totalLength != static_cast<uint64_t>(m_totalLength)) {
+    std::cerr << "Warning: " << m_config.hotIndexPath
+              << " was built for another index, using the full index\n";
     return false;
   }
 
-  m_totalDocsCount = m_docLengths.size();
-  std::cout << "Total documents: " << m_totalDocsCount << "\n";
-  std::cout << "Index loaded successfully!\n";
+  PostingsMap hotIndex;
+  if (!readPostings(file, hotIndex)) {
+    return false;
+  }
+  m_invertedIndex = std::move(hotIndex);
+  m_hotTierLoaded = true;
+  std::cout << "Hot tier loaded: " << m_config.hotIndexPath << "\n";
+  return true;
+}
+
+bool SearchEngine::saveHotTier(const PostingsMap &hotIndex) const {
+  // Прежний файл остаётся целым, пока новый не записан полностью
+  std::string tmpPath = m_config.hotIndexPath + ".tmp";
+  std::ofstream file(tmpPath, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
 
+  HotTierHeader header = {HOT_TIER_MAGIC, HOT_TIER_VERSION,
+                          m_termDictionary.fingerprint(),
+                          static_cast<uint64_t>(m_totalDocsCount),
+                          static_cast<uint64_t>(m_totalLength)};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  bool written = writePostings(file, hotIndex);
+
+  file.close();
+  if (!written || !file ||
+      std::rename(tmpPath.c_str(), m_config.hotIndexPath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
   return true;
 }
 
@@ -343,6 +773,65 @@ bool SearchEngine::loadIndexMetadata() {
 
 bool SearchEngine::saveIndexMetadata() { return true; }
 
+void SearchEngine::buildTermDictionary() {
+  std::vector<std::pair<TermDictionary::Entry, Scoring::TermBounds>> terms;
+  terms.reserve(m_invertedIndex.size());
+
+  for (const auto &entry : m_invertedIndex) {
+    auto postings = CompressionUtils::decompressPostingList(entry.second);
+
+    uint64_t collectionFrequency = 0;
+    Scoring::TermBounds bounds = {0.0, 0.0,
+                                  std::numeric_limits<double>::infinity()};
+    for (const auto &posting : postings) {
+      collectionFrequency += posting.second;
+      bounds.maxTf =
+          std::max(bounds.maxTf, static_cast<double>(posting.second));
+
+      const int *docLenPtr = m_docLengths.find(posting.first);
+      if (docLenPtr && *docLenPtr > 0) {
+        bounds.maxRatio =
+            std::max(bounds.maxRatio,
+                     static_cast<double>(posting.second) / *docLenPtr);
+        bounds.minLength =
+            std::min(bounds.minLength, static_cast<double>(*docLenPtr));
+      }
+    }
+
+    terms.emplace_back(
+        TermDictionary::Entry(entry.first,
+                              static_cast<uint32_t>(postings.size()),
+                              collectionFrequency),
+        bounds);
+  }
+
+  std::sort(terms.begin(), terms.end(), [](const auto &a, const auto &b) {
+    return a.first.term < b.first.term;
+  });
+
+  std::vector<TermDictionary::Entry> entries;
+  entries.reserve(terms.size());
+  m_termBounds.clear();
+  m_termBounds.reserve(terms.size());
+  for (auto &term : terms) {
+    entries.push_back(std::move(term.first));
+    m_termBounds.push_back(term.second);
+  }
+  m_termDictionary.build(entries);
+
+  std::vector<std::pair<std::string, uint64_t>> completions;
+  completions.reserve(entries.size());
+  for (const auto &entry : entries) {
+    completions.emplace_back(entry.term, entry.collectionFrequency);
+  }
+  m_completionTrie.build(completions);
+
+  m_ngramIndex.clear();
+  if (m_config.buildNgramIndex) {
+    m_ngramIndex.build(m_termDictionary);
+  }
+}
+
 bool SearchEngine::loadDictionary() {
   std::ifstream file(m_config.dictPath);
   if (!file.is_open()) {
@@ -369,6 +858,7 @@ bool SearchEngine::loadDocUrls() {
   }
 
   m_docUrls = CustomHashMap<int, std::string>();
+  m_registryFields.clear();
   std::string line;
   int loaded = 0;
 
@@ -387,6 +877,26 @@ bool SearchEngine::loadDocUrls() {
       if (start != std::string::npos) {
         url = url.substr(start);
       }
+
+      // Числовые поля идут после URL через табуляцию: name=value
+      size_t tab = url.find('\t');
+      std::string fields = tab == std::string::npos ? "" : url.substr(tab);
+      url = url.substr(0, tab);
+
+      std::stringstream fieldStream(fields);
+      std::string field;
+      while (std::getline(fieldStream, field, '\t')) {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos || eq == 0) {
+          continue;
+        }
+        char *end = nullptr;
+        long long value = std::strtoll(field.c_str() + eq + 1, &end, 10);
+        if (end != field.c_str() + eq + 1 && *end == '\0') {
+          m_registryFields[field.substr(0, eq)].insert(id, value);
+        }
+      }
+
       m_docUrls.insert(id, url);
       loaded++;
     }
@@ -398,10 +908,18 @@ bool SearchEngine::loadDocUrls() {
 
 void SearchEngine::performBooleanSearch() {
   std::cout << "\n=== BOOLEAN SEARCH ===\n";
-  std::cout << "Syntax: +required -excluded optional\n";
-  std::cout << "Type 'exit' to return to main menu\n\n";
+  std::cout << "Syntax: +required -excluded optional, (a OR b) AND NOT c, "
+               "site:host, field:lo..hi (prefix*, *infix*, wild?card, "
+               "fuzzy~1)\n";
+  std::cout << "Ranges: download_timestamp:7d.. (last 7 days), "
+               "download_timestamp:2024-01-01..2024-01-31\n";
+  std::cout << "Type 'n' for the next page, 'exit' to return to main menu\n\n";
 
   std::string queryStr;
+  std::string lastQuery;
+  ResultCount lastCount;
+  int cursor = 0;
+  bool hasMore = false;
 
   while (true) {
     std::cout << "Bool Query: ";
@@ -415,169 +933,1093 @@ void SearchEngine::performBooleanSearch() {
       break;
     }
 
+    if (queryStr == "n") {
+      if (!hasMore) {
+        std::cout << "No more results.\n\n";
+        continue;
+      }
+      BooleanPage page =
+          searchBooleanPage(lastQuery, cursor, m_config.topKResults);
+      cursor = page.next;
+      hasMore = page.hasMore;
+      displaySearchResults(page.docIds, lastCount, lastQuery, hasMore);
+      std::cout << "\n";
+      continue;
+    }
+
     if (queryStr.empty()) {
       std::cout << "Results: No documents match.\n\n";
       continue;
     }
 
-    BooleanQuery query = parseBooleanQuery(queryStr);
+    BooleanPage page;
+    try {
+      lastCount = countBoolean(queryStr);
+      page = searchBooleanPage(queryStr, 0, m_config.topKResults);
+    } catch (const std::invalid_argument &e) {
+      std::cout << "Query error: " << e.what() << "\n\n";
+      hasMore = false;
+      continue;
+    }
 
-    std::vector<int> results = executeBooleanQuery(query);
+    lastQuery = queryStr;
+    cursor = page.next;
+    hasMore = page.hasMore;
+    displaySearchResults(page.docIds, lastCount, queryStr, hasMore);
+
+    if (m_config.facetLimit > 0 && !page.docIds.empty() &&
+        !m_hostFacets.empty()) {
+      // Если ни у одного результата нет URL, строку не выводим
+      auto facets = hostFacets(queryStr, m_config.facetLimit);
+      if (!facets.empty()) {
+        std::cout << "Sites:";
+        for (const auto &facet : facets) {
+          std::cout << " " << facet.value << " (" << facet.count << ")";
+        }
+        std::cout << "\n";
+      }
+    }
 
-    displaySearchResults(results);
+    if (page.docIds.empty()) {
+      std::string suggestion = suggestQuery(queryStr);
+      if (!suggestion.empty()) {
+        std::cout << "\nDid you mean: " << suggestion << " ?";
+      }
+    }
     std::cout << "\n";
   }
 }
 
-SearchEngine::BooleanQuery
-SearchEngine::parseBooleanQuery(const std::string &queryStr) const {
-
-  BooleanQuery query;
-  std::stringstream ss(queryStr);
-  std::string token;
-
-  while (ss >> token) {
-    char prefix = ' ';
-    std::string rawWord = token;
+SearchEngine::BooleanPage
+SearchEngine::searchBooleanPage(const std::string &queryStr, int afterDocId,
+                                size_t pageSize) const {
+  QueryNode plan = parseQuery(queryStr);
 
-    if (token.size() > 1 && (token[0] == '+' || token[0] == '-')) {
-      prefix = token[0];
-      rawWord = token.substr(1);
-    }
+  auto iterator = compilePlan(plan);
 
-    std::vector<std::string> parsed = TextUtils::tokenize(rawWord);
-    if (parsed.empty()) {
-      continue;
-    }
+  BooleanPage page;
+  page.next = afterDocId;
 
-    std::string term = parsed[0];
+  if (pageSize == 0 ||
+      iterator->advance(afterDocId + 1) == DocIterator::NO_MORE_DOCS) {
+    return page;
+  }
 
-    if (prefix == '+') {
-      query.requiredTerms.push_back(term);
-    } else if (prefix == '-') {
-      query.excludedTerms.push_back(term);
-    } else {
-      query.optionalTerms.push_back(term);
-    }
+  page.docIds.push_back(iterator->docId());
+  page.docIds.reserve(pageSize);
+  while (page.docIds.size() < pageSize &&
+         iterator->next() != DocIterator::NO_MORE_DOCS) {
+    page.docIds.push_back(iterator->docId());
   }
 
-  return query;
+  page.next = page.docIds.back();
+  page.hasMore = iterator->next() != DocIterator::NO_MORE_DOCS;
+  return page;
 }
 
-std::set<int> SearchEngine::getDocumentsForTerm(const std::string &term) const {
-  std::set<int> docIds;
+std::unique_ptr<DocIterator>
+SearchEngine::compilePlan(const QueryNode &plan,
+                          const SkipLookup &skips) const {
+  return QueryPlan::compile(
+      plan,
+      [this](const std::string &term) { return getPostingListsForTerm(term); },
+      [this](const std::string &field,
+             const std::string &value) -> std::unique_ptr<DocIterator> {
+        if (field == "site") {
+          return QueryPlan::iterate(m_hostFacets.documents(value));
+        }
+        int64_t min = 0;
+        int64_t max = 0;
+        const DocValuesColumn *column = findRangeFilter(field, value, min, max);
+        return column ? column->range(min, max) : nullptr;
+      },
+      skips);
+}
+
+SkipLookup SearchEngine::partitionSkips(size_t partition) const {
+  return [this, partition](const std::vector<uint8_t> *list) {
+    auto it = m_rangeSkips.find(list);
+    return it == m_rangeSkips.end() ? PostingIterator::Position()
+                                    : it->second[partition];
+  };
+}
 
-  const std::vector<uint8_t> *data = m_invertedIndex.find(term);
-  if (!data) {
-    return docIds;
+void SearchEngine::forEachPartition(
+    const std::function<void(size_t)> &task) const {
+  std::vector<std::future<void>> pending;
+  for (size_t partition = 1; partition < queryPartitions(); ++partition) {
+    pending.push_back(
+        m_workers->submit([&task, partition] { task(partition); }));
   }
 
-  auto postings = CompressionUtils::decompressPostingList(*data);
-  for (const auto &posting : postings) {
-    docIds.insert(posting.first);
+  // Диапазон 0 обходит вызывающий поток; задачи ссылаются на task, поэтому
+  // исключение пробрасывается только после завершения всех диапазонов
+  std::exception_ptr error;
+  try {
+    task(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto &result : pending) {
+    try {
+      result.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
   }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
 
-  return docIds;
+const DocValuesColumn *
+SearchEngine::findRangeFilter(const std::string &field,
+                              const std::string &value, int64_t &min,
+                              int64_t &max) const {
+  const DocValuesColumn *column = m_docValues.find(field);
+  if (!column || !parseRangeFilter(value, std::time(nullptr), min, max)) {
+    return nullptr;
+  }
+  return column;
 }
 
-std::vector<int>
-SearchEngine::executeBooleanQuery(const BooleanQuery &query) const {
+std::vector<int> SearchEngine::searchBoolean(const std::string &queryStr,
+                                             size_t limit) const {
+  QueryNode plan = parseQuery(queryStr);
 
-  std::set<int> candidateSet;
-  bool hasCandidates = false;
+  if (queryPartitions() == 1) {
+    auto iterator = compilePlan(plan);
+    return QueryPlan::collect(*iterator, limit);
+  }
 
-  if (query.hasRequiredTerms()) {
-    for (const auto &term : query.requiredTerms) {
-      std::set<int> termDocs = getDocumentsForTerm(term);
+  // Каждый диапазон отдаёт не больше limit документов; диапазоны идут по
+  // возрастанию docId, поэтому склейка упорядочена
+  std::vector<std::vector<int>> ranges(queryPartitions());
+  forEachPartition([&](size_t partition) {
+    SkipLookup skips = partitionSkips(partition);
+    auto iterator = QueryPlan::clip(compilePlan(plan, skips),
+                                    m_partitionBounds[partition],
+                                    m_partitionBounds[partition + 1]);
+    ranges[partition] = QueryPlan::collect(*iterator, limit);
+  });
+
+  std::vector<int> docIds;
+  for (const auto &range : ranges) {
+    docIds.insert(docIds.end(), range.begin(), range.end());
+    if (docIds.size() >= limit) {
+      docIds.resize(limit);
+      break;
+    }
+  }
+  return docIds;
+}
 
-      if (termDocs.empty()) {
+SearchEngine::ResultCount
+SearchEngine::countBoolean(const std::string &queryStr) const {
+  QueryNode plan = parseQuery(queryStr);
+  ResultCount result;
+
+  // В горячем уровне список термина короче df словаря: число совпадений
+  // считается по списку, который обходит выдача
+  if (plan.type == QueryNode::Type::Term && !isExpandedTerm(plan.term) &&
+      !(m_hotTierLoaded && m_invertedIndex.count(plan.term))) {
+    result.count = estimateDocFrequency(plan.term);
+    return result;
+  }
 
-        return std::vector<int>();
+  // Объединение терминов: считаем размеры списков по байтам-терминаторам,
+  // не распаковывая их
+  bool termUnion = plan.type == QueryNode::Type::Term ||
+                   (plan.type == QueryNode::Type::Or &&
+                    std::all_of(plan.children.begin(), plan.children.end(),
+                                [](const QueryNode &child) {
+                                  return child.type == QueryNode::Type::Term;
+                                }));
+  if (termUnion) {
+    std::vector<const std::vector<uint8_t> *> lists;
+    auto addLists = [&](const std::string &term) {
+      for (const auto *list : getPostingListsForTerm(term)) {
+        if (list && !list->empty()) {
+          lists.push_back(list);
+        }
       }
+    };
 
-      if (!hasCandidates) {
-        candidateSet = std::move(termDocs);
-        hasCandidates = true;
-      } else {
-
-        std::set<int> intersection;
-        std::set_intersection(
-            candidateSet.begin(), candidateSet.end(), termDocs.begin(),
-            termDocs.end(), std::inserter(intersection, intersection.begin()));
-        candidateSet = std::move(intersection);
+    if (plan.type == QueryNode::Type::Term) {
+      addLists(plan.term);
+    } else {
+      for (const auto &child : plan.children) {
+        addLists(child.term);
       }
+    }
 
-      if (candidateSet.empty()) {
-        return std::vector<int>();
-      }
+    size_t totalPostings = 0;
+    for (const auto *list : lists) {
+      totalPostings += CompressionUtils::countPostings(*list);
     }
-  }
 
-  if (!query.hasRequiredTerms() && query.hasOptionalTerms()) {
-    for (const auto &term : query.optionalTerms) {
-      std::set<int> termDocs = getDocumentsForTerm(term);
-      candidateSet.insert(termDocs.begin(), termDocs.end());
+    if (lists.size() == 1) {
+      result.count = totalPostings;
+      return result;
+    }
+    if (totalPostings > m_config.countSampleThreshold) {
+      return estimateUnionCount(lists, totalPostings);
     }
-    hasCandidates = true;
   }
 
-  if (!hasCandidates) {
-    return std::vector<int>();
+  if (plan.type == QueryNode::Type::And && plan.children.size() == 2 &&
+      plan.children[1].type != QueryNode::Type::Not) {
+    result.count = evaluateBitmap(plan.children[0])
+                       .andCardinality(evaluateBitmap(plan.children[1]));
+    return result;
   }
 
-  if (!query.excludedTerms.empty()) {
-    std::set<int> excludedDocs;
-    for (const auto &term : query.excludedTerms) {
-      std::set<int> termDocs = getDocumentsForTerm(term);
-      excludedDocs.insert(termDocs.begin(), termDocs.end());
-    }
+  result.count = evaluateBitmap(plan).cardinality();
+  return result;
+}
 
-    std::set<int> filteredSet;
-    std::set_difference(candidateSet.begin(), candidateSet.end(),
-                        excludedDocs.begin(), excludedDocs.end(),
-                        std::inserter(filteredSet, filteredSet.begin()));
-    candidateSet = std::move(filteredSet);
-  }
+std::vector<FacetIndex::FacetCount>
+SearchEngine::hostFacets(const std::string &queryStr, size_t limit) const {
+  return m_hostFacets.counts(evaluateBitmap(parseQuery(queryStr)), limit);
+}
 
-  if (query.hasRequiredTerms()) {
-    std::vector<int> verified;
-    for (int docId : candidateSet) {
-      if (verifyRequiredTermsInDocument(docId, query.requiredTerms)) {
-        verified.push_back(docId);
+void SearchEngine::buildDocValues() {
+  m_docValues.clear();
+
+  for (const auto &entry : m_registryFields) {
+    DocValuesColumn &column = m_docValues.column(entry.first);
+    for (long long docId = 1; docId <= m_totalDocsCount; ++docId) {
+      const int64_t *value =
+          entry.second.find(registryId(static_cast<int>(docId)));
+      if (value) {
+        column.add(static_cast<int>(docId), *value);
       }
     }
-    return verified;
   }
-
-  return std::vector<int>(candidateSet.begin(), candidateSet.end());
+  m_docValues.finish();
 }
 
-bool SearchEngine::verifyRequiredTermsInDocument(
-    int docId, const std::vector<std::string> &terms) const {
+void SearchEngine::setDocOrder(DocOrder order, double staticWeight) {
+  m_config.docOrder = order;
+  m_config.staticWeight = staticWeight;
+}
 
-  std::string docPath = getDocumentPath(docId);
-  std::string content = FileUtils::readFileContent(docPath);
+std::vector<std::pair<std::string, int64_t>>
+SearchEngine::orderDocuments(std::vector<std::string> files) const {
+  std::vector<std::pair<std::string, int64_t>> ordered;
+  ordered.reserve(files.size());
 
-  if (content.empty()) {
-    return false;
+  if (m_config.docOrder == DocOrder::Directory) {
+    for (auto &file : files) {
+      ordered.emplace_back(std::move(file), 0);
+    }
+    return ordered;
   }
 
-  std::string lowerContent = TextUtils::toLowerCase(content);
+  auto timestamps = m_registryFields.find("download_timestamp");
+  std::vector<double> raw(files.size());
+  std::vector<bool> known(files.size(), true);
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    int id = fileStemId(files[i]);
+
+    switch (m_config.docOrder) {
+    case DocOrder::Recency: {
+      const int64_t *timestamp =
+          id >= 0 && timestamps != m_registryFields.end()
+              ? timestamps->second.find(id)
+              : nullptr;
+      known[i] = timestamp != nullptr;
+      raw[i] = timestamp ? static_cast<double>(*timestamp) : 0.0;
+      break;
+    }
+    case DocOrder::UrlDepth: {
+      const std::string *url = id >= 0 ? m_docUrls.find(id) : nullptr;
+      known[i] = url != nullptr;
+      raw[i] = url ? -urlDepth(*url) : 0.0;
+      break;
+    }
+    case DocOrder::Length: {
+      std::error_code error;
+      raw[i] = static_cast<double>(fs::file_size(files[i], error));
+      known[i] = !error;
+      break;
+    }
+    case DocOrder::Directory:
+      break;
+    }
+  }
 
-  for (const std::string &term : terms) {
-    if (lowerContent.find(term) == std::string::npos) {
-      return false;
+  // Нормируем в [0, 1]; документы без оценки считаются худшими
+  double low = std::numeric_limits<double>::max();
+  double high = std::numeric_limits<double>::lowest();
+  for (size_t i = 0; i < raw.size(); ++i) {
+    if (known[i]) {
+      low = std::min(low, raw[i]);
+      high = std::max(high, raw[i]);
     }
   }
 
-  return true;
+  for (size_t i = 0; i < files.size(); ++i) {
+    double normalized = !known[i]      ? 0.0
+                        : high > low   ? (raw[i] - low) / (high - low)
+                                       : 1.0;
+    ordered.emplace_back(std::move(files[i]),
+                         std::llround(normalized * STATIC_RANK_SCALE));
+  }
+
+  std::sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b) {
+    return a.second > b.second || (a.second == b.second && a.first < b.first);
+  });
+  return ordered;
 }
 
-void SearchEngine::performTfIdfSearch() {
-  std::cout << "\n=== TF-IDF SEARCH ===\n";
-  std::cout << "Type 'exit' to return to main menu\n\n";
+void SearchEngine::loadStaticScores() {
+  m_staticScores.clear();
+  m_staticOrdered = false;
 
-  std::string queryStr;
+  const DocValuesColumn *ranks = m_docValues.find(STATIC_RANK_FIELD);
+  if (!ranks || m_totalDocsCount <= 0) {
+    return;
+  }
+
+  m_staticScores.assign(static_cast<size_t>(m_totalDocsCount) + 1, 0.0);
+  m_staticOrdered = true;
+  for (long long docId = 1; docId <= m_totalDocsCount; ++docId) {
+    int64_t rank = 0;
+    if (ranks->get(static_cast<int>(docId), rank)) {
+      m_staticScores[docId] = rank / STATIC_RANK_SCALE;
+    }
+    if (m_staticScores[docId] > m_staticScores[docId - 1] && docId > 1) {
+      m_staticOrdered = false;
+    }
+  }
+}
+
+SearchEngine::PruneStats
+SearchEngine::pruneIndex(PruneMethod method, double level,
+                         const std::vector<std::string> &queries, size_t k) {
+  if (!(level >= 0.0 && level <= 1.0)) {
+    throw std::invalid_argument("Pruning level must be in [0, 1]");
+  }
+
+  PruneStats stats;
+  std::vector<std::string> terms;
+  std::vector<std::vector<std::pair<int, int>>> postings;
+  std::vector<IndexPruning::ScoredList> lists;
+
+  for (const auto &entry : m_invertedIndex) {
+    terms.push_back(entry.first);
+    postings.push_back(CompressionUtils::decompressPostingList(entry.second));
+    stats.bytesBefore += entry.second.size();
+
+    const auto &termPostings = postings.back();
+    IndexPruning::ScoredList list;
+    list.reserve(termPostings.size());
+    withScoringPolicy(m_config.scoringModel, [&](auto policy) {
+      using Policy = decltype(policy);
+      double weight = Policy::weight(
+          static_cast<double>(std::max<size_t>(termPostings.size(), 1)),
+          static_cast<double>(m_totalDocsCount));
+
+      for (const auto &posting : termPostings) {
+        const int *docLength = m_docLengths.find(posting.first);
+        double score =
+            docLength && *docLength > 0
+                ? Policy::score(weight, static_cast<double>(posting.second),
+                                static_cast<double>(*docLength),
+                                m_averageLength)
+                : 0.0;
+        list.push_back({posting.first, score});
+      }
+    });
+    stats.postingsBefore += list.size();
+    lists.push_back(std::move(list));
+  }
+
+  auto keep = method == PruneMethod::TermCentric
+                  ? IndexPruning::termCentric(lists, k, level)
+                  : IndexPruning::documentCentric(lists, level);
+
+  PostingsMap hotIndex;
+  for (size_t term = 0; term < terms.size(); ++term) {
+    std::vector<std::pair<int, int>> kept;
+    for (size_t i = 0; i < postings[term].size(); ++i) {
+      if (keep[term][i]) {
+        kept.push_back(postings[term][i]);
+      }
+    }
+    stats.postingsAfter += kept.size();
+
+    std::vector<uint8_t> data = CompressionUtils::compressPostingList(kept);
+    stats.bytesAfter += data.size();
+    hotIndex.insert(terms[term], std::move(data));
+  }
+
+  stats.saved = saveHotTier(hotIndex);
+  if (!stats.saved) {
+    std::cerr << "Error: Cannot save hot tier to " << m_config.hotIndexPath
+              << std::endl;
+    return stats;
+  }
+
+  // Чемпионы построены по полному индексу и не читают m_invertedIndex:
+  // обе выдачи считаются по спискам, иначе recall не зависел бы от
+  // прореживания
+  auto topDocs = [this, k](const std::string &query) {
+    std::vector<int> docs;
+    for (const auto &result :
+         rankTfIdfPage(query, RankCursor(), k, false).results) {
+      docs.push_back(result.docId);
+    }
+    return docs;
+  };
+
+  std::vector<std::vector<int>> expected;
+  for (const auto &query : queries) {
+    expected.push_back(topDocs(query));
+  }
+
+  // Словарь и границы оценок остаются от полного индекса, как и при
+  // загрузке горячего уровня
+  std::swap(m_invertedIndex, hotIndex);
+  double totalRecall = 0.0;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (expected[i].empty()) {
+      continue;
+    }
+    totalRecall += IndexPruning::recall(expected[i], topDocs(queries[i]));
+    stats.queries++;
+  }
+  std::swap(m_invertedIndex, hotIndex);
+
+  if (stats.queries > 0) {
+    stats.recall = totalRecall / stats.queries;
+  }
+  return stats;
+}
+
+void SearchEngine::buildChampionLists() {
+  m_championLists.clear();
+  if (m_config.championListSize == 0) {
+    return;
+  }
+
+  m_championLists.reset(m_config.championListSize, m_termDictionary);
+  std::vector<double> scores;
+
+  auto addList = [&](size_t, const std::string &term) {
+    const std::vector<uint8_t> *data = m_invertedIndex.find(term);
+    auto postings = CompressionUtils::decompressPostingList(*data);
+
+    scores.clear();
+    for (const auto &posting : postings) {
+      const int *docLength = m_docLengths.find(posting.first);
+      scores.push_back(docLength && *docLength > 0
+                           ? static_cast<double>(posting.second) / *docLength
+                           : 0.0);
+    }
+    m_championLists.add(postings, scores);
+    return true;
+  };
+  m_termDictionary.forEach(0, m_termDictionary.size(), addList);
+}
+
+uint64_t SearchEngine::indexFingerprint() const {
+  // Сумма не зависит от порядка обхода таблицы длин, а перенумерация
+  // документов меняет пары (docId, длина)
+  uint64_t fingerprint = m_termDictionary.fingerprint();
+  for (const auto &entry : m_docLengths) {
+    uint64_t pair = (static_cast<uint64_t>(entry.first) << 32) ^
+                    static_cast<uint32_t>(entry.second);
+    pair *= 0x9E3779B97F4A7C15ULL;
+    fingerprint += pair ^ (pair >> 29);
+  }
+  return fingerprint;
+}
+
+void SearchEngine::buildLengthTable() {
+  int maxDocId = 0;
+  for (const auto &entry : m_docLengths) {
+    maxDocId = std::max(maxDocId, entry.first);
+  }
+
+  m_lengthTable.assign(static_cast<size_t>(maxDocId) + 1, 0.0);
+  double totalLength = 0.0;
+  for (const auto &entry : m_docLengths) {
+    if (entry.first >= 0) {
+      m_lengthTable[entry.first] = entry.second;
+      totalLength += entry.second;
+    }
+  }
+
+  m_totalLength = totalLength;
+  m_averageLength = m_docLengths.size() > 0 && totalLength > 0.0
+                        ? totalLength / m_docLengths.size()
+                        : 1.0;
+}
+
+void SearchEngine::setQueryPartitions(size_t partitions) {
+  m_config.queryPartitions = std::max<size_t>(partitions, 1);
+  // Диапазон 0 обходит вызывающий поток
+  m_workers = m_config.queryPartitions > 1
+                  ? std::make_unique<ThreadPool>(m_config.queryPartitions - 1)
+                  : nullptr;
+  buildPartitions();
+}
+
+void SearchEngine::buildPartitions() {
+  m_partitionBounds.clear();
+  m_rangeSkips.clear();
+
+  size_t partitions = m_config.queryPartitions;
+  size_t maxDocId = m_lengthTable.empty() ? 0 : m_lengthTable.size() - 1;
+  if (partitions <= 1 || maxDocId < partitions) {
+    return;
+  }
+
+  // Равные по docId диапазоны покрывают 1..maxDocId
+  for (size_t partition = 0; partition <= partitions; ++partition) {
+    m_partitionBounds.push_back(
+        1 + static_cast<int>(maxDocId * partition / partitions));
+  }
+
+  // Короткие списки каждый диапазон читает с начала
+  for (const auto &entry : m_invertedIndex) {
+    const std::vector<uint8_t> &data = entry.second;
+    if (CompressionUtils::countPostings(data) < m_config.minSkipPostings) {
+      continue;
+    }
+
+    std::vector<PostingIterator::Position> positions(partitions);
+    PostingIterator postings(&data);
+    size_t partition = 1;
+    while (partition < partitions) {
+      PostingIterator::Position before = postings.position();
+      int docId = postings.next();
+      while (partition < partitions &&
+             docId >= m_partitionBounds[partition]) {
+        positions[partition++] = before;
+      }
+    }
+    m_rangeSkips.emplace(&data, std::move(positions));
+  }
+}
+
+void SearchEngine::buildDuplicateClusters() {
+  m_duplicates = DuplicateClusters(m_config.duplicateDistance);
+
+  const DocValuesColumn *hashes = m_docValues.find(SIMHASH_FIELD);
+  if (!hashes) {
+    return;
+  }
+  for (long long docId = 1; docId <= m_totalDocsCount; ++docId) {
+    int64_t fingerprint = 0;
+    if (hashes->get(static_cast<int>(docId), fingerprint)) {
+      m_duplicates.add(static_cast<int>(docId),
+                       static_cast<uint64_t>(fingerprint));
+    }
+  }
+}
+
+size_t SearchEngine::duplicateClusterSize(int docId) const {
+  return m_duplicates.clusterSize(m_duplicates.representative(docId));
+}
+
+int SearchEngine::duplicateCluster(int docId) const {
+  int representative = m_duplicates.representative(docId);
+  if (representative == docId && m_duplicates.clusterSize(docId) == 1) {
+    return -1;
+  }
+  return representative;
+}
+
+void SearchEngine::collapseDuplicates(
+    std::vector<ScoredDocument> &scores) const {
+  // Позиция лучшего совпавшего документа каждого кластера
+  std::unordered_map<int, size_t> best;
+  std::vector<uint8_t> dropped(scores.size(), 0);
+  for (size_t i = 0; i < scores.size(); ++i) {
+    int cluster = duplicateCluster(scores[i].docId);
+    if (cluster < 0) {
+      continue;
+    }
+    auto inserted = best.emplace(cluster, i);
+    if (inserted.second) {
+      continue;
+    }
+
+    size_t &current = inserted.first->second;
+    const ScoredDocument &candidate = scores[i];
+    const ScoredDocument &kept = scores[current];
+    if (candidate.score > kept.score ||
+        (candidate.score == kept.score && candidate.docId < kept.docId)) {
+      dropped[current] = 1;
+      current = i;
+    } else {
+      dropped[i] = 1;
+    }
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < scores.size(); ++i) {
+    if (!dropped[i]) {
+      scores[count++] = scores[i];
+    }
+  }
+  scores.resize(count);
+}
+
+double SearchEngine::minScore() const {
+  // Порог подобран под масштаб TF-IDF; у BM25 и Count масштаб другой
+  return m_config.scoringModel == ScoringModel::TfIdf ? m_config.minTfIdfScore
+                                                      : 0.0;
+}
+
+double SearchEngine::staticPrior(int docId) const {
+  if (docId <= 0 || static_cast<size_t>(docId) >= m_staticScores.size()) {
+    return 0.0;
+  }
+  return m_config.staticWeight * m_staticScores[docId];
+}
+
+std::vector<int>
+SearchEngine::reorderPermutation(ReorderMethod method) const {
+  size_t count = static_cast<size_t>(std::max(m_totalDocsCount, 0LL));
+  std::vector<int> order(count);
+  std::iota(order.begin(), order.end(), 1);
+
+  if (method == ReorderMethod::Url) {
+    // Ключ — хост без www. и путь; документы без URL идут в конце
+    std::vector<std::string> keys(count + 1);
+    for (size_t docId = 1; docId <= count; ++docId) {
+      const std::string *url = findDocumentUrl(static_cast<int>(docId));
+      if (url) {
+        size_t scheme = url->find("://");
+        size_t path =
+            url->find('/', scheme == std::string::npos ? 0 : scheme + 3);
+        keys[docId] = extractHost(*url) +
+                      (path == std::string::npos ? "" : url->substr(path));
+      } else {
+        const std::string *name = m_docNames.find(static_cast<int>(docId));
+        keys[docId] = "\xff" + (name ? *name : std::string());
+      }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](int a, int b) { return keys[a] < keys[b]; });
+    return order;
+  }
+
+  // Термины из одного документа не влияют на разности docId
+  std::vector<std::vector<uint32_t>> forward(count);
+  uint32_t termCount = 0;
+  for (const auto &entry : m_invertedIndex) {
+    auto postings = CompressionUtils::decompressPostingList(entry.second);
+    if (postings.size() < 2) {
+      continue;
+    }
+    for (const auto &posting : postings) {
+      if (posting.first >= 1 && static_cast<size_t>(posting.first) <= count) {
+        forward[posting.first - 1].push_back(termCount);
+      }
+    }
+    termCount++;
+  }
+
+  std::vector<uint32_t> bisected =
+      DocReorder::graphBisection(forward, termCount);
+  for (size_t i = 0; i < count; ++i) {
+    order[i] = static_cast<int>(bisected[i]) + 1;
+  }
+  return order;
+}
+
+SearchEngine::ReorderStats
+SearchEngine::reorderDocuments(ReorderMethod method) {
+  ReorderStats stats;
+  for (const auto &entry : m_invertedIndex) {
+    stats.postings += CompressionUtils::countPostings(entry.second);
+    stats.bytesBefore += entry.second.size();
+  }
+
+  std::vector<int> order = reorderPermutation(method);
+  std::vector<int> newIds(order.size() + 1, 0);
+
+  // Горячий уровень остаётся в старой нумерации
+  std::error_code error;
+  fs::remove(m_config.hotIndexPath, error);
+  for (size_t i = 0; i < order.size(); ++i) {
+    newIds[order[i]] = static_cast<int>(i) + 1;
+  }
+
+  for (auto &entry : m_invertedIndex) {
+    auto postings = CompressionUtils::decompressPostingList(entry.second);
+    for (auto &posting : postings) {
+      if (posting.first >= 1 &&
+          static_cast<size_t>(posting.first) < newIds.size()) {
+        posting.first = newIds[posting.first];
+      }
+    }
+    std::sort(postings.begin(), postings.end());
+    entry.second = CompressionUtils::compressPostingList(postings);
+    stats.bytesAfter += entry.second.size();
+  }
+
+  CustomHashMap<int, std::string> names;
+  CustomHashMap<int, int> lengths;
+  for (size_t i = 0; i < order.size(); ++i) {
+    int docId = static_cast<int>(i) + 1;
+    if (const std::string *name = m_docNames.find(order[i])) {
+      names.insert(docId, *name);
+    }
+    if (const int *length = m_docLengths.find(order[i])) {
+      lengths.insert(docId, *length);
+    }
+  }
+  m_docNames = std::move(names);
+  m_docLengths = std::move(lengths);
+
+  // Файлы на диске остаются в старой нумерации до saveIndex
+  if (!m_documentStore.empty()) {
+    m_documentStore.renumber(order);
+  }
+
+  DocValues values;
+  for (const auto &field : m_docValues.fields()) {
+    const DocValuesColumn *column = m_docValues.find(field);
+    DocValuesColumn &target = values.column(field);
+    for (size_t i = 0; i < order.size(); ++i) {
+      int64_t value = 0;
+      if (column->get(order[i], value)) {
+        target.add(static_cast<int>(i) + 1, value);
+      }
+    }
+  }
+  values.finish();
+  m_docValues = std::move(values);
+
+  buildFacetIndex();
+  loadStaticScores();
+  buildDuplicateClusters();
+  buildLengthTable();
+  buildChampionLists();
+  buildPartitions();
+  return stats;
+}
+
+void SearchEngine::buildFacetIndex() {
+  m_hostFacets.clear();
+
+  for (long long docId = 1; docId <= m_totalDocsCount; ++docId) {
+    const std::string *url = findDocumentUrl(static_cast<int>(docId));
+    if (url) {
+      m_hostFacets.add(static_cast<int>(docId), extractHost(*url));
+    }
+  }
+}
+
+DocBitmap SearchEngine::evaluateBitmap(const QueryNode &node) const {
+  switch (node.type) {
+  case QueryNode::Type::Filter: {
+    if (node.field == "site") {
+      const DocBitmap *bitmap = m_hostFacets.documents(node.term);
+      return bitmap ? *bitmap : DocBitmap();
+    }
+    int64_t min = 0;
+    int64_t max = 0;
+    const DocValuesColumn *column =
+        findRangeFilter(node.field, node.term, min, max);
+    return column ? column->rangeBitmap(min, max) : DocBitmap();
+  }
+
+  case QueryNode::Type::Term: {
+    DocBitmap result;
+    for (const auto *list : getPostingListsForTerm(node.term)) {
+      if (list && !list->empty()) {
+        result = result.empty() ? DocBitmap::fromPostings(*list)
+                                : result | DocBitmap::fromPostings(*list);
+      }
+    }
+    return result;
+  }
+
+  case QueryNode::Type::Or: {
+    DocBitmap result;
+    for (const auto &child : node.children) {
+      result = result | evaluateBitmap(child);
+    }
+    return result;
+  }
+
+  case QueryNode::Type::And: {
+    // Дети уже упорядочены по возрастанию df, NOT идут последними
+    DocBitmap result;
+    bool hasPositive = false;
+    for (const auto &child : node.children) {
+      if (child.type == QueryNode::Type::Not) {
+        if (!hasPositive || result.empty()) {
+          break;
+        }
+        result = result.andNot(evaluateBitmap(child.children[0]));
+      } else {
+        result = hasPositive ? result & evaluateBitmap(child)
+                             : evaluateBitmap(child);
+        hasPositive = true;
+      }
+      if (result.empty()) {
+        break;
+      }
+    }
+    return hasPositive ? result : DocBitmap();
+  }
+
+  case QueryNode::Type::Not:
+    return DocBitmap();
+  }
+
+  return DocBitmap();
+}
+
+SearchEngine::ResultCount SearchEngine::estimateUnionCount(
+    const std::vector<const std::vector<uint8_t> *> &lists,
+    size_t totalPostings) const {
+  UnionEstimate estimate =
+      estimateUnionSize(lists, m_config.countSamples, totalPostings);
+
+  ResultCount result;
+  result.exact = false;
+  result.count = static_cast<size_t>(std::llround(estimate.size));
+  result.errorBound = static_cast<size_t>(std::ceil(estimate.errorBound));
+  return result;
+}
+
+QueryNode SearchEngine::parseQuery(const std::string &queryStr) const {
+  QueryNode plan = QueryParser::parse(queryStr);
+  if (m_config.fuzzyFallback) {
+    pinNegatedTerms(plan, false);
+  }
+  return QueryParser::rewrite(
+      std::move(plan),
+      [this](const std::string &term) { return estimateDocFrequency(term); });
+}
+
+void SearchEngine::pinNegatedTerms(QueryNode &node, bool negated) const {
+  // Неизвестный термин под NOT не раскрывается по похожим словам: он
+  // ничего не исключает, поэтому заменяется пустым узлом
+  if (node.type == QueryNode::Type::Term) {
+    if (negated && !isWildcardPattern(node.term) &&
+        !isFuzzyTerm(node.term) && !m_invertedIndex.count(node.term)) {
+      node = QueryNode();
+    }
+    return;
+  }
+  for (auto &child : node.children) {
+    pinNegatedTerms(child, negated || node.type == QueryNode::Type::Not);
+  }
+}
+
+std::string SearchEngine::suggestQuery(const std::string &queryStr) const {
+  std::stringstream ss(queryStr);
+  std::string token;
+  std::string suggestion;
+  bool changed = false;
+
+  while (ss >> token) {
+    size_t begin = token.find_first_not_of("+-!(");
+    size_t end = token.find_last_not_of(")");
+    std::string replacement = token;
+
+    if (begin != std::string::npos && end != std::string::npos &&
+        begin <= end && !QueryParser::isOperator(token)) {
+      std::string rawWord = token.substr(begin, end - begin + 1);
+      std::vector<std::string> parsed = TextUtils::tokenizeQuery(rawWord);
+
+      if (parsed.size() == 1 && !isWildcardPattern(parsed[0]) &&
+          !isFuzzyTerm(parsed[0]) && !m_invertedIndex.count(parsed[0])) {
+
+        auto suggestions =
+            m_spellIndex.suggest(parsed[0], m_termDictionary, 1);
+        if (!suggestions.empty()) {
+          replacement = token.substr(0, begin) + suggestions[0].term +
+                        token.substr(end + 1);
+          changed = true;
+        }
+      }
+    }
+
+    if (!suggestion.empty()) {
+      suggestion += " ";
+    }
+    suggestion += replacement;
+  }
+
+  return changed ? suggestion : std::string();
+}
+
+void SearchEngine::performAutocomplete() {
+  std::cout << "\n=== AUTOCOMPLETE ===\n";
+  std::cout << "Type 'exit' to return to main menu\n\n";
+
+  std::string prefix;
+
+  while (true) {
+    std::cout << "Prefix: ";
+    std::cout.flush();
+
+    if (!std::getline(std::cin, prefix)) {
+      break;
+    }
+
+    if (prefix == "exit") {
+      break;
+    }
+
+    auto completions = autocomplete(prefix, m_config.topKResults);
+    if (completions.empty()) {
+      std::cout << "No completions.\n\n";
+      continue;
+    }
+
+    for (const auto &completion : completions) {
+      std::cout << "  " << std::left << std::setw(30) << completion.text
+                << completion.weight << "\n";
+    }
+    std::cout << "\n";
+  }
+}
+
+std::vector<CompletionTrie::Completion>
+SearchEngine::autocomplete(const std::string &prefix, size_t k) const {
+  return m_completionTrie.complete(TextUtils::toLowerCase(prefix), k);
+}
+
+std::vector<std::string>
+SearchEngine::expandTermPattern(const std::string &pattern) const {
+  // Булев оператор должен быть точным: раскрываются все подходящие
+  // термины, а их списки сливаются объединением через кучу
+  const size_t all = std::numeric_limits<size_t>::max();
+  std::vector<size_t> ids;
+
+  bool leadingWildcard = !pattern.empty() && (pattern[0] == '*' ||
+                                              pattern[0] == '?');
+  if (!leadingWildcard || m_ngramIndex.empty() ||
+      !m_ngramIndex.matchWildcard(pattern, m_termDictionary, all, ids)) {
+    ids = m_termDictionary.matchWildcard(pattern, all);
+  }
+
+  std::vector<std::string> terms;
+  terms.reserve(ids.size());
+  for (size_t id : ids) {
+    terms.push_back(m_termDictionary.term(id));
+  }
+
+  return terms;
+}
+
+std::vector<std::string>
+SearchEngine::expandFuzzyTerm(const std::string &word, int maxEdits) const {
+  std::vector<std::string> terms;
+
+  for (const auto &match : m_termDictionary.matchFuzzy(
+           word, maxEdits, m_config.maxFuzzyExpansions)) {
+    terms.push_back(m_termDictionary.term(match.first));
+  }
+
+  return terms;
+}
+
+std::vector<std::string>
+SearchEngine::expandQueryTerm(const std::string &term) const {
+  if (isWildcardPattern(term)) {
+    return expandTermPattern(term);
+  }
+
+  if (isFuzzyTerm(term)) {
+    std::string word;
+    int maxEdits = parseFuzzyTerm(term, word);
+    return expandFuzzyTerm(word, maxEdits);
+  }
+
+  if (m_invertedIndex.count(term) || !m_config.fuzzyFallback) {
+    return {term};
+  }
+
+  return expandFuzzyTerm(term, autoFuzziness(term));
+}
+
+bool SearchEngine::isExpandedTerm(const std::string &term) const {
+  return isWildcardPattern(term) || isFuzzyTerm(term) ||
+         !m_invertedIndex.count(term);
+}
+
+std::vector<const std::vector<uint8_t> *>
+SearchEngine::getPostingListsForTerm(const std::string &term) const {
+  if (!isExpandedTerm(term)) {
+    return {m_invertedIndex.find(term)};
+  }
+
+  std::vector<const std::vector<uint8_t> *> lists;
+  for (const auto &expanded : expandQueryTerm(term)) {
+    lists.push_back(m_invertedIndex.find(expanded));
+  }
+  return lists;
+}
+
+std::vector<std::pair<int, int>>
+SearchEngine::getPostingsForTerm(const std::string &term) const {
+  if (!isExpandedTerm(term)) {
+    return CompressionUtils::decompressPostingList(*m_invertedIndex.find(term));
+  }
+
+  return unionPostingLists(getPostingListsForTerm(term));
+}
+
+size_t SearchEngine::estimateDocFrequency(const std::string &term) const {
+  if (term.compare(0, 5, "site:") == 0) {
+    const DocBitmap *hostDocs = m_hostFacets.documents(term.substr(5));
+    return hostDocs ? hostDocs->cardinality() : 0;
+  }
+
+  size_t colon = term.find(':');
+  if (colon != std::string::npos) {
+    int64_t min = 0;
+    int64_t max = 0;
+    const DocValuesColumn *column = findRangeFilter(
+        term.substr(0, colon), term.substr(colon + 1), min, max);
+    return column ? column->estimateRange(min, max) : 0;
+  }
+
+  size_t total = 0;
+  size_t id = 0;
+
+  for (const auto &expanded :
+       isExpandedTerm(term) ? expandQueryTerm(term)
+                            : std::vector<std::string>{term}) {
+    if (m_termDictionary.lookup(expanded, id)) {
+      total += m_termDictionary.docFrequency(id);
+    }
+  }
+  return total;
+}
+
+std::string SearchEngine::documentText(int docId) const {
+  if (m_documentStore.contains(docId)) {
+    return m_documentStore.get(docId);
+  }
+  return FileUtils::readFileContent(getDocumentPath(docId));
+}
+
+void SearchEngine::performTfIdfSearch() {
+  std::cout << "\n=== TF-IDF SEARCH ===\n";
+  std::cout << "Type 'n' for the next page, 'exit' to return to main menu\n\n";
+
+  std::string queryStr;
+  std::string lastQuery;
+  RankCursor cursor;
+  size_t shown = 0;
+  bool hasMore = false;
 
   while (true) {
     std::cout << "TF-IDF Query: ";
@@ -591,94 +2033,761 @@ void SearchEngine::performTfIdfSearch() {
       break;
     }
 
+    if (queryStr == "n") {
+      if (!hasMore) {
+        std::cout << "No more results.\n\n";
+        continue;
+      }
+      RankedPage page =
+          searchTfIdfPage(lastQuery, cursor, m_config.topKResults);
+      cursor = page.next;
+      hasMore = page.hasMore;
+      displayTfIdfResults(page.results, lastQuery, shown + 1, hasMore);
+      shown += page.results.size();
+      std::cout << "\n";
+      continue;
+    }
+
     if (queryStr.empty()) {
       std::cout << "No query terms.\n\n";
       continue;
     }
 
-    std::vector<std::string> queryTerms = TextUtils::tokenize(queryStr);
-
-    if (queryTerms.empty()) {
+    if (TextUtils::tokenizeQuery(queryStr).empty()) {
       std::cout << "No valid query terms.\n\n";
       continue;
     }
 
-    std::map<int, double> scores = calculateTfIdfScores(queryTerms);
+    RankedPage page =
+        searchTfIdfPage(queryStr, RankCursor(), m_config.topKResults);
+    lastQuery = queryStr;
+    cursor = page.next;
+    hasMore = page.hasMore;
+    shown = page.results.size();
+
+    if (page.results.empty()) {
+      std::cout << "No matching documents found.\n";
+
+      std::string suggestion = suggestQuery(queryStr);
+      if (!suggestion.empty()) {
+        std::cout << "Did you mean: " << suggestion << " ?\n";
+      }
+      std::cout << "\n";
+      continue;
+    }
+
+    displayTfIdfResults(page.results, queryStr, 1, hasMore);
+    std::cout << "\n";
+  }
+}
+
+std::vector<SearchEngine::ScoredDocument>
+SearchEngine::searchTfIdf(const std::string &queryStr) const {
+  std::vector<std::string> queryTerms = TextUtils::tokenizeQuery(queryStr);
+  if (queryTerms.empty()) {
+    return {};
+  }
+
+  return rankDocuments(
+      withScoringPolicy(m_config.scoringModel, [&](auto policy) {
+        return calculateScores<decltype(policy)>(queryTerms);
+      }));
+}
+
+std::vector<SearchEngine::ScoredDocument>
+SearchEngine::searchTfIdf(const std::string &queryStr,
+                          const CollectionStats &global) const {
+  std::vector<std::string> queryTerms = TextUtils::tokenizeQuery(queryStr);
+  if (queryTerms.empty()) {
+    return {};
+  }
+
+  return rankDocuments(
+      withScoringPolicy(m_config.scoringModel, [&](auto policy) {
+        return calculateScores<decltype(policy)>(queryTerms, &global);
+      }));
+}
+
+SearchEngine::CollectionStats
+SearchEngine::collectionStats(const std::string &queryStr) const {
+  CollectionStats stats;
+  stats.documents = m_totalDocsCount;
+  stats.totalLength = m_totalLength;
+
+  for (const auto &term : TextUtils::tokenizeQuery(queryStr)) {
+    TermStats &termStats = stats.terms[term];
+    if (!isExpandedTerm(term)) {
+      termStats.docFrequency = estimateDocFrequency(term);
+      termStats.exact = true;
+    } else {
+      termStats.docFrequency = getPostingsForTerm(term).size();
+    }
+  }
+  return stats;
+}
+
+void SearchEngine::CollectionStats::merge(const CollectionStats &other) {
+  documents += other.documents;
+  totalLength += other.totalLength;
+
+  for (const auto &entry : other.terms) {
+    TermStats &mine = terms[entry.first];
+    if (entry.second.exact && !mine.exact) {
+      mine = entry.second;
+    } else if (entry.second.exact == mine.exact) {
+      mine.docFrequency += entry.second.docFrequency;
+    }
+  }
+}
+
+void SearchEngine::setShard(size_t shard, size_t shardCount, ShardBy by) {
+  m_config.shardCount = std::max<size_t>(shardCount, 1);
+  m_config.shard = shard % m_config.shardCount;
+  m_config.shardBy = by;
+  if (m_config.shardCount == 1) {
+    return;
+  }
+
+  fs::path dir = fs::path(m_config.invIndexPath).parent_path() /
+                 ("shard_" + std::to_string(m_config.shard));
+  std::error_code error;
+  fs::create_directories(dir, error);
+
+  for (std::string *path :
+       {&m_config.invIndexPath, &m_config.docNamesPath,
+        &m_config.docLengthsPath, &m_config.spellIndexPath,
+        &m_config.docStorePath, &m_config.docValuesPath,
+        &m_config.hotIndexPath, &m_config.championsPath}) {
+    *path = (dir / fs::path(*path).filename()).string();
+  }
+}
+
+int SearchEngine::globalDocId(int docId) const {
+  const DocValuesColumn *ids = m_docValues.find(GLOBAL_ID_FIELD);
+  int64_t globalId = 0;
+  return ids && ids->get(docId, globalId) ? static_cast<int>(globalId)
+                                          : docId;
+}
+
+void SearchEngine::performBooleanRankedSearch() {
+  std::cout << "\n=== BOOLEAN FILTER + TF-IDF RANKING ===\n";
+  std::cout << "Syntax: as in Boolean search, e.g. +cat -dog or "
+               "(cat OR dog) AND NOT bird\n";
+  std::cout << "Type 'n' for the next page, 'exit' to return to main menu\n\n";
+
+  std::string queryStr;
+  std::string lastQuery;
+  RankCursor cursor;
+  size_t shown = 0;
+  bool hasMore = false;
+
+  while (true) {
+    std::cout << "Ranked Bool Query: ";
+    std::cout.flush();
+
+    if (!std::getline(std::cin, queryStr)) {
+      break;
+    }
+
+    if (queryStr == "exit") {
+      break;
+    }
+
+    if (queryStr == "n") {
+      if (!hasMore) {
+        std::cout << "No more results.\n\n";
+        continue;
+      }
+      RankedPage page =
+          searchBooleanRankedPage(lastQuery, cursor, m_config.topKResults);
+      cursor = page.next;
+      hasMore = page.hasMore;
+      displayTfIdfResults(page.results, lastQuery, shown + 1, hasMore);
+      shown += page.results.size();
+      std::cout << "\n";
+      continue;
+    }
 
-    if (scores.empty()) {
-      std::cout << "No matching documents found.\n\n";
+    RankedPage page;
+    try {
+      page = searchBooleanRankedPage(queryStr, RankCursor(),
+                                     m_config.topKResults);
+    } catch (const std::invalid_argument &e) {
+      std::cout << "Query error: " << e.what() << "\n\n";
+      hasMore = false;
       continue;
     }
 
-    std::vector<ScoredDocument> rankedResults = rankDocuments(scores);
+    lastQuery = queryStr;
+    cursor = page.next;
+    hasMore = page.hasMore;
+    shown = page.results.size();
 
-    displayTfIdfResults(rankedResults);
+    if (page.results.empty()) {
+      std::cout << "No matching documents found.\n";
+
+      std::string suggestion = suggestQuery(queryStr);
+      if (!suggestion.empty()) {
+        std::cout << "Did you mean: " << suggestion << " ?\n";
+      }
+      std::cout << "\n";
+      continue;
+    }
+
+    displayTfIdfResults(page.results, queryStr, 1, hasMore);
     std::cout << "\n";
   }
 }
 
-std::map<int, double> SearchEngine::calculateTfIdfScores(
-    const std::vector<std::string> &queryTerms) const {
+std::vector<SearchEngine::ScoredDocument>
+SearchEngine::searchBooleanRanked(const std::string &queryStr,
+                                  size_t k) const {
+  return searchBooleanRankedPage(queryStr, RankCursor(), k).results;
+}
 
-  std::map<int, double> scores;
+SearchEngine::RankedPage
+SearchEngine::searchBooleanRankedPage(const std::string &queryStr,
+                                      const RankCursor &after,
+                                      size_t pageSize) const {
+  QueryNode plan = parseQuery(queryStr);
+  std::vector<std::string> scoringTerms = QueryParser::positiveTerms(plan);
+  return withScoringPolicy(m_config.scoringModel, [&](auto policy) {
+    return rankByPlan<decltype(policy)>(plan, scoringTerms, after, pageSize);
+  });
+}
 
-  for (const std::string &term : queryTerms) {
-    const std::vector<uint8_t> *data = m_invertedIndex.find(term);
-    if (!data) {
+SearchEngine::RankedPage
+SearchEngine::searchTfIdfPage(const std::string &queryStr,
+                              const RankCursor &after,
+                              size_t pageSize) const {
+  return rankTfIdfPage(queryStr, after, pageSize, true);
+}
+
+SearchEngine::RankedPage
+SearchEngine::rankTfIdfPage(const std::string &queryStr,
+                            const RankCursor &after, size_t pageSize,
+                            bool champions) const {
+  std::vector<std::string> queryTerms = TextUtils::tokenizeQuery(queryStr);
+
+  return withScoringPolicy(m_config.scoringModel, [&](auto policy) {
+    using Policy = decltype(policy);
+
+    RankedPage page;
+    if (champions && after.docId < 0 &&
+        rankByChampions<Policy>(queryTerms, pageSize, page)) {
+      return page;
+    }
+
+    std::vector<QueryNode> children;
+    for (const auto &term : queryTerms) {
+      children.push_back(QueryNode::makeTerm(term));
+    }
+    QueryNode filter = QueryParser::rewrite(
+        QueryNode::makeOperator(QueryNode::Type::Or, std::move(children)),
+        [this](const std::string &term) { return estimateDocFrequency(term); });
+
+    return rankByPlan<Policy>(filter, queryTerms, after, pageSize);
+  });
+}
+
+Scoring::TermBounds SearchEngine::termBounds(const std::string &term) const {
+  size_t id = 0;
+  if (!isExpandedTerm(term) && m_termDictionary.lookup(term, id) &&
+      id < m_termBounds.size()) {
+    return m_termBounds[id];
+  }
+  return Scoring::TermBounds();
+}
+
+template <typename Policy>
+SearchEngine::RankedPage
+SearchEngine::rankByPlan(const QueryNode &plan,
+                         const std::vector<std::string> &scoringTerms,
+                         const RankCursor &after, size_t pageSize) const {
+  RankedPage page;
+  if (pageSize == 0 || plan.isEmpty()) {
+    return page;
+  }
+
+  PostingLookup lookup = [this](const std::string &term) {
+    return getPostingListsForTerm(term);
+  };
+
+  struct TermWeight {
+    QueryNode node;
+    double weight;
+  };
+
+  struct ScoringTerm {
+    std::unique_ptr<DocIterator> postings;
+    double weight;
+  };
+
+  // Верхняя граница текстовой оценки любого документа — сумма границ
+  // терминов по спискам (для раскрытий — общие границы)
+  double textBound = 0.0;
+  std::vector<TermWeight> weights;
+  for (const auto &term : scoringTerms) {
+    QueryNode termNode = QueryNode::makeTerm(term);
+    size_t docsWithTerm = 0;
+
+    if (isExpandedTerm(term)) {
+      auto counter = QueryPlan::compile(termNode, lookup);
+      while (counter->next() != DocIterator::NO_MORE_DOCS) {
+        docsWithTerm++;
+      }
+    } else {
+      docsWithTerm = estimateDocFrequency(term);
+    }
+
+    if (docsWithTerm == 0) {
       continue;
     }
 
-    auto postings = CompressionUtils::decompressPostingList(*data);
+    double weight = Policy::weight(static_cast<double>(docsWithTerm),
+                                   static_cast<double>(m_totalDocsCount));
+    textBound += Policy::bound(weight, termBounds(term), m_averageLength);
 
-    double idf =
-        std::log(static_cast<double>(m_totalDocsCount) / postings.size());
+    weights.push_back({std::move(termNode), weight});
+  }
 
-    for (const auto &posting : postings) {
-      int docId = posting.first;
-      int termFreq = posting.second;
+  // Априорная оценка не возрастает с docId, поэтому оставшиеся документы
+  // не получат больше textBound + staticPrior(текущий)
+  bool canStop = m_config.staticWeight == 0.0 || m_staticOrdered;
+
+  // Порядок выдачи: по убыванию оценки, при равенстве — по docId.
+  // Вершина кучи — худший из отобранных документов.
+  auto better = [](const ScoredDocument &a, const ScoredDocument &b) {
+    return a.score > b.score || (a.score == b.score && a.docId < b.docId);
+  };
+  ScoredDocument cursor = {after.docId, after.score};
+
+  // Берём на один документ больше, чтобы знать, есть ли следующая страница
+  size_t k = pageSize + 1;
+
+  bool collapse = m_config.duplicatePolicy == DuplicatePolicy::Collapse;
+
+  // Обход одного диапазона docId со своей кучей: лучшие k документов всего
+  // индекса входят в лучшие k своего диапазона
+  auto scan = [&](DocIterator &filter, const SkipLookup &skips,
+                  std::vector<ScoredDocument> &heap, size_t &scored) {
+    std::vector<ScoringTerm> scorers;
+    for (const auto &term : weights) {
+      scorers.push_back(
+          {QueryPlan::compile(term.node, lookup, {}, skips), term.weight});
+    }
+    heap.reserve(k + 1);
+    std::unordered_map<int, ScoredDocument> clusterBest;
+
+    auto offer = [&](const ScoredDocument &candidate) {
+      if (candidate.score < minScore() || !better(cursor, candidate)) {
+        return;
+      }
+      if (heap.size() < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end(), better);
+      } else if (better(candidate, heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), better);
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end(), better);
+      }
+    };
+
+    while (filter.next() != DocIterator::NO_MORE_DOCS) {
+      int docId = filter.docId();
+      double prior = staticPrior(docId);
+
+      if (canStop && heap.size() == k &&
+          heap.front().score >= textBound + prior) {
+        break;
+      }
 
       const int *docLenPtr = m_docLengths.find(docId);
       if (!docLenPtr || *docLenPtr == 0) {
         continue;
       }
 
-      int docLength = *docLenPtr;
+      double score = 0.0;
+      for (auto &scorer : scorers) {
+        if (scorer.postings->advance(docId) == docId) {
+          score += Policy::score(scorer.weight,
+                                 static_cast<double>(scorer.postings->freq()),
+                                 static_cast<double>(*docLenPtr),
+                                 m_averageLength);
+        }
+      }
+      score += prior;
+      scored++;
+
+      ScoredDocument candidate = {docId, score};
+
+      // От кластера почти-дубликатов в выдаче остаётся лучший совпавший
+      // документ. Он ищется среди всех документов, включая прошлые
+      // страницы, и попадает в кучу только после обхода: иначе его
+      // вытесненный член занял бы место документа, отвергнутого раньше.
+      int cluster = collapse ? duplicateCluster(docId) : -1;
+      if (cluster >= 0) {
+        auto inserted = clusterBest.emplace(cluster, candidate);
+        if (!inserted.second && better(candidate, inserted.first->second)) {
+          inserted.first->second = candidate;
+        }
+        continue;
+      }
 
-      double tf = static_cast<double>(termFreq) / docLength;
+      offer(candidate);
+    }
 
-      scores[docId] += tf * idf;
+    // Остановка по границе верна и для кластеров: непросмотренный член
+    // оценивается не выше вершины кучи и не сменил бы лучшего члена,
+    // который в неё проходит
+    for (const auto &entry : clusterBest) {
+      offer(entry.second);
+    }
+  };
+
+  // Лучший документ кластера может лежать в любом диапазоне, поэтому
+  // выдача со схлопыванием строится одним проходом
+  std::vector<ScoredDocument> heap;
+  if (queryPartitions() == 1 || collapse) {
+    auto filter = compilePlan(plan);
+    scan(*filter, {}, heap, page.scored);
+    std::sort_heap(heap.begin(), heap.end(), better);
+  } else {
+    std::vector<std::vector<ScoredDocument>> heaps(queryPartitions());
+    std::vector<size_t> scored(queryPartitions(), 0);
+    forEachPartition([&](size_t partition) {
+      SkipLookup skips = partitionSkips(partition);
+      auto filter = QueryPlan::clip(compilePlan(plan, skips),
+                                    m_partitionBounds[partition],
+                                    m_partitionBounds[partition + 1]);
+      scan(*filter, skips, heaps[partition], scored[partition]);
+    });
+
+    for (size_t partition = 0; partition < heaps.size(); ++partition) {
+      heap.insert(heap.end(), heaps[partition].begin(),
+                  heaps[partition].end());
+      page.scored += scored[partition];
+    }
+    std::sort(heap.begin(), heap.end(), better);
+    if (heap.size() > k) {
+      heap.resize(k);
     }
   }
 
-  return scores;
+  page.hasMore = heap.size() > pageSize;
+  if (page.hasMore) {
+    heap.pop_back();
+  }
+  if (!heap.empty()) {
+    page.next = {heap.back().score, heap.back().docId};
+  }
+  page.results = std::move(heap);
+  return page;
 }
 
-double SearchEngine::calculateTfIdf(int termFreq, int docLength,
-                                    int docsWithTerm) const {
+template <typename Policy>
+bool SearchEngine::rankByChampions(const std::vector<std::string> &scoringTerms,
+                                   size_t pageSize, RankedPage &page) const {
+  // Схлопывание дубликатов требует оценок всех совпавших членов кластера,
+  // а чемпионы дают их не для всех документов
+  if (m_championLists.empty() || m_config.staticWeight != 0.0 ||
+      m_config.duplicatePolicy == DuplicatePolicy::Collapse ||
+      pageSize == 0 || scoringTerms.empty()) {
+    return false;
+  }
+
+  struct Candidate {
+    int docId;
+    double score;         // вклад терминов, где документ — чемпион
+    double coveredBound;  // сумма границ этих терминов
+    size_t coveredTerms;  // число неполных списков, где он чемпион
+  };
+
+  std::map<int, Candidate> candidates;
+  // Граница вклада термина для документа вне его чемпионов: худший чемпион,
+  // если вклад монотонен по tf / длина, иначе граница по всему списку
+  // (0, если список чемпионов полон)
+  double outsiderBound = 0.0;
+  size_t incompleteTerms = 0;
+
+  for (const auto &term : scoringTerms) {
+    size_t id = 0;
+    if (isExpandedTerm(term) || !m_termDictionary.lookup(term, id)) {
+      return false;
+    }
 
-  double tf = static_cast<double>(termFreq) / docLength;
-  double idf = std::log(static_cast<double>(m_totalDocsCount) / docsWithTerm);
-  return tf * idf;
+    uint32_t docsWithTerm = m_termDictionary.docFrequency(id);
+    double weight = Policy::weight(static_cast<double>(docsWithTerm),
+                                   static_cast<double>(m_totalDocsCount));
+    auto champions = m_championLists.list(id);
+    bool complete = champions.size() >= docsWithTerm;
+
+    double bound = 0.0;
+    if (!complete) {
+      bound = Policy::RATIO_MONOTONE
+                  ? std::numeric_limits<double>::infinity()
+                  : Policy::bound(weight, termBounds(term), m_averageLength);
+    }
+    for (const auto &posting : champions) {
+      const int *docLenPtr = m_docLengths.find(posting.first);
+      if (!docLenPtr || *docLenPtr == 0) {
+        continue;
+      }
+      double contribution = Policy::score(
+          weight, static_cast<double>(posting.second),
+          static_cast<double>(*docLenPtr), m_averageLength);
+      if (!complete && Policy::RATIO_MONOTONE) {
+        bound = std::min(bound, contribution);
+      }
+
+      auto it = candidates.emplace(posting.first,
+                                   Candidate{posting.first, 0.0, 0.0, 0})
+                    .first;
+      it->second.score += contribution;
+    }
+
+    if (!complete) {
+      for (const auto &posting : champions) {
+        auto it = candidates.find(posting.first);
+        if (it != candidates.end()) {
+          it->second.coveredBound += bound;
+          it->second.coveredTerms++;
+        }
+      }
+      outsiderBound += bound;
+      incompleteTerms++;
+    }
+  }
+
+  auto better = [](const Candidate &a, const Candidate &b) {
+    return a.score > b.score || (a.score == b.score && a.docId < b.docId);
+  };
+
+  std::vector<Candidate> ranked;
+  ranked.reserve(candidates.size());
+  for (const auto &entry : candidates) {
+    ranked.push_back(entry.second);
+  }
+  std::sort(ranked.begin(), ranked.end(), better);
+
+  // Точная оценка известна, только если документ — чемпион во всех
+  // неполных списках; первые pageSize + 1 документов должны быть точными
+  size_t k = pageSize + 1;
+  size_t selected = 0;
+  while (selected < ranked.size() && selected < k &&
+         ranked[selected].score >= minScore()) {
+    if (ranked[selected].coveredTerms != incompleteTerms) {
+      return false;
+    }
+    selected++;
+  }
+
+  // Остальные документы должны быть строго хуже последнего отобранного
+  // (или порога оценки, если отобрано меньше k)
+  double bar = selected == k ? ranked[selected - 1].score
+                             : minScore();
+  if (incompleteTerms > 0 && outsiderBound >= bar) {
+    return false;
+  }
+  for (size_t i = selected; i < ranked.size(); ++i) {
+    const Candidate &other = ranked[i];
+    if (other.coveredTerms != incompleteTerms &&
+        other.score + (outsiderBound - other.coveredBound) >= bar) {
+      return false;
+    }
+  }
+
+  page.scored = ranked.size();
+  page.fromChampions = true;
+  page.hasMore = selected > pageSize;
+  for (size_t i = 0; i < std::min(selected, pageSize); ++i) {
+    page.results.push_back({ranked[i].docId, ranked[i].score});
+  }
+  if (!page.results.empty()) {
+    page.next = {page.results.back().score, page.results.back().docId};
+  }
+  return true;
 }
 
-std::vector<SearchEngine::ScoredDocument>
-SearchEngine::rankDocuments(const std::map<int, double> &scores) const {
+template <typename Policy>
+std::vector<SearchEngine::ScoredDocument> SearchEngine::calculateScores(
+    const std::vector<std::string> &queryTerms,
+    const CollectionStats *global) const {
+
+  // Обычный термин читается из сжатого списка, раскрытый — из объединения
+  struct ScoringList {
+    const std::vector<uint8_t> *data;
+    std::vector<std::pair<int, int>> postings;
+    Scoring::TermScorer<Policy> model;
+  };
+
+  double documents = static_cast<double>(
+      global ? global->documents : m_totalDocsCount);
+  double averageLength = global ? global->averageLength() : m_averageLength;
+
+  std::vector<ScoringList> lists;
+  for (const std::string &term : queryTerms) {
+    const TermStats *shared = nullptr;
+    if (global) {
+      auto it = global->terms.find(term);
+      shared = it == global->terms.end() ? nullptr : &it->second;
+    }
+
+    if (!isExpandedTerm(term)) {
+      // df берётся из словаря, как в rankByPlan: список горячего уровня
+      // короче полного
+      const std::vector<uint8_t> *data = m_invertedIndex.find(term);
+      size_t docsWithTerm = estimateDocFrequency(term);
+      if (!data || data->empty() || docsWithTerm == 0) {
+        continue;
+      }
+
+      double weight = Policy::weight(
+          static_cast<double>(shared ? shared->docFrequency : docsWithTerm),
+          documents);
+      lists.push_back({data, {}, {weight, averageLength}});
+      continue;
+    }
+
+    // Термин найден точно в другом шарде: единый индекс его не раскрыл бы
+    if (shared && shared->exact) {
+      continue;
+    }
+
+    auto postings = getPostingsForTerm(term);
+    if (postings.empty()) {
+      continue;
+    }
+
+    double weight = Policy::weight(
+        static_cast<double>(shared ? shared->docFrequency : postings.size()),
+        documents);
+    lists.push_back({nullptr, std::move(postings), {weight, averageLength}});
+  }
+
+  // Плотный аккумулятор по docId; seen отмечает документы, уже попавшие в
+  // список затронутых. Диапазоны docId пишут в непересекающиеся ячейки.
+  std::vector<double> accumulator(m_lengthTable.size(), 0.0);
+  std::vector<uint8_t> seen(m_lengthTable.size(), 0);
+  std::vector<std::vector<ScoredDocument>> ranges(queryPartitions());
+  bool partitioned = queryPartitions() > 1;
+  bool collapse = m_config.duplicatePolicy == DuplicatePolicy::Collapse;
+
+  auto scoreRange = [&](size_t partition) {
+    int begin = partitioned ? m_partitionBounds[partition] : 0;
+    int end = partitioned ? m_partitionBounds[partition + 1]
+                          : PostingIterator::NO_MORE_DOCS;
+    // Ячеек аккумулятора нет для docId вне таблицы длин
+    end = std::min(end, static_cast<int>(m_lengthTable.size()));
+    SkipLookup skips = partitioned ? partitionSkips(partition) : nullptr;
+
+    std::vector<int> touched;
+    int docIds[ScoreKernel::BLOCK_SIZE];
+    int tfs[ScoreKernel::BLOCK_SIZE];
+
+    // Оценивает документы блока из диапазона; false — блок вышел за конец
+    auto accumulate = [&](const Scoring::TermScorer<Policy> &model,
+                          size_t count) {
+      size_t first = 0;
+      while (first < count && docIds[first] < begin) {
+        first++;
+      }
+      size_t last = first;
+      while (last < count && docIds[last] < end) {
+        last++;
+      }
+
+      ScoreKernel::scoreBlock(model, docIds + first, tfs + first,
+                              last - first, m_lengthTable.data(),
+                              accumulator.data());
+      for (size_t i = first; i < last; ++i) {
+        if (!seen[docIds[i]]) {
+          seen[docIds[i]] = 1;
+          touched.push_back(docIds[i]);
+        }
+      }
+      return last == count;
+    };
+
+    for (const auto &list : lists) {
+      if (list.data) {
+        PostingIterator::Position start =
+            skips ? skips(list.data) : PostingIterator::Position();
+        size_t offset = start.offset;
+        int lastDocId = start.previousDocId;
+        while (size_t count = ScoreKernel::decodeBlock(
+                   *list.data, offset, lastDocId, docIds, tfs)) {
+          if (!accumulate(list.model, count)) {
+            break;
+          }
+        }
+        continue;
+      }
 
-  std::vector<ScoredDocument> results;
-  results.reserve(scores.size());
+      const auto &postings = list.postings;
+      size_t from =
+          std::lower_bound(postings.begin(), postings.end(),
+                           std::make_pair(begin, 0)) -
+          postings.begin();
+      for (; from < postings.size(); from += ScoreKernel::BLOCK_SIZE) {
+        size_t count =
+            std::min(ScoreKernel::BLOCK_SIZE, postings.size() - from);
+        for (size_t i = 0; i < count; ++i) {
+          docIds[i] = postings[from + i].first;
+          tfs[i] = postings[from + i].second;
+        }
+        if (!accumulate(list.model, count)) {
+          break;
+        }
+      }
+    }
 
-  for (const auto &entry : scores) {
-    if (entry.second >= m_config.minTfIdfScore) {
-      results.push_back({entry.first, entry.second});
+    std::vector<ScoredDocument> &scores = ranges[partition];
+    scores.reserve(touched.size());
+    for (int docId : touched) {
+      // Документы без длины получили inf/NaN и отбрасываются здесь, а не в
+      // цикле оценки
+      if (m_lengthTable[docId] == 0.0) {
+        continue;
+      }
+      scores.push_back({docId, accumulator[docId] + staticPrior(docId)});
     }
+  };
+
+  if (partitioned) {
+    forEachPartition(scoreRange);
+  } else {
+    scoreRange(0);
   }
 
-  std::sort(results.begin(), results.end(),
+  std::vector<ScoredDocument> scores = std::move(ranges[0]);
+  for (size_t partition = 1; partition < ranges.size(); ++partition) {
+    scores.insert(scores.end(), ranges[partition].begin(),
+                  ranges[partition].end());
+  }
+  if (collapse) {
+    collapseDuplicates(scores);
+  }
+  return scores;
+}
+
+std::vector<SearchEngine::ScoredDocument>
+SearchEngine::rankDocuments(std::vector<ScoredDocument> scores) const {
+
+  scores.erase(std::remove_if(scores.begin(), scores.end(),
+                              [this](const ScoredDocument &doc) {
+                                return doc.score < minScore();
+                              }),
+               scores.end());
+
+  // При равной оценке — по docId, как в постраничной выдаче
+  std::sort(scores.begin(), scores.end(),
             [](const ScoredDocument &a, const ScoredDocument &b) {
-              return a.score > b.score;
+              return a.score > b.score ||
+                     (a.score == b.score && a.docId < b.docId);
             });
 
-  return results;
+  return scores;
 }
 
 void SearchEngine::analyzeZipfLaw() {
@@ -745,43 +2854,139 @@ void SearchEngine::displayMenu() const {
   std::cout << "1. Rebuild index\n";
   std::cout << "2. Boolean search\n";
   std::cout << "3. TF-IDF search\n";
-  std::cout << "4. Exit\n";
+  std::cout << "4. Boolean filter + TF-IDF ranking\n";
+  std::cout << "5. Autocomplete\n";
+  std::cout << "6. Exit\n";
   std::cout << "Choice: ";
 }
 
-void SearchEngine::displaySearchResults(const std::vector<int> &docIds) const {
+std::vector<std::string>
+SearchEngine::snippetTerms(const std::string &queryStr) const {
+  std::vector<std::string> terms;
+
+  QueryNode query;
+  try {
+    query = QueryParser::parse(queryStr);
+  } catch (const std::invalid_argument &) {
+    return terms;
+  }
+
+  for (const auto &term : QueryParser::positiveTerms(query)) {
+    for (auto &expanded : expandQueryTerm(term)) {
+      terms.push_back(std::move(expanded));
+    }
+  }
+
+  std::sort(terms.begin(), terms.end());
+  terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+  return terms;
+}
+
+std::string SearchEngine::snippet(int docId,
+                                  const std::string &queryStr) const {
+  SnippetGenerator generator(m_config.snippetWords, m_config.highlightBegin,
+                             m_config.highlightEnd);
+  return generator.generate(documentText(docId), snippetTerms(queryStr)).text;
+}
+
+void SearchEngine::displaySnippet(int docId,
+                                  const std::vector<std::string> &terms) const {
+  SnippetGenerator generator(m_config.snippetWords, m_config.highlightBegin,
+                             m_config.highlightEnd);
+  std::string text = generator.generate(documentText(docId), terms).text;
+  if (!text.empty()) {
+    std::cout << "     " << text << "\n";
+  }
+}
+
+void SearchEngine::displaySearchResults(const std::vector<int> &docIds,
+                                        const ResultCount &count,
+                                        const std::string &queryStr,
+                                        bool hasMore) const {
   std::cout << "Results: ";
 
   if (docIds.empty()) {
     std::cout << "No documents match.";
   } else {
-    std::cout << docIds.size() << " document(s) found\n";
-    for (int docId : docIds) {
-      std::string url = getDocumentUrl(docId);
+    if (count.exact) {
+      std::cout << count.count << " document(s) found\n";
+    } else {
+      std::cout << "about " << count.count << " (+/- " << count.errorBound
+                << ") document(s) found\n";
+    }
+
+    std::vector<std::string> terms;
+    if (m_config.showSnippets) {
+      terms = snippetTerms(queryStr);
+    }
+
+    for (size_t i = 0; i < docIds.size(); ++i) {
+      std::string url = getDocumentUrl(docIds[i]);
       std::cout << "  " << url << "\n";
+
+      if (m_config.showSnippets && i < m_config.topKResults) {
+        displaySnippet(docIds[i], terms);
+      }
+    }
+
+    if (hasMore) {
+      std::cout << "  ... type 'n' for the next page\n";
     }
   }
 }
 
 void SearchEngine::displayTfIdfResults(
-    const std::vector<ScoredDocument> &results) const {
+    const std::vector<ScoredDocument> &results, const std::string &queryStr,
+    size_t firstRank, bool hasMore) const {
 
   size_t limit = std::min(results.size(), m_config.topKResults);
 
-  std::cout << "Top " << limit << " results:\n";
+  std::vector<std::string> terms;
+  if (m_config.showSnippets) {
+    terms = snippetTerms(queryStr);
+  }
+
+  if (firstRank == 1) {
+    std::cout << "Top " << limit << " results:\n";
+  }
 
   for (size_t i = 0; i < limit; ++i) {
     int docId = results[i].docId;
     double score = results[i].score;
     std::string url = getDocumentUrl(docId);
 
-    std::cout << (i + 1) << ". " << url << " | Score: " << std::fixed
-              << std::setprecision(6) << score << "\n";
+    std::cout << (firstRank + i) << ". " << url << " | Score: " << std::fixed
+              << std::setprecision(6) << score;
+    size_t similar = duplicateClusterSize(docId);
+    if (similar > 1) {
+      std::cout << " (+" << similar - 1 << " similar)";
+    }
+    std::cout << "\n";
+
+    if (m_config.showSnippets) {
+      displaySnippet(docId, terms);
+    }
   }
+
+  if (hasMore) {
+    std::cout << "... type 'n' for the next page\n";
+  }
+}
+
+int SearchEngine::registryId(int docId) const {
+  // Реестр urls.txt ключуется номером из имени файла (<id>.txt), а docId
+  // назначаются в порядке обхода каталога
+  const std::string *namePtr = m_docNames.find(docId);
+  int id = namePtr ? fileStemId(*namePtr) : -1;
+  return id >= 0 ? id : docId;
+}
+
+const std::string *SearchEngine::findDocumentUrl(int docId) const {
+  return m_docUrls.find(registryId(docId));
 }
 
 std::string SearchEngine::getDocumentUrl(int docId) const {
-  const std::string *urlPtr = m_docUrls.find(docId);
+  const std::string *urlPtr = findDocumentUrl(docId);
   if (urlPtr) {
     return *urlPtr;
   }
@@ -1,11 +1,31 @@
 #ifndef SEARCH_ENGINE_HPP
 #define SEARCH_ENGINE_HPP
 
+#include "champion_lists.hpp"
+#include "completion_trie.hpp"
+#include "doc_bitmap.hpp"
+#include "doc_values.hpp"
+#include "facet_index.hpp"
+#include "near_duplicates.hpp"
+#include "document_store.hpp"
+#include "ngram_index.hpp"
+#include "query_parser.hpp"
+#include "query_plan.hpp"
+#include "scoring_policy.hpp"
+#include "snippet_generator.hpp"
+#include "spell_index.hpp"
+#include "term_dictionary.hpp"
+#include "thread_pool.hpp"
+
 #include <cmath>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // ============================================================================
@@ -246,9 +266,353 @@ public:
 
   void performBooleanSearch();
   void performTfIdfSearch();
+  void performBooleanRankedSearch();
+  void performAutocomplete();
 
   void analyzeZipfLaw();
 
+  struct ScoredDocument {
+    int docId;
+    double score;
+
+    bool operator>(const ScoredDocument &other) const {
+      return score > other.score;
+    }
+  };
+
+  /**
+   * @brief Выполняет булев запрос с AND/OR/NOT, скобками и +/- синтаксисом
+   * @throws std::invalid_argument при синтаксической ошибке
+   */
+  std::vector<int> searchBoolean(const std::string &queryStr,
+                                 size_t limit = SIZE_MAX) const;
+
+  struct ResultCount {
+    size_t count = 0;
+    bool exact = true;
+    size_t errorBound = 0; // полуширина 95% интервала для оценки
+  };
+
+  /**
+   * @brief Считает документы булева запроса, не строя список результатов
+   *
+   * Одиночный термин берёт df из словаря, составные запросы вычисляются
+   * над DocBitmap с подсчётом через popcount. Очень большие объединения
+   * оцениваются выборкой Карпа-Луби с указанием погрешности.
+   *
+   * @throws std::invalid_argument при синтаксической ошибке
+   */
+  ResultCount countBoolean(const std::string &queryStr) const;
+
+  /**
+   * @brief Число документов выдачи булева запроса по каждому хосту
+   * @return Не более limit хостов по убыванию счётчика
+   */
+  std::vector<FacetIndex::FacetCount>
+  hostFacets(const std::string &queryStr, size_t limit) const;
+
+  /**
+   * @brief Разбирает и переписывает булев запрос в план выполнения
+   * @throws std::invalid_argument при синтаксической ошибке
+   */
+  QueryNode parseQuery(const std::string &queryStr) const;
+
+  /**
+   * @brief Ранжирует по TF-IDF только документы, прошедшие булев фильтр
+   *
+   * Документы перебираются по плану булева запроса, а каждый прошедший
+   * сразу оценивается по положительным терминам запроса и попадает в кучу
+   * лучших k. Ни карта оценок, ни множество кандидатов не строятся.
+   *
+   * @throws std::invalid_argument при синтаксической ошибке
+   */
+  std::vector<ScoredDocument> searchBooleanRanked(const std::string &queryStr,
+                                                  size_t k) const;
+
+  // --------------------------------------------------------------------------
+  // Постраничная выдача. Курсор — последний выданный документ, поэтому
+  // между запросами ничего не хранится, а следующая страница
+  // пропускает уже выданное без сортировки всех кандидатов.
+  // --------------------------------------------------------------------------
+
+  struct BooleanPage {
+    std::vector<int> docIds;
+    int next = 0; // курсор для следующей страницы
+    bool hasMore = false;
+  };
+
+  /**
+   * @brief Страница булевой выдачи после документа afterDocId (0 — начало)
+   */
+  BooleanPage searchBooleanPage(const std::string &queryStr, int afterDocId,
+                                size_t pageSize) const;
+
+  struct RankCursor {
+    double score = std::numeric_limits<double>::infinity();
+    int docId = -1;
+  };
+
+  struct RankedPage {
+    std::vector<ScoredDocument> results;
+    RankCursor next;
+    bool hasMore = false;
+    size_t scored = 0; // оценено документов до остановки
+    bool fromChampions = false; // полные списки не понадобились
+  };
+
+  /**
+   * @brief Страница ранжированной выдачи после курсора (оценка, docId)
+   *
+   * Документы упорядочены по убыванию оценки, затем по docId. В куче
+   * держится только pageSize + 1 документ, всё, что не дальше курсора,
+   * отбрасывается сразу после оценки. Если docId назначены по убыванию
+   * априорной оценки (setDocOrder), обход прекращается, как только худший
+   * документ кучи не хуже верхней границы оценки оставшихся документов.
+   *
+   * Первая страница сначала считается по спискам чемпионов терминов и
+   * берётся из них, если границы оценок доказывают её полноту.
+   */
+  RankedPage searchTfIdfPage(const std::string &queryStr,
+                             const RankCursor &after, size_t pageSize) const;
+  RankedPage searchBooleanRankedPage(const std::string &queryStr,
+                                     const RankCursor &after,
+                                     size_t pageSize) const;
+  std::vector<ScoredDocument> searchTfIdf(const std::string &queryStr) const;
+
+  /**
+   * @brief Локальная статистика термина запроса
+   */
+  struct TermStats {
+    size_t docFrequency = 0;
+    bool exact = false; // термин есть в индексе (не раскрытие)
+  };
+
+  /**
+   * @brief Статистика коллекции для оценки: число документов, суммарная
+   * длина и df терминов запроса
+   *
+   * Шард отдаёт локальную статистику, координатор складывает её по шардам и
+   * передаёт обратно, поэтому оценки совпадают с единым индексом.
+   */
+  struct CollectionStats {
+    long long documents = 0;
+    double totalLength = 0.0;
+    std::map<std::string, TermStats> terms;
+
+    /**
+     * @brief Добавляет статистику другого шарда; если термин где-то найден
+     * точно, складываются только точные df (раскрытия отбрасываются)
+     */
+    void merge(const CollectionStats &other);
+    double averageLength() const {
+      return documents > 0 && totalLength > 0.0 ? totalLength / documents
+                                                : 1.0;
+    }
+  };
+
+  CollectionStats collectionStats(const std::string &queryStr) const;
+
+  /**
+   * @brief Ранжированный поиск с df и N всей коллекции вместо локальных
+   */
+  std::vector<ScoredDocument>
+  searchTfIdf(const std::string &queryStr,
+              const CollectionStats &global) const;
+
+  /**
+   * @brief Как документы делятся между шардами при индексации
+   */
+  enum class ShardBy { DocId, Hash };
+
+  /**
+   * @brief Индексировать и загружать только шард shard из shardCount
+   *
+   * Файлы индекса шарда лежат в подкаталоге shard_<номер> каталога индекса.
+   * Документы шарда нумеруются подряд в общем порядке, а глобальный docId
+   * (позиция в общем порядке) хранится в поле global_id. Выдача шардов
+   * совпадает с единым индексом только при DuplicatePolicy::Keep.
+   */
+  void setShard(size_t shard, size_t shardCount, ShardBy by = ShardBy::DocId);
+
+  /**
+   * @return Глобальный docId документа (сам docId без шардирования)
+   */
+  int globalDocId(int docId) const;
+
+  /**
+   * @brief Априорная оценка документа для назначения docId
+   */
+  enum class DocOrder { Directory, Recency, UrlDepth, Length };
+
+  /**
+   * @brief Задаёт порядок docId для следующей индексации и вес априорной
+   * оценки в ранжировании
+   *
+   * При порядке, отличном от Directory, документы получают docId по
+   * убыванию априорной оценки (свежесть по download_timestamp, малая
+   * глубина URL или длина текста), нормированной в [0, 1] и сохранённой
+   * в столбце static_rank. К TF-IDF прибавляется staticWeight * оценка.
+   */
+  void setDocOrder(DocOrder order, double staticWeight);
+
+  /**
+   * @brief Модель оценки для ранжированного поиска (searchTfIdf и
+   * постраничных выдач); выбирается один раз на запрос, и каждый обход
+   * выполняется своей специализацией (см. Scoring)
+   */
+  enum class ScoringModel { TfIdf, Bm25, Bm25Plus, Count };
+
+  void setScoringModel(ScoringModel model) { m_config.scoringModel = model; }
+
+  /**
+   * @brief Что делать с почти-дубликатами (SimHash, расстояние Хэмминга
+   * не больше duplicateDistance)
+   *
+   * Keep (по умолчанию) индексирует всё как есть, Skip не индексирует
+   * дубликаты, Collapse индексирует, но в ранжированной выдаче оставляет от
+   * кластера только лучший совпавший с запросом документ и показывает число
+   * похожих. Отпечатки считаются при индексации не в режиме Keep.
+   */
+  enum class DuplicatePolicy { Keep, Skip, Collapse };
+
+  void setDuplicatePolicy(DuplicatePolicy policy) {
+    m_config.duplicatePolicy = policy;
+  }
+
+  /**
+   * @return Число документов в кластере почти-дубликатов документа
+   */
+  size_t duplicateClusterSize(int docId) const;
+
+  enum class ReorderMethod { Url, GraphBisection };
+
+  struct ReorderStats {
+    size_t postings = 0;
+    size_t bytesBefore = 0;
+    size_t bytesAfter = 0;
+
+    double bitsPerPostingBefore() const {
+      return postings ? 8.0 * bytesBefore / postings : 0.0;
+    }
+    double bitsPerPostingAfter() const {
+      return postings ? 8.0 * bytesAfter / postings : 0.0;
+    }
+  };
+
+  /**
+   * @brief Перенумеровывает документы построенного индекса для сжатия
+   *
+   * Url сортирует документы по хосту и пути URL, GraphBisection —
+   * рекурсивной бисекцией по множествам терминов документов. Списки,
+   * имена, длины, хранилище текстов и числовые столбцы переписываются
+   * согласованно; индекс нужно сохранить отдельно (saveIndex). Порядок по
+   * априорной оценке при этом теряется.
+   *
+   * @return Размер списков до и после (пары docId, tf)
+   */
+  ReorderStats reorderDocuments(ReorderMethod method);
+
+  enum class PruneMethod { TermCentric, DocumentCentric };
+
+  struct PruneStats {
+    size_t postingsBefore = 0;
+    size_t postingsAfter = 0;
+    size_t bytesBefore = 0;
+    size_t bytesAfter = 0;
+    size_t queries = 0;
+    // Средний recall@k прореженного индекса относительно полного
+    double recall = 1.0;
+    // false, если hot_index.bin не записан; recall тогда не измеряется
+    bool saved = false;
+  };
+
+  /**
+   * @brief Строит прореженный «горячий» индекс и сохраняет его рядом с
+   * полным (hot_index.bin)
+   *
+   * Вклад posting — его TF-IDF. TermCentric оставляет в списке postings не
+   * ниже level * (k-я оценка списка), DocumentCentric — долю level
+   * терминов каждого документа с наибольшим вкладом. Запросы из queries
+   * выполняются по обоим индексам, и recall@k сравнивает первые k
+   * результатов. Полный индекс в памяти и на диске не меняется.
+   *
+   * @throws std::invalid_argument если level вне [0, 1]
+   */
+  PruneStats pruneIndex(PruneMethod method, double level,
+                        const std::vector<std::string> &queries,
+                        size_t k = 10);
+
+  /**
+   * @brief При загрузке заменить списки полного индекса прореженными, если
+   * hot_index.bin есть
+   *
+   * df, N и границы оценок берутся из словаря полного индекса во всех
+   * путях ранжирования; df раскрытых терминов — размер объединения
+   * прореженных списков. Списки чемпионов отключаются. Выдача и счётчики
+   * countBoolean отражают только горячий уровень: обращения к полному
+   * индексу во время запроса нет.
+   */
+  void setHotTier(bool enabled) { m_config.useHotTier = enabled; }
+
+  /**
+   * @brief Раскрывать неизвестный термин запроса как нечёткий ("слово~"),
+   * выключено по умолчанию; термины под NOT и "-" не раскрываются никогда
+   */
+  void setFuzzyFallback(bool enabled) { m_config.fuzzyFallback = enabled; }
+
+  /**
+   * @brief Размер списков чемпионов (0 — не строить и не использовать);
+   * действует при следующей индексации или загрузке
+   */
+  void setChampionListSize(size_t size) { m_config.championListSize = size; }
+
+  /**
+   * @brief Потоки для сортировки и сжатия накопленных пар в конце индексации
+   * (0 — по числу ядер, см. setDirectPostings); результат от числа потоков
+   * не зависит
+   */
+  void setIndexThreads(size_t threads) { m_config.indexThreads = threads; }
+
+  /**
+   * @brief Сжимать списки сразу при обработке документа (по умолчанию)
+   * вместо накопления пар (docId, tf) с сортировкой в конце индексации
+   *
+   * Прямое накопление дописывает delta-VByte в байтовые буферы терминов и
+   * держит в памяти только сжатые списки; индекс получается тем же.
+   */
+  void setDirectPostings(bool enabled) { m_config.directPostings = enabled; }
+
+  /**
+   * @brief Делит документы на partitions диапазонов docId, которые булев
+   * поиск и ранжирование обходят параллельно (1 — последовательно)
+   *
+   * Для длинных списков запоминаются позиции входа в каждый диапазон, поэтому
+   * поток не распаковывает начало списка. Результаты совпадают с
+   * последовательным обходом.
+   */
+  void setQueryPartitions(size_t partitions);
+  size_t queryPartitions() const {
+    return m_partitionBounds.empty() ? 1 : m_partitionBounds.size() - 1;
+  }
+  bool hotTierLoaded() const { return m_hotTierLoaded; }
+  std::vector<std::string> expandTermPattern(const std::string &pattern) const;
+  std::vector<std::string> expandFuzzyTerm(const std::string &word,
+                                           int maxEdits) const;
+  std::string suggestQuery(const std::string &queryStr) const;
+  std::vector<CompletionTrie::Completion>
+  autocomplete(const std::string &prefix, size_t k) const;
+
+  /**
+   * @brief Текст документа из хранилища, либо с диска, если хранилище не
+   * построено
+   */
+  std::string documentText(int docId) const;
+
+  /**
+   * @brief Фрагмент документа с выделенными терминами запроса
+   */
+  std::string snippet(int docId, const std::string &queryStr) const;
+
 private:
   struct Config {
     std::string dataDir;
@@ -257,10 +621,44 @@ private:
     std::string docNamesPath;
     std::string docLengthsPath;
     std::string docUrlsPath;
+    std::string spellIndexPath;
+    std::string docStorePath;
+    std::string docValuesPath;
+    std::string hotIndexPath;
+    std::string championsPath;
 
     double minTfIdfScore = 0.05;
     size_t topKResults = 10;
     size_t zipfTopTerms = 15;
+    size_t maxFuzzyExpansions = 50;
+    bool fuzzyFallback = false;
+    int spellMaxEdits = 2;
+    size_t countSampleThreshold = 1 << 20;
+    size_t countSamples = 4096;
+    bool buildNgramIndex = true;
+    bool buildDocStore = true;
+    size_t docStoreBlockSize = DocumentStore::DEFAULT_BLOCK_SIZE;
+    bool showSnippets = true;
+    size_t snippetWords = 30;
+    size_t facetLimit = 5;
+    DocOrder docOrder = DocOrder::Directory;
+    double staticWeight = 0.0;
+    ScoringModel scoringModel = ScoringModel::TfIdf;
+    DuplicatePolicy duplicatePolicy = DuplicatePolicy::Keep;
+    int duplicateDistance = DuplicateClusters::DEFAULT_MAX_DISTANCE;
+    size_t minFingerprintTerms = 20;
+    bool useHotTier = false;
+    size_t championListSize = ChampionLists::DEFAULT_LIST_SIZE;
+    size_t queryPartitions = 1;
+    size_t indexThreads = 0;
+    bool directPostings = true;
+    size_t shard = 0;
+    size_t shardCount = 1;
+    ShardBy shardBy = ShardBy::DocId;
+    // Позиции входа в диапазоны хранятся для списков не короче этого
+    size_t minSkipPostings = 64;
+    std::string highlightBegin = "\033[1m";
+    std::string highlightEnd = "\033[0m";
   };
 
   Config m_config;
@@ -270,42 +668,99 @@ private:
   CustomHashMap<int, std::string> m_docNames;
   CustomHashMap<int, int> m_docLengths;
   CustomHashMap<int, std::string> m_docUrls;
+  // Числовые поля реестра: имя -> (номер в реестре -> значение)
+  std::map<std::string, CustomHashMap<int, int64_t>> m_registryFields;
+  TermDictionary m_termDictionary;
+  SpellIndex m_spellIndex;
+  NgramIndex m_ngramIndex;
+  CompletionTrie m_completionTrie;
+  DocumentStore m_documentStore;
+  FacetIndex m_hostFacets;
+  DocValues m_docValues;
+  // Априорные оценки по docId и признак их невозрастания
+  std::vector<double> m_staticScores;
+  bool m_staticOrdered = false;
+  DuplicateClusters m_duplicates;
+  ChampionLists m_championLists;
+  bool m_hotTierLoaded = false;
+  // Границы вклада по id термина в словаре
+  std::vector<Scoring::TermBounds> m_termBounds;
+  // Длина документа по docId (0 — нет документа) для поблочной оценки
+  std::vector<double> m_lengthTable;
+  double m_averageLength = 1.0;
+  double m_totalLength = 0.0;
+  // Границы диапазонов docId: диапазон r — [bounds[r], bounds[r + 1])
+  std::vector<int> m_partitionBounds;
+  // Позиция входа в каждый диапазон по адресу сжатого списка
+  std::unordered_map<const std::vector<uint8_t> *,
+                     std::vector<PostingIterator::Position>>
+      m_rangeSkips;
+  std::unique_ptr<ThreadPool> m_workers;
   long long m_totalDocsCount;
 
-  struct BooleanQuery {
-    std::vector<std::string> requiredTerms;
-    std::vector<std::string> excludedTerms;
-    std::vector<std::string> optionalTerms;
-
-    bool hasRequiredTerms() const { return !requiredTerms.empty(); }
-    bool hasOptionalTerms() const { return !optionalTerms.empty(); }
-  };
-
-  BooleanQuery parseBooleanQuery(const std::string &query) const;
-  std::set<int> getDocumentsForTerm(const std::string &term) const;
-  std::vector<int> executeBooleanQuery(const BooleanQuery &query) const;
-  bool
-  verifyRequiredTermsInDocument(int docId,
-                                const std::vector<std::string> &terms) const;
-
-  struct ScoredDocument {
-    int docId;
-    double score;
-
-    bool operator>(const ScoredDocument &other) const {
-      return score > other.score;
-    }
-  };
-
-  std::map<int, double>
-  calculateTfIdfScores(const std::vector<std::string> &queryTerms) const;
-
-  double calculateTfIdf(int termFreq, int docLength, int docsWithTerm) const;
+  std::vector<std::string> expandQueryTerm(const std::string &term) const;
+  bool isExpandedTerm(const std::string &term) const;
+  std::vector<const std::vector<uint8_t> *>
+  getPostingListsForTerm(const std::string &term) const;
+  std::vector<std::pair<int, int>>
+  getPostingsForTerm(const std::string &term) const;
+  size_t estimateDocFrequency(const std::string &term) const;
+  // searchTfIdfPage; champions = false оценивает только по спискам
+  RankedPage rankTfIdfPage(const std::string &queryStr, const RankCursor &after,
+                           size_t pageSize, bool champions) const;
+  template <typename Policy>
+  RankedPage rankByPlan(const QueryNode &plan,
+                        const std::vector<std::string> &scoringTerms,
+                        const RankCursor &after, size_t pageSize) const;
+  Scoring::TermBounds termBounds(const std::string &term) const;
+  std::unique_ptr<DocIterator>
+  compilePlan(const QueryNode &plan, const SkipLookup &skips = {}) const;
+  SkipLookup partitionSkips(size_t partition) const;
+  void forEachPartition(const std::function<void(size_t)> &task) const;
+  DocBitmap evaluateBitmap(const QueryNode &node) const;
+  const DocValuesColumn *findRangeFilter(const std::string &field,
+                                         const std::string &value,
+                                         int64_t &min, int64_t &max) const;
+  ResultCount
+  estimateUnionCount(const std::vector<const std::vector<uint8_t> *> &lists,
+                     size_t totalPostings) const;
+
+  template <typename Policy>
+  std::vector<ScoredDocument>
+  calculateScores(const std::vector<std::string> &queryTerms,
+                  const CollectionStats *global = nullptr) const;
 
   std::vector<ScoredDocument>
-  rankDocuments(const std::map<int, double> &scores) const;
+  rankDocuments(std::vector<ScoredDocument> scores) const;
+
+  void buildTermDictionary();
+  void buildFacetIndex();
+  void buildDocValues();
+  void loadStaticScores();
+  void buildDuplicateClusters();
+  void buildLengthTable();
+  void buildChampionLists();
+  void buildPartitions();
+  template <typename Policy>
+  bool rankByChampions(const std::vector<std::string> &scoringTerms,
+                       size_t pageSize, RankedPage &page) const;
+  std::vector<int> reorderPermutation(ReorderMethod method) const;
+  std::vector<std::pair<std::string, int64_t>>
+  orderDocuments(std::vector<std::string> files) const;
+  double staticPrior(int docId) const;
+  double minScore() const;
+  // Отпечаток словаря и таблицы длин для проверки doc_store.bin
+  uint64_t indexFingerprint() const;
+  // Представитель кластера почти-дубликатов или -1, если похожих нет
+  int duplicateCluster(int docId) const;
+  // Оставляет от каждого кластера лучший документ выдачи
+  void collapseDuplicates(std::vector<ScoredDocument> &scores) const;
 
   bool loadDictionary();
+  bool loadHotTier();
+  bool saveHotTier(
+      const CustomHashMap<std::string, std::vector<uint8_t>> &hotIndex) const;
+  void pinNegatedTerms(QueryNode &node, bool negated) const;
   bool loadDocUrls();
   bool loadIndexMetadata();
   bool saveIndexMetadata();
@@ -315,17 +770,28 @@ private:
     std::string filename;
     int wordCount;
     std::map<std::string, int> termFrequencies;
+    std::string content;
+    bool fingerprinted = false;
+    uint64_t fingerprint = 0;
   };
 
   DocumentStats processDocument(const std::string &filePath, int docId);
 
   void buildInvertedIndex(const std::vector<DocumentStats> &docStats);
 
+  int registryId(int docId) const;
+  const std::string *findDocumentUrl(int docId) const;
   std::string getDocumentUrl(int docId) const;
   std::string getDocumentPath(int docId) const;
   void displayMenu() const;
-  void displaySearchResults(const std::vector<int> &docIds) const;
-  void displayTfIdfResults(const std::vector<ScoredDocument> &results) const;
+  std::vector<std::string> snippetTerms(const std::string &queryStr) const;
+  void displaySnippet(int docId, const std::vector<std::string> &terms) const;
+  void displaySearchResults(const std::vector<int> &docIds,
+                            const ResultCount &count,
+                            const std::string &queryStr, bool hasMore) const;
+  void displayTfIdfResults(const std::vector<ScoredDocument> &results,
+                           const std::string &queryStr, size_t firstRank,
+                           bool hasMore) const;
 
   struct TermStatistics {
     std::string term;
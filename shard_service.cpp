@@ -0,0 +1,411 @@
+#include "shard_service.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t STATS_REQUEST = 'S';
+const uint8_t SEARCH_REQUEST = 'Q';
+const uint32_t MAX_MESSAGE_SIZE = 64u << 20;
+
+class MessageWriter {
+public:
+  void u8(uint8_t value) { m_data.push_back(static_cast<char>(value)); }
+  void u32(uint32_t value) { raw(&value, sizeof(value)); }
+  void u64(uint64_t value) { raw(&value, sizeof(value)); }
+
+  // Оценки передаются побитово, чтобы слияние совпало с единым индексом
+  void f64(double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u64(bits);
+  }
+
+  void string(const std::string &value) {
+    u32(static_cast<uint32_t>(value.size()));
+    m_data += value;
+  }
+
+  const std::string &data() const { return m_data; }
+
+private:
+  void raw(const void *value, size_t size) {
+    m_data.append(static_cast<const char *>(value), size);
+  }
+
+  std::string m_data;
+};
+
+class MessageReader {
+public:
+  explicit MessageReader(const std::string &data) : m_data(data) {}
+
+  uint8_t u8() {
+    uint8_t value = 0;
+    raw(&value, sizeof(value));
+    return value;
+  }
+
+  uint32_t u32() {
+    uint32_t value = 0;
+    raw(&value, sizeof(value));
+    return value;
+  }
+
+  uint64_t u64() {
+    uint64_t value = 0;
+    raw(&value, sizeof(value));
+    return value;
+  }
+
+  double f64() {
+    uint64_t bits = u64();
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string string() {
+    uint32_t size = u32();
+    if (size > m_data.size() - m_offset) {
+      throw std::runtime_error("Truncated shard message");
+    }
+    std::string value = m_data.substr(m_offset, size);
+    m_offset += size;
+    return value;
+  }
+
+private:
+  void raw(void *value, size_t size) {
+    if (size > m_data.size() - m_offset) {
+      throw std::runtime_error("Truncated shard message");
+    }
+    std::memcpy(value, m_data.data() + m_offset, size);
+    m_offset += size;
+  }
+
+  const std::string &m_data;
+  size_t m_offset = 0;
+};
+
+void writeStats(MessageWriter &writer,
+                const SearchEngine::CollectionStats &stats) {
+  writer.u64(static_cast<uint64_t>(stats.documents));
+  writer.f64(stats.totalLength);
+  writer.u32(static_cast<uint32_t>(stats.terms.size()));
+  for (const auto &entry : stats.terms) {
+    writer.string(entry.first);
+    writer.u64(entry.second.docFrequency);
+    writer.u8(entry.second.exact ? 1 : 0);
+  }
+}
+
+SearchEngine::CollectionStats readStats(MessageReader &reader) {
+  SearchEngine::CollectionStats stats;
+  stats.documents = static_cast<long long>(reader.u64());
+  stats.totalLength = reader.f64();
+  for (uint32_t count = reader.u32(); count > 0; --count) {
+    std::string term = reader.string();
+    SearchEngine::TermStats &termStats = stats.terms[term];
+    termStats.docFrequency = reader.u64();
+    termStats.exact = reader.u8() != 0;
+  }
+  return stats;
+}
+
+bool sendAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+bool receiveAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t received = ::recv(fd, data, size, 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      return false;
+    }
+    data += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+bool sendMessage(int fd, const std::string &payload) {
+  uint32_t size = static_cast<uint32_t>(payload.size());
+  return sendAll(fd, reinterpret_cast<const char *>(&size), sizeof(size)) &&
+         sendAll(fd, payload.data(), payload.size());
+}
+
+bool receiveMessage(int fd, std::string &payload) {
+  uint32_t size = 0;
+  if (!receiveAll(fd, reinterpret_cast<char *>(&size), sizeof(size)) ||
+      size > MAX_MESSAGE_SIZE) {
+    return false;
+  }
+  payload.resize(size);
+  return receiveAll(fd, &payload[0], size);
+}
+
+bool socketAddress(const std::string &path, sockaddr_un &address) {
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "Error: Socket path is too long: " << path << std::endl;
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+} // namespace
+
+ShardServer::ShardServer(const SearchEngine &engine, std::string socketPath)
+    : m_engine(engine), m_socketPath(std::move(socketPath)) {}
+
+ShardServer::~ShardServer() {
+  stop();
+  if (m_listenFd >= 0) {
+    ::close(m_listenFd);
+    ::unlink(m_socketPath.c_str());
+  }
+}
+
+bool ShardServer::listen() {
+  sockaddr_un address;
+  if (!socketAddress(m_socketPath, address)) {
+    return false;
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    std::cerr << "Error: Cannot create socket: " << std::strerror(errno)
+              << std::endl;
+    return false;
+  }
+
+  ::unlink(m_socketPath.c_str());
+  if (::bind(fd, reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(fd, 16) != 0) {
+    std::cerr << "Error: Cannot listen on " << m_socketPath << ": "
+              << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  m_listenFd = fd;
+  return true;
+}
+
+void ShardServer::serve() {
+  while (!m_stopping) {
+    int fd = ::accept(m_listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_stopping) {
+        ::close(fd);
+        break;
+      }
+      m_clientFds.insert(fd);
+    }
+
+    // Поиск по индексу только читает его, поэтому соединения независимы
+    std::thread([this, fd] {
+      handle(fd);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_clientFds.erase(fd);
+      ::close(fd);
+      if (m_clientFds.empty()) {
+        m_idle.notify_all();
+      }
+    }).detach();
+  }
+
+  // Оставшиеся соединения закрываются; потоки ссылаются на сервер
+  stop();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this] { return m_clientFds.empty(); });
+}
+
+void ShardServer::stop() {
+  m_stopping = true;
+
+  // shutdown будит accept() и recv() в потоке serve()
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_listenFd >= 0) {
+    ::shutdown(m_listenFd, SHUT_RDWR);
+  }
+  for (int fd : m_clientFds) {
+    ::shutdown(fd, SHUT_RDWR);
+  }
+}
+
+void ShardServer::handle(int fd) {
+  std::string request;
+  while (!m_stopping && receiveMessage(fd, request)) {
+    MessageWriter reply;
+    try {
+      MessageReader reader(request);
+      uint8_t type = reader.u8();
+      std::string query = reader.string();
+
+      if (type == STATS_REQUEST) {
+        writeStats(reply, m_engine.collectionStats(query));
+      } else if (type == SEARCH_REQUEST) {
+        size_t k = reader.u32();
+        auto results = m_engine.searchTfIdf(query, readStats(reader));
+        results.resize(std::min(results.size(), k));
+
+        reply.u32(static_cast<uint32_t>(results.size()));
+        for (const auto &result : results) {
+          int globalId = m_engine.globalDocId(result.docId);
+          reply.u32(static_cast<uint32_t>(globalId));
+          reply.f64(result.score);
+        }
+      } else {
+        std::cerr << "Error: Unknown shard request" << std::endl;
+        return;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << "Error: Bad shard request: " << e.what() << std::endl;
+      return;
+    }
+
+    if (!sendMessage(fd, reply.data())) {
+      return;
+    }
+  }
+}
+
+ShardCoordinator::ShardCoordinator(std::vector<std::string> socketPaths)
+    : m_socketPaths(std::move(socketPaths)) {}
+
+ShardCoordinator::~ShardCoordinator() { close(); }
+
+bool ShardCoordinator::connect() {
+  close();
+
+  for (const auto &path : m_socketPaths) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+      close();
+      return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 ||
+        ::connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                  sizeof(address)) != 0) {
+      std::cerr << "Error: Cannot connect to shard " << path << ": "
+                << std::strerror(errno) << std::endl;
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      close();
+      return false;
+    }
+    m_sockets.push_back(fd);
+  }
+  return true;
+}
+
+void ShardCoordinator::close() {
+  for (int fd : m_sockets) {
+    ::close(fd);
+  }
+  m_sockets.clear();
+}
+
+std::vector<std::string>
+ShardCoordinator::broadcast(const std::string &request) {
+  for (size_t shard = 0; shard < m_sockets.size(); ++shard) {
+    if (!sendMessage(m_sockets[shard], request)) {
+      throw std::runtime_error("Lost connection to shard " +
+                               m_socketPaths[shard]);
+    }
+  }
+
+  std::vector<std::string> replies(m_sockets.size());
+  for (size_t shard = 0; shard < m_sockets.size(); ++shard) {
+    if (!receiveMessage(m_sockets[shard], replies[shard])) {
+      throw std::runtime_error("Lost connection to shard " +
+                               m_socketPaths[shard]);
+    }
+  }
+  return replies;
+}
+
+SearchEngine::CollectionStats
+ShardCoordinator::collectionStats(const std::string &queryStr) {
+  MessageWriter request;
+  request.u8(STATS_REQUEST);
+  request.string(queryStr);
+
+  SearchEngine::CollectionStats stats;
+  for (const auto &reply : broadcast(request.data())) {
+    MessageReader reader(reply);
+    stats.merge(readStats(reader));
+  }
+  return stats;
+}
+
+std::vector<SearchEngine::ScoredDocument>
+ShardCoordinator::searchTfIdf(const std::string &queryStr, size_t k) {
+  SearchEngine::CollectionStats stats = collectionStats(queryStr);
+
+  MessageWriter request;
+  request.u8(SEARCH_REQUEST);
+  request.string(queryStr);
+  request.u32(static_cast<uint32_t>(std::min<size_t>(k, UINT32_MAX)));
+  writeStats(request, stats);
+
+  std::vector<SearchEngine::ScoredDocument> results;
+  for (const auto &reply : broadcast(request.data())) {
+    MessageReader reader(reply);
+    for (uint32_t count = reader.u32(); count > 0; --count) {
+      int docId = static_cast<int>(reader.u32());
+      results.push_back({docId, reader.f64()});
+    }
+  }
+
+  // Порядок выдачи единого индекса: по убыванию оценки, затем по docId
+  std::sort(results.begin(), results.end(),
+            [](const SearchEngine::ScoredDocument &a,
+               const SearchEngine::ScoredDocument &b) {
+              return a.score > b.score ||
+                     (a.score == b.score && a.docId < b.docId);
+            });
+  results.resize(std::min(results.size(), k));
+  return results;
+}
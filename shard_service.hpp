@@ -0,0 +1,108 @@
+#ifndef SHARD_SERVICE_HPP
+#define SHARD_SERVICE_HPP
+
+#include "search_engine.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// ShardServer
+// ============================================================================
+
+/**
+ * @brief Сервер шарда: отвечает координатору через локальный Unix-сокет
+ *
+ * Сообщения передаются с длиной (u32) впереди. Запрос статистики с текстом
+ * запроса возвращает локальную CollectionStats; запрос поиска с текстом,
+ * k и суммарной статистикой — k лучших документов шарда с глобальными
+ * docId. Каждое соединение обслуживается своим потоком до закрытия
+ * клиентом, поэтому несколько координаторов работают одновременно.
+ */
+class ShardServer {
+public:
+  ShardServer(const SearchEngine &engine, std::string socketPath);
+  ~ShardServer();
+
+  ShardServer(const ShardServer &) = delete;
+  ShardServer &operator=(const ShardServer &) = delete;
+
+  /**
+   * @brief Создаёт сокет (старый файл сокета удаляется)
+   */
+  bool listen();
+
+  /**
+   * @brief Обслуживает соединения, пока не вызван stop(); возвращается,
+   * когда завершены потоки всех соединений
+   */
+  void serve();
+
+  /**
+   * @brief Прерывает serve() из другого потока
+   */
+  void stop();
+
+private:
+  void handle(int fd);
+
+  const SearchEngine &m_engine;
+  std::string m_socketPath;
+  std::atomic<bool> m_stopping{false};
+  std::mutex m_mutex;
+  std::condition_variable m_idle;
+  int m_listenFd = -1;
+  std::set<int> m_clientFds;
+};
+
+// ============================================================================
+// ShardCoordinator
+// ============================================================================
+
+/**
+ * @brief Координатор: рассылает запрос шардам и сливает их выдачи
+ *
+ * Поиск идёт в два прохода: сбор локальной статистики терминов и поиск с
+ * суммарными df, N и средней длиной, поэтому оценки совпадают с единым
+ * индексом. Каждый проход сначала отправляет запрос всем шардам, затем
+ * читает ответы, и шарды считают одновременно.
+ */
+class ShardCoordinator {
+public:
+  explicit ShardCoordinator(std::vector<std::string> socketPaths);
+  ~ShardCoordinator();
+
+  ShardCoordinator(const ShardCoordinator &) = delete;
+  ShardCoordinator &operator=(const ShardCoordinator &) = delete;
+
+  bool connect();
+
+  /**
+   * @brief k лучших документов по всем шардам (глобальные docId)
+   * @throws std::runtime_error при обрыве связи с шардом
+   */
+  std::vector<SearchEngine::ScoredDocument>
+  searchTfIdf(const std::string &queryStr, size_t k);
+
+  /**
+   * @brief Суммарная статистика коллекции по терминам запроса
+   */
+  SearchEngine::CollectionStats collectionStats(const std::string &queryStr);
+
+private:
+  /**
+   * @brief Отправляет запрос всем шардам, затем читает ответы по порядку
+   */
+  std::vector<std::string> broadcast(const std::string &request);
+  void close();
+
+  std::vector<std::string> m_socketPaths;
+  std::vector<int> m_sockets;
+};
+
+#endif // SHARD_SERVICE_HPP
@@ -0,0 +1,173 @@
+#include "snippet_generator.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+struct Match {
+  size_t word;
+  size_t term;
+};
+
+void appendSeparator(const std::string &text, size_t begin, size_t end,
+                     std::string &out) {
+  for (size_t i = begin; i < end; ++i) {
+    char c = text[i];
+    if (c == '\n' || c == '\r' || c == '\t') {
+      c = ' ';
+    }
+    if (c == ' ' && !out.empty() && out.back() == ' ') {
+      continue;
+    }
+    out.push_back(c);
+  }
+}
+
+} // namespace
+
+SnippetGenerator::SnippetGenerator(size_t windowWords,
+                                   std::string highlightBegin,
+                                   std::string highlightEnd,
+                                   size_t maxScanBytes)
+    : m_windowWords(std::max<size_t>(windowWords, 1)),
+      m_maxScanBytes(maxScanBytes),
+      m_highlightBegin(std::move(highlightBegin)),
+      m_highlightEnd(std::move(highlightEnd)) {}
+
+SnippetGenerator::Snippet
+SnippetGenerator::generate(const std::string &text,
+                           const std::vector<std::string> &terms) const {
+  Snippet snippet;
+
+  std::vector<std::pair<uint64_t, size_t>> termHashes;
+  for (size_t i = 0; i < terms.size(); ++i) {
+    termHashes.emplace_back(TextUtils::wordHash(terms[i]), i);
+  }
+  std::sort(termHashes.begin(), termHashes.end());
+  size_t termCount = 0;
+  for (size_t i = 0; i < termHashes.size(); ++i) {
+    if (i == 0 || termHashes[i].first != termHashes[i - 1].first) {
+      termCount++;
+    }
+  }
+
+  std::vector<TextUtils::WordSpan> words;
+  std::vector<Match> matches;
+  size_t offset = 0;
+
+  // Читает следующее слово и запоминает его совпадение с термином
+  auto readWord = [&]() {
+    TextUtils::WordSpan span;
+    if (!TextUtils::nextWordSpan(text, offset, span)) {
+      return false;
+    }
+    words.push_back(span);
+
+    auto it = std::lower_bound(
+        termHashes.begin(), termHashes.end(),
+        std::make_pair(span.hash, static_cast<size_t>(0)));
+    if (it == termHashes.end() || it->first != span.hash) {
+      return true;
+    }
+
+    // Проверка на случай коллизии хешей
+    const std::string &term = terms[it->second];
+    if (TextUtils::toLowerCase(
+            text.substr(span.begin, span.end - span.begin)) == term) {
+      matches.push_back({words.size() - 1, it->second});
+    }
+    return true;
+  };
+
+  std::vector<size_t> counts(terms.size(), 0);
+  size_t distinct = 0;
+  size_t left = 0;
+  size_t bestDistinct = 0;
+  size_t bestHits = 0;
+  size_t bestLeft = 0;
+  size_t bestRight = 0;
+
+  // Окно, начатое совпадением left, закрыто: новых совпадений в нём нет
+  auto closeWindow = [&](size_t right) {
+    size_t hits = right - left;
+    if (distinct > bestDistinct ||
+        (distinct == bestDistinct && hits > bestHits)) {
+      bestDistinct = distinct;
+      bestHits = hits;
+      bestLeft = left;
+      bestRight = right;
+    }
+    if (--counts[matches[left].term] == 0) {
+      distinct--;
+    }
+    left++;
+  };
+
+  while (bestDistinct < termCount && offset < m_maxScanBytes && readWord()) {
+    size_t word = words.size() - 1;
+    bool matched = !matches.empty() && matches.back().word == word;
+    size_t right = matches.size() - (matched ? 1 : 0);
+    while (left < right && matches[left].word + m_windowWords <= word) {
+      closeWindow(right);
+    }
+    if (matched && counts[matches.back().term]++ == 0) {
+      distinct++;
+    }
+  }
+  size_t scanned = matches.size();
+  while (left < scanned) {
+    closeWindow(scanned);
+  }
+
+  size_t first = 0;
+  size_t last = 0;
+  if (bestHits > 0) {
+    first = matches[bestLeft].word;
+    last = matches[bestRight - 1].word;
+    snippet.matchCount = bestHits;
+    snippet.distinctTerms = bestDistinct;
+  }
+
+  // Центрируем совпадения внутри окна; слова окна дочитываются
+  size_t slack = m_windowWords - (last - first + 1);
+  size_t start = first > slack / 2 ? first - slack / 2 : 0;
+  while (words.size() < start + m_windowWords && readWord()) {
+  }
+  size_t end = std::min(words.size(), start + m_windowWords);
+  if (end - start < m_windowWords) {
+    start = end > m_windowWords ? end - m_windowWords : 0;
+  }
+
+  if (start > 0) {
+    snippet.text = "... ";
+  }
+
+  auto match = std::lower_bound(
+      matches.begin(), matches.end(), start,
+      [](const Match &m, size_t word) { return m.word < word; });
+
+  for (size_t i = start; i < end; ++i) {
+    if (i > start) {
+      appendSeparator(text, words[i - 1].end, words[i].begin, snippet.text);
+    }
+
+    bool highlighted = match != matches.end() && match->word == i;
+    if (highlighted) {
+      snippet.text += m_highlightBegin;
+      ++match;
+    }
+    snippet.text.append(text, words[i].begin, words[i].end - words[i].begin);
+    if (highlighted) {
+      snippet.text += m_highlightEnd;
+    }
+  }
+
+  if (end < words.size() || readWord()) {
+    snippet.text += " ...";
+  }
+
+  return snippet;
+}
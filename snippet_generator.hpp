@@ -0,0 +1,54 @@
+#ifndef SNIPPET_GENERATOR_HPP
+#define SNIPPET_GENERATOR_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// SnippetGenerator
+// ============================================================================
+
+/**
+ * @brief Выбор фрагмента документа, лучше всего покрывающего запрос
+ *
+ * Позиций терминов в индексе нет, поэтому слова читаются из текста по
+ * одному, без копирования, а термины запроса узнаются по хешу. Окно из
+ * windowWords слов сдвигается двумя указателями по позициям совпадений
+ * по мере чтения. Лучшим считается окно с наибольшим числом разных
+ * терминов запроса, затем с наибольшим числом вхождений. Как только
+ * закрытое окно содержит все термины, чтение прекращается; без этого
+ * просматриваются не больше maxScanBytes байт текста.
+ */
+class SnippetGenerator {
+public:
+  struct Snippet {
+    std::string text;
+    size_t matchCount = 0;
+    size_t distinctTerms = 0;
+  };
+
+  static constexpr size_t DEFAULT_MAX_SCAN_BYTES = 64 * 1024;
+
+  explicit SnippetGenerator(size_t windowWords = 30,
+                            std::string highlightBegin = "[",
+                            std::string highlightEnd = "]",
+                            size_t maxScanBytes = DEFAULT_MAX_SCAN_BYTES);
+
+  /**
+   * @brief Строит фрагмент с выделенными терминами
+   * @param text Текст документа
+   * @param terms Термины запроса в нижнем регистре
+   * @return Фрагмент; без совпадений — начало документа
+   */
+  Snippet generate(const std::string &text,
+                   const std::vector<std::string> &terms) const;
+
+private:
+  size_t m_windowWords;
+  size_t m_maxScanBytes;
+  std::string m_highlightBegin;
+  std::string m_highlightEnd;
+};
+
+#endif // SNIPPET_GENERATOR_HPP
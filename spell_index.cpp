@@ -0,0 +1,282 @@
+#include "spell_index.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <tuple>
+
+namespace {
+
+constexpr uint32_t SPELL_INDEX_MAGIC = 0x314C5053; // "SPL1"
+constexpr uint32_t SPELL_INDEX_VERSION = 1;
+
+struct SpellIndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t maxEdits;
+  uint32_t prefixLength;
+  uint64_t termCount;
+  uint64_t fingerprint;
+  uint64_t entryCount;
+};
+
+uint32_t hashCodes(const std::vector<uint32_t> &codes) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t code : codes) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      hash = (hash ^ ((code >> shift) & 0xFF)) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+void collectDeletes(const std::vector<uint32_t> &codes, int editsLeft,
+                    std::set<std::vector<uint32_t>> &deletes) {
+  if (editsLeft == 0 || codes.size() <= 1) {
+    return;
+  }
+
+  for (size_t i = 0; i < codes.size(); ++i) {
+    std::vector<uint32_t> shorter;
+    shorter.reserve(codes.size() - 1);
+    shorter.insert(shorter.end(), codes.begin(), codes.begin() + i);
+    shorter.insert(shorter.end(), codes.begin() + i + 1, codes.end());
+
+    if (deletes.insert(shorter).second) {
+      collectDeletes(shorter, editsLeft - 1, deletes);
+    }
+  }
+}
+
+std::set<std::vector<uint32_t>> prefixDeletes(const std::vector<uint32_t> &word,
+                                              size_t prefixLength,
+                                              int maxEdits) {
+  std::vector<uint32_t> prefix(
+      word.begin(), word.begin() + std::min(word.size(), prefixLength));
+
+  std::set<std::vector<uint32_t>> deletes = {prefix};
+  collectDeletes(prefix, maxEdits, deletes);
+  return deletes;
+}
+
+} // namespace
+
+void SpellIndex::build(const TermDictionary &dictionary, int maxEdits,
+                       size_t prefixLength) {
+  clear();
+  m_maxEdits = maxEdits;
+  m_prefixLength = static_cast<uint32_t>(prefixLength);
+
+  std::vector<std::pair<uint32_t, uint32_t>> entries;
+
+  dictionary.forEach(
+      0, dictionary.size(), [&](size_t id, const std::string &term) {
+        auto codes = TextUtils::stringToCodes(term);
+        for (const auto &deleted :
+             prefixDeletes(codes, prefixLength, maxEdits)) {
+          entries.emplace_back(hashCodes(deleted), static_cast<uint32_t>(id));
+        }
+        return true;
+      });
+
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+  m_ownedHashes.reserve(entries.size());
+  m_ownedTermIds.reserve(entries.size());
+  for (const auto &entry : entries) {
+    m_ownedHashes.push_back(entry.first);
+    m_ownedTermIds.push_back(entry.second);
+  }
+
+  m_fingerprint = dictionary.fingerprint();
+  m_termCount = dictionary.size();
+  bind(m_ownedHashes.data(), m_ownedTermIds.data(), entries.size());
+}
+
+bool SpellIndex::save(const std::string &filePath) const {
+  // Загруженный индекс отображён из filePath, перезаписывать его на месте
+  // нельзя
+  std::string tmpPath = filePath + ".tmp";
+  std::ofstream file(tmpPath, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  SpellIndexHeader header = {SPELL_INDEX_MAGIC,
+                             SPELL_INDEX_VERSION,
+                             static_cast<uint32_t>(m_maxEdits),
+                             m_prefixLength,
+                             m_termCount,
+                             m_fingerprint,
+                             m_entryCount};
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(m_hashes),
+             m_entryCount * sizeof(uint32_t));
+  file.write(reinterpret_cast<const char *>(m_termIds),
+             m_entryCount * sizeof(uint32_t));
+
+  file.close();
+  if (!file || std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool SpellIndex::load(const std::string &filePath,
+                      const TermDictionary &dictionary) {
+  clear();
+
+  if (!m_mapped.open(filePath) || m_mapped.size() < sizeof(SpellIndexHeader)) {
+    clear();
+    return false;
+  }
+
+  SpellIndexHeader header;
+  std::memcpy(&header, m_mapped.data(), sizeof(header));
+
+  size_t expectedSize =
+      sizeof(header) + header.entryCount * 2 * sizeof(uint32_t);
+
+  if (header.magic != SPELL_INDEX_MAGIC ||
+      header.version != SPELL_INDEX_VERSION ||
+      header.termCount != dictionary.size() ||
+      header.fingerprint != dictionary.fingerprint() ||
+      m_mapped.size() != expectedSize) {
+    clear();
+    return false;
+  }
+
+  m_maxEdits = static_cast<int>(header.maxEdits);
+  m_prefixLength = header.prefixLength;
+  m_fingerprint = header.fingerprint;
+  m_termCount = header.termCount;
+
+  const uint32_t *arrays =
+      reinterpret_cast<const uint32_t *>(m_mapped.data() + sizeof(header));
+  bind(arrays, arrays + header.entryCount, header.entryCount);
+  return true;
+}
+
+void SpellIndex::clear() {
+  m_ownedHashes.clear();
+  m_ownedTermIds.clear();
+  m_mapped.close();
+  m_hashes = nullptr;
+  m_termIds = nullptr;
+  m_entryCount = 0;
+  m_fingerprint = 0;
+  m_termCount = 0;
+}
+
+void SpellIndex::bind(const uint32_t *hashes, const uint32_t *termIds,
+                      size_t count) {
+  m_hashes = hashes;
+  m_termIds = termIds;
+  m_entryCount = count;
+}
+
+size_t SpellIndex::memoryUsage() const {
+  return m_entryCount * 2 * sizeof(uint32_t);
+}
+
+std::vector<SpellIndex::Suggestion>
+SpellIndex::suggest(const std::string &word, const TermDictionary &dictionary,
+                    size_t maxSuggestions) const {
+  std::vector<Suggestion> result;
+  if (m_entryCount == 0 || word.empty()) {
+    return result;
+  }
+
+  auto codes = TextUtils::stringToCodes(word);
+  std::vector<uint32_t> candidates;
+
+  const uint32_t *hashesEnd = m_hashes + m_entryCount;
+
+  for (const auto &deleted :
+       prefixDeletes(codes, m_prefixLength, m_maxEdits)) {
+    uint32_t hash = hashCodes(deleted);
+    auto range = std::equal_range(m_hashes, hashesEnd, hash);
+    for (const uint32_t *it = range.first; it != range.second; ++it) {
+      candidates.push_back(m_termIds[it - m_hashes]);
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  for (uint32_t id : candidates) {
+    if (id >= dictionary.size()) {
+      continue;
+    }
+
+    std::string term = dictionary.term(id);
+    int distance = optimalStringAlignmentDistance(
+        codes, TextUtils::stringToCodes(term), m_maxEdits);
+
+    if (distance <= m_maxEdits) {
+      result.push_back({term, distance, dictionary.collectionFrequency(id)});
+    }
+  }
+
+  std::sort(result.begin(), result.end(),
+            [](const Suggestion &a, const Suggestion &b) {
+              return std::make_tuple(a.distance, b.frequency, a.term) <
+                     std::make_tuple(b.distance, a.frequency, b.term);
+            });
+
+  if (result.size() > maxSuggestions) {
+    result.resize(maxSuggestions);
+  }
+
+  return result;
+}
+
+int optimalStringAlignmentDistance(const std::vector<uint32_t> &a,
+                                   const std::vector<uint32_t> &b,
+                                   int maxDistance) {
+  int lengthDiff = static_cast<int>(a.size()) - static_cast<int>(b.size());
+  if (std::abs(lengthDiff) > maxDistance) {
+    return maxDistance + 1;
+  }
+
+  std::vector<int> twoBack(b.size() + 1);
+  std::vector<int> previous(b.size() + 1);
+  std::vector<int> current(b.size() + 1);
+
+  for (size_t j = 0; j <= b.size(); ++j) {
+    previous[j] = static_cast<int>(j);
+  }
+
+  for (size_t i = 1; i <= a.size(); ++i) {
+    current[0] = static_cast<int>(i);
+    int rowMin = current[0];
+
+    for (size_t j = 1; j <= b.size(); ++j) {
+      int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+      current[j] = std::min({previous[j] + 1, current[j - 1] + 1,
+                             previous[j - 1] + cost});
+
+      if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+        current[j] = std::min(current[j], twoBack[j - 2] + 1);
+      }
+      rowMin = std::min(rowMin, current[j]);
+    }
+
+    if (rowMin > maxDistance) {
+      return maxDistance + 1;
+    }
+
+    std::swap(twoBack, previous);
+    std::swap(previous, current);
+  }
+
+  return std::min(previous[b.size()], maxDistance + 1);
+}
@@ -0,0 +1,97 @@
+#ifndef SPELL_INDEX_HPP
+#define SPELL_INDEX_HPP
+
+#include "file_utils.hpp"
+#include "term_dictionary.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// SpellIndex
+// ============================================================================
+
+/**
+ * @brief Индекс удалений для исправления опечаток (symmetric delete)
+ *
+ * Для каждого термина словаря заранее порождаются все варианты его префикса
+ * длины prefixLength с удалением до maxEdits символов. Хранится только
+ * отсортированный массив пар (хеш удаления, идентификатор термина), поэтому
+ * файл индекса отображается в память без разбора. Запрос порождает удаления
+ * слова и находит кандидатов бинарным поиском; итоговое расстояние
+ * проверяется по полным строкам из словаря.
+ */
+class SpellIndex {
+public:
+  struct Suggestion {
+    std::string term;
+    int distance;
+    uint64_t frequency;
+  };
+
+  /**
+   * @brief Строит индекс по словарю
+   * @param dictionary Словарь терминов
+   * @param maxEdits Максимальное расстояние подсказки (1-2)
+   * @param prefixLength Длина префикса, по которому порождаются удаления
+   */
+  void build(const TermDictionary &dictionary, int maxEdits = 2,
+             size_t prefixLength = 7);
+
+  bool save(const std::string &filePath) const;
+
+  /**
+   * @brief Отображает сохранённый индекс в память
+   * @param filePath Путь к файлу индекса
+   * @param dictionary Словарь, по которому индекс должен быть построен
+   * @return false если файла нет или он построен по другому словарю
+   */
+  bool load(const std::string &filePath, const TermDictionary &dictionary);
+
+  void clear();
+
+  bool empty() const { return m_entryCount == 0; }
+  size_t entryCount() const { return m_entryCount; }
+  size_t memoryUsage() const;
+
+  /**
+   * @brief Подбирает исправления для слова
+   * @param word Слово в нижнем регистре
+   * @param dictionary Словарь, по которому построен индекс
+   * @param maxSuggestions Максимальное число подсказок
+   * @return Подсказки по возрастанию расстояния, затем по убыванию
+   * коллекционной частоты
+   */
+  std::vector<Suggestion> suggest(const std::string &word,
+                                  const TermDictionary &dictionary,
+                                  size_t maxSuggestions = 5) const;
+
+private:
+  void bind(const uint32_t *hashes, const uint32_t *termIds, size_t count);
+
+  int m_maxEdits = 2;
+  uint32_t m_prefixLength = 7;
+  uint64_t m_fingerprint = 0;
+  uint64_t m_termCount = 0;
+
+  std::vector<uint32_t> m_ownedHashes;
+  std::vector<uint32_t> m_ownedTermIds;
+  FileUtils::MappedFile m_mapped;
+
+  const uint32_t *m_hashes = nullptr;
+  const uint32_t *m_termIds = nullptr;
+  size_t m_entryCount = 0;
+};
+
+/**
+ * @brief Расстояние Дамерау-Левенштейна (с перестановкой соседних символов)
+ * по кодовым точкам
+ * @return Расстояние или maxDistance + 1, если оно больше maxDistance
+ */
+int optimalStringAlignmentDistance(const std::vector<uint32_t> &a,
+                                   const std::vector<uint32_t> &b,
+                                   int maxDistance);
+
+#endif // SPELL_INDEX_HPP
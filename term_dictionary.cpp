@@ -0,0 +1,382 @@
+#include "term_dictionary.hpp"
+#include "compression_utils.hpp"
+#include "levenshtein_automaton.hpp"
+#include "text_utils.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+void TermDictionary::build(
+    const std::vector<std::pair<std::string, uint32_t>> &sortedTerms) {
+  std::vector<Entry> entries;
+  entries.reserve(sortedTerms.size());
+
+  for (const auto &term : sortedTerms) {
+    entries.emplace_back(term.first, term.second, term.second);
+  }
+
+  build(entries);
+}
+
+void TermDictionary::build(const std::vector<Entry> &sortedTerms) {
+  clear();
+
+  m_size = sortedTerms.size();
+  m_docFreqs.reserve(m_size);
+  m_collectionFreqs.reserve(m_size);
+  m_blockOffsets.reserve((m_size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+  const std::string *previous = nullptr;
+
+  for (size_t id = 0; id < m_size; ++id) {
+    const std::string &term = sortedTerms[id].term;
+
+    if (previous && !(*previous < term)) {
+      throw std::invalid_argument(
+          "Term dictionary input must be sorted and unique");
+    }
+
+    if (id % BLOCK_SIZE == 0) {
+      m_blockOffsets.push_back(static_cast<uint32_t>(m_data.size()));
+      CompressionUtils::vbyteEncode(static_cast<int>(term.size()), m_data);
+      m_data.insert(m_data.end(), term.begin(), term.end());
+    } else {
+      size_t lcp = 0;
+      size_t maxLcp = std::min(previous->size(), term.size());
+      while (lcp < maxLcp && (*previous)[lcp] == term[lcp]) {
+        lcp++;
+      }
+
+      CompressionUtils::vbyteEncode(static_cast<int>(lcp), m_data);
+      CompressionUtils::vbyteEncode(static_cast<int>(term.size() - lcp),
+                                    m_data);
+      m_data.insert(m_data.end(), term.begin() + lcp, term.end());
+    }
+
+    m_docFreqs.push_back(sortedTerms[id].docFrequency);
+    m_collectionFreqs.push_back(sortedTerms[id].collectionFrequency);
+    previous = &term;
+  }
+
+  m_data.shrink_to_fit();
+
+  m_fingerprint = 14695981039346656037ULL ^ m_size;
+  for (uint8_t byte : m_data) {
+    m_fingerprint = (m_fingerprint ^ byte) * 1099511628211ULL;
+  }
+}
+
+void TermDictionary::clear() {
+  m_data.clear();
+  m_blockOffsets.clear();
+  m_docFreqs.clear();
+  m_collectionFreqs.clear();
+  m_fingerprint = 0;
+  m_size = 0;
+}
+
+size_t TermDictionary::decodeEntry(size_t offset, std::string &term,
+                                   bool first) const {
+  size_t lcp = 0;
+  if (!first) {
+    lcp = CompressionUtils::vbyteDecode(m_data, offset);
+  }
+
+  size_t suffixLen = CompressionUtils::vbyteDecode(m_data, offset);
+  term.resize(lcp);
+  term.append(reinterpret_cast<const char *>(m_data.data() + offset),
+              suffixLen);
+
+  return offset + suffixLen;
+}
+
+std::string TermDictionary::blockFirstTerm(size_t block) const {
+  std::string term;
+  decodeEntry(m_blockOffsets[block], term, true);
+  return term;
+}
+
+std::string TermDictionary::term(size_t id) const {
+  if (id >= m_size) {
+    throw std::out_of_range("Term id out of range");
+  }
+
+  std::string result;
+  forEach(id, id + 1, [&result](size_t, const std::string &term) {
+    result = term;
+    return false;
+  });
+  return result;
+}
+
+size_t TermDictionary::lowerBound(const std::string &key) const {
+  if (m_size == 0) {
+    return 0;
+  }
+
+  size_t lo = 0;
+  size_t hi = m_blockOffsets.size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (blockFirstTerm(mid) <= key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo == 0) {
+    return 0;
+  }
+
+  size_t block = lo - 1;
+  size_t blockBegin = block * BLOCK_SIZE;
+  size_t blockEnd = std::min(blockBegin + BLOCK_SIZE, m_size);
+  size_t result = blockEnd;
+
+  forEach(blockBegin, blockEnd,
+          [&key, &result](size_t id, const std::string &term) {
+            if (term >= key) {
+              result = id;
+              return false;
+            }
+            return true;
+          });
+
+  return result;
+}
+
+bool TermDictionary::lookup(const std::string &term, size_t &id) const {
+  size_t candidate = lowerBound(term);
+  if (candidate >= m_size) {
+    return false;
+  }
+
+  bool found = false;
+  forEach(candidate, candidate + 1,
+          [&term, &found](size_t, const std::string &current) {
+            found = (current == term);
+            return false;
+          });
+
+  if (found) {
+    id = candidate;
+  }
+  return found;
+}
+
+std::pair<size_t, size_t>
+TermDictionary::prefixRange(const std::string &prefix) const {
+  size_t first = lowerBound(prefix);
+
+  std::string successor = prefix;
+  while (!successor.empty() &&
+         static_cast<unsigned char>(successor.back()) == 0xFF) {
+    successor.pop_back();
+  }
+
+  if (successor.empty()) {
+    return {first, m_size};
+  }
+
+  successor.back() = static_cast<char>(
+      static_cast<unsigned char>(successor.back()) + 1);
+
+  return {first, lowerBound(successor)};
+}
+
+std::vector<size_t> TermDictionary::matchWildcard(const std::string &pattern,
+                                                  size_t limit) const {
+  size_t literalEnd = pattern.find_first_of("*?");
+  auto range = prefixRange(pattern.substr(0, literalEnd));
+
+  bool prefixOnly = literalEnd != std::string::npos &&
+                    literalEnd + 1 == pattern.size() &&
+                    pattern[literalEnd] == '*';
+
+  std::vector<size_t> matching;
+  forEach(range.first, range.second,
+          [&](size_t id, const std::string &term) {
+            if (prefixOnly || wildcardMatch(pattern, term)) {
+              matching.push_back(id);
+            }
+            return true;
+          });
+
+  return mostFrequent(matching, limit);
+}
+
+std::vector<size_t> TermDictionary::mostFrequent(const std::vector<size_t> &ids,
+                                                 size_t limit) const {
+  if (ids.size() <= limit) {
+    return ids;
+  }
+
+  using Candidate = std::pair<uint32_t, size_t>;
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+      best;
+
+  for (size_t id : ids) {
+    best.push({m_docFreqs[id], id});
+    if (best.size() > limit) {
+      best.pop();
+    }
+  }
+
+  std::vector<size_t> result;
+  result.reserve(best.size());
+  while (!best.empty()) {
+    result.push_back(best.top().second);
+    best.pop();
+  }
+  std::sort(result.begin(), result.end());
+
+  return result;
+}
+
+std::vector<std::pair<size_t, int>>
+TermDictionary::matchFuzzy(const std::string &term, int maxEdits,
+                           size_t limit) const {
+  std::vector<std::pair<size_t, int>> result;
+  if (limit == 0 || m_size == 0) {
+    return result;
+  }
+
+  LevenshteinAutomaton automaton(term, maxEdits);
+
+  std::vector<LevenshteinAutomaton::State> states = {automaton.start()};
+  std::vector<uint32_t> previous;
+
+  // (расстояние, -df, id): в вершине кучи худший из отобранных
+  using Candidate = std::tuple<int, int64_t, size_t>;
+  std::priority_queue<Candidate> best;
+
+  size_t position = 0;
+  while (position < m_size) {
+    size_t jumpTo = m_size;
+
+    forEach(position, m_size, [&](size_t id, const std::string &current) {
+      std::vector<uint32_t> codes = TextUtils::stringToCodes(current);
+
+      size_t common = 0;
+      size_t maxCommon = std::min({codes.size(), previous.size(),
+                                   states.size() - 1});
+      while (common < maxCommon && codes[common] == previous[common]) {
+        common++;
+      }
+      states.resize(common + 1);
+      previous = codes;
+
+      for (size_t i = common; i < codes.size(); ++i) {
+        states.push_back(automaton.step(states.back(), codes[i]));
+
+        if (!automaton.canMatch(states.back())) {
+          std::vector<uint32_t> deadPrefix(codes.begin(),
+                                           codes.begin() + i + 1);
+          jumpTo = prefixRange(TextUtils::codesToString(deadPrefix)).second;
+          states.pop_back();
+          return false;
+        }
+      }
+
+      if (automaton.isMatch(states.back())) {
+        best.emplace(automaton.distance(states.back()),
+                     -static_cast<int64_t>(m_docFreqs[id]), id);
+        if (best.size() > limit) {
+          best.pop();
+        }
+      }
+
+      jumpTo = id + 1;
+      return true;
+    });
+
+    if (jumpTo <= position) {
+      break;
+    }
+    position = jumpTo;
+  }
+
+  result.reserve(best.size());
+  while (!best.empty()) {
+    result.emplace_back(std::get<2>(best.top()), std::get<0>(best.top()));
+    best.pop();
+  }
+  std::sort(result.begin(), result.end());
+
+  return result;
+}
+
+size_t TermDictionary::memoryUsage() const {
+  return m_data.capacity() + m_blockOffsets.capacity() * sizeof(uint32_t) +
+         m_docFreqs.capacity() * sizeof(uint32_t) +
+         m_collectionFreqs.capacity() * sizeof(uint64_t);
+}
+
+bool isWildcardPattern(const std::string &term) {
+  return term.find_first_of("*?") != std::string::npos;
+}
+
+bool wildcardMatch(const std::string &pattern, const std::string &term) {
+  std::vector<uint32_t> p = TextUtils::stringToCodes(pattern);
+  std::vector<uint32_t> t = TextUtils::stringToCodes(term);
+
+  size_t pi = 0;
+  size_t ti = 0;
+  size_t starPos = std::string::npos;
+  size_t starMatch = 0;
+
+  while (ti < t.size()) {
+    if (pi < p.size() && (p[pi] == '?' || p[pi] == t[ti])) {
+      pi++;
+      ti++;
+    } else if (pi < p.size() && p[pi] == '*') {
+      starPos = pi++;
+      starMatch = ti;
+    } else if (starPos != std::string::npos) {
+      pi = starPos + 1;
+      ti = ++starMatch;
+    } else {
+      return false;
+    }
+  }
+
+  while (pi < p.size() && p[pi] == '*') {
+    pi++;
+  }
+
+  return pi == p.size();
+}
+
+bool isFuzzyTerm(const std::string &term) {
+  return term.find('~') != std::string::npos;
+}
+
+int parseFuzzyTerm(const std::string &token, std::string &word) {
+  size_t tilde = token.find('~');
+  word = token.substr(0, tilde);
+
+  if (tilde == std::string::npos || tilde + 1 >= token.size()) {
+    return autoFuzziness(word);
+  }
+
+  char digit = token[tilde + 1];
+  if (digit < '0' || digit > '9') {
+    return autoFuzziness(word);
+  }
+  return std::min(digit - '0', 2);
+}
+
+int autoFuzziness(const std::string &word) {
+  size_t length = TextUtils::stringToCodes(word).size();
+  if (length < 3) {
+    return 0;
+  }
+  if (length <= 5) {
+    return 1;
+  }
+  return 2;
+}
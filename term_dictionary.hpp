@@ -0,0 +1,198 @@
+#ifndef TERM_DICTIONARY_HPP
+#define TERM_DICTIONARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// TermDictionary
+// ============================================================================
+
+/**
+ * @brief Отсортированный словарь терминов с блочным префиксным сжатием
+ *
+ * Термины хранятся блоками по BLOCK_SIZE: первый термин блока записан
+ * целиком, остальные - как (длина общего префикса, суффикс). Поиск идёт
+ * бинарным поиском по первым терминам блоков и линейным проходом внутри
+ * блока. Идентификатор термина - его позиция в лексикографическом порядке.
+ */
+class TermDictionary {
+public:
+  static constexpr size_t BLOCK_SIZE = 16;
+
+  struct Entry {
+    Entry(std::string term, uint32_t docFrequency,
+          uint64_t collectionFrequency)
+        : term(std::move(term)), docFrequency(docFrequency),
+          collectionFrequency(collectionFrequency) {}
+
+    std::string term;
+    uint32_t docFrequency;
+    uint64_t collectionFrequency;
+  };
+
+  /**
+   * @brief Строит словарь
+   * @param sortedTerms Записи, отсортированные по термину без повторов
+   */
+  void build(const std::vector<Entry> &sortedTerms);
+
+  /**
+   * @brief Строит словарь без коллекционных частот (они полагаются равными
+   * документным)
+   * @param sortedTerms Пары (термин, документная частота), отсортированные по
+   * термину без повторов
+   */
+  void build(const std::vector<std::pair<std::string, uint32_t>> &sortedTerms);
+
+  void clear();
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  /**
+   * @brief Восстанавливает термин по идентификатору
+   */
+  std::string term(size_t id) const;
+
+  uint32_t docFrequency(size_t id) const { return m_docFreqs[id]; }
+  uint64_t collectionFrequency(size_t id) const {
+    return m_collectionFreqs[id];
+  }
+
+  /**
+   * @brief Отпечаток содержимого словаря для проверки производных структур,
+   * сохранённых на диск
+   */
+  uint64_t fingerprint() const { return m_fingerprint; }
+
+  /**
+   * @brief Ищет точное совпадение
+   * @param term Искомый термин
+   * @param id Идентификатор найденного термина
+   * @return true если термин есть в словаре
+   */
+  bool lookup(const std::string &term, size_t &id) const;
+
+  /**
+   * @brief Первый идентификатор, термин которого не меньше key
+   */
+  size_t lowerBound(const std::string &key) const;
+
+  /**
+   * @brief Диапазон идентификаторов [first, second) терминов с префиксом
+   */
+  std::pair<size_t, size_t> prefixRange(const std::string &prefix) const;
+
+  /**
+   * @brief Последовательно декодирует термины диапазона [begin, end)
+   * @param callback Вызывается как callback(id, term); возврат false
+   * прерывает обход
+   */
+  template <typename Callback>
+  void forEach(size_t begin, size_t end, Callback &&callback) const;
+
+  /**
+   * @brief Раскрывает шаблон с '*' (любая последовательность) и '?' (один
+   * символ)
+   * @param pattern Шаблон в нижнем регистре
+   * @param limit Максимальное число терминов; при превышении остаются самые
+   * частые по документной частоте
+   * @return Идентификаторы терминов в порядке словаря
+   */
+  std::vector<size_t> matchWildcard(const std::string &pattern,
+                                    size_t limit) const;
+
+  /**
+   * @brief Оставляет не более limit самых частых терминов
+   * @param ids Идентификаторы терминов
+   * @return Отобранные идентификаторы в порядке словаря
+   */
+  std::vector<size_t> mostFrequent(const std::vector<size_t> &ids,
+                                   size_t limit) const;
+
+  /**
+   * @brief Находит термины на редакционном расстоянии не больше maxEdits
+   *
+   * Обходит словарь в отсортированном порядке, пересекая его с автоматом
+   * Левенштейна: состояния общих префиксов переиспользуются, а диапазоны
+   * терминов с тупиковым префиксом пропускаются целиком.
+   *
+   * @param term Искомое слово в нижнем регистре
+   * @param maxEdits Допустимое число правок (0-2)
+   * @param limit Максимальное число терминов; предпочтение - меньшему
+   * расстоянию, затем большей документной частоте
+   * @return Пары (идентификатор, расстояние) в порядке словаря
+   */
+  std::vector<std::pair<size_t, int>>
+  matchFuzzy(const std::string &term, int maxEdits, size_t limit) const;
+
+  size_t memoryUsage() const;
+
+private:
+  size_t decodeEntry(size_t offset, std::string &term, bool first) const;
+  std::string blockFirstTerm(size_t block) const;
+
+  std::vector<uint8_t> m_data;
+  std::vector<uint32_t> m_blockOffsets;
+  std::vector<uint32_t> m_docFreqs;
+  std::vector<uint64_t> m_collectionFreqs;
+  uint64_t m_fingerprint = 0;
+  size_t m_size = 0;
+};
+
+template <typename Callback>
+void TermDictionary::forEach(size_t begin, size_t end,
+                             Callback &&callback) const {
+  if (end > m_size) {
+    end = m_size;
+  }
+  if (begin >= end) {
+    return;
+  }
+
+  size_t block = begin / BLOCK_SIZE;
+  size_t offset = m_blockOffsets[block];
+  std::string current;
+
+  for (size_t id = block * BLOCK_SIZE; id < end; ++id) {
+    offset = decodeEntry(offset, current, id % BLOCK_SIZE == 0);
+    if (id >= begin &&
+        !callback(id, static_cast<const std::string &>(current))) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Проверяет, содержит ли строка символы шаблона '*' или '?'
+ */
+bool isWildcardPattern(const std::string &term);
+
+/**
+ * @brief Сопоставляет термин с шаблоном посимвольно (по кодовым точкам UTF-8)
+ */
+bool wildcardMatch(const std::string &pattern, const std::string &term);
+
+/**
+ * @brief Проверяет, задан ли термин как нечёткий ("слово~" или "слово~N")
+ */
+bool isFuzzyTerm(const std::string &term);
+
+/**
+ * @brief Разбирает нечёткий термин
+ * @param token Термин вида "слово~" или "слово~N"
+ * @param word Слово без суффикса
+ * @return Число правок; для "слово~" выбирается по длине слова
+ */
+int parseFuzzyTerm(const std::string &token, std::string &word);
+
+/**
+ * @brief Число правок по умолчанию: 0 до 3 символов, 1 до 5, далее 2
+ */
+int autoFuzziness(const std::string &word);
+
+#endif // TERM_DICTIONARY_HPP
@@ -1,10 +1,38 @@
+#include "champion_lists.hpp"
+#include "completion_trie.hpp"
 #include "compression_utils.hpp"
+#include "doc_bitmap.hpp"
+#include "doc_reorder.hpp"
+#include "doc_values.hpp"
+#include "document_store.hpp"
+#include "facet_index.hpp"
+#include "index_merge.hpp"
+#include "index_pruning.hpp"
+#include "levenshtein_automaton.hpp"
+#include "near_duplicates.hpp"
+#include "ngram_index.hpp"
+#include "posting_accumulator.hpp"
+#include "posting_iterator.hpp"
+#include "query_parser.hpp"
+#include "query_plan.hpp"
+#include "score_kernel.hpp"
+#include "scoring_policy.hpp"
 #include "search_engine.hpp"
+#include "shard_service.hpp"
+#include "snippet_generator.hpp"
+#include "spell_index.hpp"
+#include "term_dictionary.hpp"
 #include "text_utils.hpp"
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <numeric>
+#include <random>
 #include <gtest/gtest.h>
+#include <set>
 #include <thread>
 
 namespace fs = std::filesystem;
@@ -1119,3 +1147,2441 @@ TEST_F(RealSearchTest, StressTestManyDocuments) {
   // Проверяем что индекс создан
   EXPECT_TRUE(fs::exists(testIndexDir + "/inverted_index.bin"));
 }
+
+// ============================================================================
+// Словарь терминов и префиксные запросы
+// ============================================================================
+
+TEST(TermDictionaryTest, LookupAndDecodeAcrossBlocks) {
+  std::vector<std::pair<std::string, uint32_t>> terms;
+  for (int i = 0; i < 100; ++i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "term%03d", i);
+    terms.emplace_back(buf, i + 1);
+  }
+
+  TermDictionary dict;
+  dict.build(terms);
+
+  ASSERT_EQ(dict.size(), 100);
+  for (size_t i = 0; i < terms.size(); ++i) {
+    EXPECT_EQ(dict.term(i), terms[i].first);
+
+    size_t id = 0;
+    ASSERT_TRUE(dict.lookup(terms[i].first, id));
+    EXPECT_EQ(id, i);
+    EXPECT_EQ(dict.docFrequency(id), terms[i].second);
+  }
+
+  size_t id = 0;
+  EXPECT_FALSE(dict.lookup("term1000", id));
+  EXPECT_FALSE(dict.lookup("a", id));
+  EXPECT_FALSE(dict.lookup("zzz", id));
+}
+
+TEST(TermDictionaryTest, RejectsUnsortedInput) {
+  TermDictionary dict;
+  EXPECT_THROW(dict.build({{"b", 1}, {"a", 1}}), std::invalid_argument);
+}
+
+TEST(TermDictionaryTest, PrefixAndWildcard) {
+  std::vector<std::pair<std::string, uint32_t>> terms = {
+      {"банк", 5},      {"банка", 1},     {"банкир", 2},
+      {"эконом", 1},    {"экономика", 7}, {"экономист", 3},
+      {"экономить", 2}, {"экран", 4}};
+  std::sort(terms.begin(), terms.end());
+
+  TermDictionary dict;
+  dict.build(terms);
+
+  auto range = dict.prefixRange("эконом");
+  EXPECT_EQ(range.second - range.first, 4);
+  EXPECT_EQ(dict.term(range.first), "эконом");
+
+  auto all = dict.prefixRange("");
+  EXPECT_EQ(all.first, 0);
+  EXPECT_EQ(all.second, dict.size());
+
+  auto none = dict.prefixRange("ж");
+  EXPECT_EQ(none.first, none.second);
+
+  EXPECT_EQ(dict.matchWildcard("эконом*", 100).size(), 4);
+  EXPECT_EQ(dict.matchWildcard("банк?", 100).size(), 1);
+  EXPECT_EQ(dict.matchWildcard("*ка", 100).size(), 2);
+
+  // При ограничении остаются самые частые термины
+  auto capped = dict.matchWildcard("эконом*", 2);
+  ASSERT_EQ(capped.size(), 2);
+  EXPECT_EQ(dict.term(capped[0]), "экономика");
+  EXPECT_EQ(dict.term(capped[1]), "экономист");
+}
+
+TEST(WildcardMatchTest, Patterns) {
+  EXPECT_TRUE(wildcardMatch("эконом*", "экономика"));
+  EXPECT_TRUE(wildcardMatch("э?ран", "экран"));
+  EXPECT_TRUE(wildcardMatch("*", "любое"));
+  EXPECT_FALSE(wildcardMatch("эконом?", "эконом"));
+  EXPECT_FALSE(wildcardMatch("*ист", "экономика"));
+}
+
+TEST(PostingIteratorTest, MultiwayUnionSumsFrequencies) {
+  auto a = CompressionUtils::compressPostingList({{1, 1}, {4, 2}, {9, 1}});
+  auto b = CompressionUtils::compressPostingList({{2, 3}, {4, 1}});
+  auto c = CompressionUtils::compressPostingList({{9, 5}, {12, 1}});
+
+  auto merged = unionPostingLists({&a, &b, nullptr, &c});
+
+  std::vector<std::pair<int, int>> expected = {
+      {1, 1}, {2, 3}, {4, 3}, {9, 6}, {12, 1}};
+  EXPECT_EQ(merged, expected);
+}
+
+TEST(PostingIteratorTest, AdvanceSkipsToTarget) {
+  auto data =
+      CompressionUtils::compressPostingList({{3, 1}, {7, 2}, {15, 1}});
+  PostingIterator it(&data);
+
+  EXPECT_EQ(it.advance(5), 7);
+  EXPECT_EQ(it.freq(), 2);
+  EXPECT_EQ(it.advance(7), 7);
+  EXPECT_EQ(it.next(), 15);
+  EXPECT_EQ(it.next(), PostingIterator::NO_MORE_DOCS);
+}
+
+TEST_F(RealSearchTest, PrefixQueryBoolean) {
+  createDoc("6.txt", "catalog dogma");
+  engine->indexDocuments();
+
+  auto expanded = engine->expandTermPattern("cat*");
+  ASSERT_EQ(expanded.size(), 2);
+  EXPECT_EQ(expanded[0], "cat");
+  EXPECT_EQ(expanded[1], "catalog");
+
+  // cat: 1, 2, 4; catalog: 6
+  EXPECT_EQ(engine->searchBoolean("cat*").size(), 4);
+  EXPECT_EQ(engine->searchBoolean("+cat* +dog*").size(), 3);
+  EXPECT_EQ(engine->searchBoolean("+cat* -dog*").size(), 1);
+}
+
+TEST_F(RealSearchTest, PrefixQueryExpandsEveryTerm) {
+  // Терминов с префиксом больше, чем раньше позволял лимит раскрытия (128)
+  const int terms = 200;
+  for (int i = 0; i < terms; ++i) {
+    std::string term =
+        std::string("zz") + char('a' + i / 26) + char('a' + i % 26);
+    createDoc("zz" + std::to_string(i) + ".txt", term + " cat");
+  }
+  engine->indexDocuments();
+
+  EXPECT_EQ(engine->expandTermPattern("zz*").size(), terms);
+  EXPECT_EQ(engine->searchBoolean("zz*").size(), terms);
+  EXPECT_EQ(engine->searchBoolean("*z?a").size(), 8);
+  EXPECT_EQ(engine->searchBoolean("+zz* +cat").size(), terms);
+
+  auto count = engine->countBoolean("zz*");
+  EXPECT_TRUE(count.exact);
+  EXPECT_EQ(count.count, terms);
+}
+
+TEST_F(RealSearchTest, PrefixQueryTfIdf) {
+  auto exact = engine->searchTfIdf("bird");
+  auto prefix = engine->searchTfIdf("bir*");
+
+  ASSERT_FALSE(exact.empty());
+  ASSERT_EQ(exact.size(), prefix.size());
+  for (size_t i = 0; i < exact.size(); ++i) {
+    EXPECT_EQ(exact[i].docId, prefix[i].docId);
+    EXPECT_DOUBLE_EQ(exact[i].score, prefix[i].score);
+  }
+}
+
+// ============================================================================
+// Нечёткий поиск терминов
+// ============================================================================
+
+TEST(LevenshteinAutomatonTest, AcceptsWithinDistance) {
+  LevenshteinAutomaton automaton("банк", 1);
+
+  auto run = [&automaton](const std::string &word) {
+    auto state = automaton.start();
+    for (uint32_t c : TextUtils::stringToCodes(word)) {
+      state = automaton.step(state, c);
+    }
+    return automaton.isMatch(state);
+  };
+
+  EXPECT_TRUE(run("банк"));
+  EXPECT_TRUE(run("банка"));
+  EXPECT_TRUE(run("бнк"));
+  EXPECT_TRUE(run("танк"));
+  EXPECT_FALSE(run("баки"));
+  EXPECT_FALSE(run("стол"));
+}
+
+TEST(TermDictionaryTest, FuzzyMatchMatchesBruteForce) {
+  std::vector<std::pair<std::string, uint32_t>> terms = {
+      {"банк", 9},    {"банка", 2},    {"банки", 4},   {"бант", 1},
+      {"бинт", 1},    {"танк", 3},     {"экономика", 5}, {"экономист", 2},
+      {"экнмика", 1}, {"экономики", 3}};
+  std::sort(terms.begin(), terms.end());
+
+  TermDictionary dict;
+  dict.build(terms);
+
+  auto distance = [](const std::string &a, const std::string &b) {
+    auto x = TextUtils::stringToCodes(a);
+    auto y = TextUtils::stringToCodes(b);
+    std::vector<size_t> row(y.size() + 1);
+    for (size_t j = 0; j <= y.size(); ++j) {
+      row[j] = j;
+    }
+    for (size_t i = 1; i <= x.size(); ++i) {
+      size_t diag = row[0];
+      row[0] = i;
+      for (size_t j = 1; j <= y.size(); ++j) {
+        size_t up = row[j];
+        row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                           diag + (x[i - 1] == y[j - 1] ? 0 : 1)});
+        diag = up;
+      }
+    }
+    return row[y.size()];
+  };
+
+  for (const std::string query : {"банк", "экономика", "бинк"}) {
+    for (int edits = 1; edits <= 2; ++edits) {
+      std::set<std::string> expected;
+      for (const auto &term : terms) {
+        if (distance(query, term.first) <= static_cast<size_t>(edits)) {
+          expected.insert(term.first);
+        }
+      }
+
+      std::set<std::string> actual;
+      for (const auto &match : dict.matchFuzzy(query, edits, 100)) {
+        actual.insert(dict.term(match.first));
+        EXPECT_EQ(static_cast<size_t>(match.second),
+                  distance(query, dict.term(match.first)));
+      }
+
+      EXPECT_EQ(actual, expected) << query << " ~" << edits;
+    }
+  }
+}
+
+TEST(TermDictionaryTest, FuzzyMatchRespectsLimit) {
+  TermDictionary dict;
+  dict.build({{"банк", 9}, {"банка", 2}, {"банки", 4}, {"бант", 1}});
+
+  auto capped = dict.matchFuzzy("банк", 1, 2);
+  ASSERT_EQ(capped.size(), 2);
+  EXPECT_EQ(dict.term(capped[0].first), "банк");
+  EXPECT_EQ(dict.term(capped[1].first), "банки");
+}
+
+TEST(FuzzyTermTest, ParseSyntax) {
+  std::string word;
+  EXPECT_TRUE(isFuzzyTerm("банк~"));
+  EXPECT_FALSE(isFuzzyTerm("банк"));
+  EXPECT_EQ(parseFuzzyTerm("экономика~1", word), 1);
+  EXPECT_EQ(word, "экономика");
+  EXPECT_EQ(parseFuzzyTerm("экономика~", word), 2);
+  EXPECT_EQ(parseFuzzyTerm("банк~", word), 1);
+  EXPECT_EQ(parseFuzzyTerm("ой~", word), 0);
+}
+
+TEST_F(RealSearchTest, FuzzyQueryBothModes) {
+  // Опечатка: "brd" вместо "bird"
+  EXPECT_EQ(engine->searchBoolean("brd~").size(),
+            engine->searchBoolean("bird").size());
+  EXPECT_EQ(engine->searchBoolean("+cut~1 +dog").size(), 2);
+  // Перестановка букв стоит двух правок
+  EXPECT_TRUE(engine->searchBoolean("brid~1").empty());
+
+  auto exact = engine->searchTfIdf("bird");
+  auto fuzzy = engine->searchTfIdf("bidr~2");
+  ASSERT_EQ(exact.size(), fuzzy.size());
+  EXPECT_EQ(exact[0].docId, fuzzy[0].docId);
+}
+
+TEST_F(RealSearchTest, FuzzyFallbackForUnknownTerm) {
+  // По умолчанию неизвестный термин ничего не находит
+  EXPECT_TRUE(engine->searchBoolean("+dox").empty());
+  EXPECT_TRUE(engine->searchTfIdf("brd").empty());
+
+  // С включённым режимом он раскрывается с расстоянием 1
+  engine->setFuzzyFallback(true);
+  EXPECT_EQ(engine->searchBoolean("+dox").size(),
+            engine->searchBoolean("+dog").size());
+  EXPECT_FALSE(engine->searchTfIdf("brd").empty());
+  EXPECT_TRUE(engine->searchBoolean("+zebra").empty());
+
+  // Исключаемый термин не раскрывается: "-dox" не исключает "dog"
+  EXPECT_EQ(engine->searchBoolean("cat -dox").size(),
+            engine->searchBoolean("cat").size());
+  EXPECT_EQ(engine->searchBoolean("cat AND NOT (dox OR bird)").size(),
+            engine->searchBoolean("cat AND NOT bird").size());
+}
+
+// ============================================================================
+// Подсказки "Возможно, вы имели в виду"
+// ============================================================================
+
+TEST(SpellIndexTest, SuggestsByDistanceThenFrequency) {
+  TermDictionary dict;
+  dict.build(std::vector<TermDictionary::Entry>{{"банк", 3, 40},
+                                                {"банка", 2, 5},
+                                                {"бант", 1, 90},
+                                                {"экономика", 4, 70},
+                                                {"экономист", 2, 10}});
+
+  SpellIndex index;
+  index.build(dict, 2);
+
+  // Перестановка соседних букв - одна правка
+  auto suggestions = index.suggest("бнак", dict);
+  ASSERT_FALSE(suggestions.empty());
+  EXPECT_EQ(suggestions[0].term, "банк");
+  EXPECT_EQ(suggestions[0].distance, 1);
+
+  // При равном расстоянии выигрывает более частый термин
+  suggestions = index.suggest("банн", dict);
+  ASSERT_GE(suggestions.size(), 2);
+  EXPECT_EQ(suggestions[0].term, "бант");
+  EXPECT_EQ(suggestions[1].term, "банк");
+
+  suggestions = index.suggest("экономека", dict);
+  ASSERT_FALSE(suggestions.empty());
+  EXPECT_EQ(suggestions[0].term, "экономика");
+
+  EXPECT_TRUE(index.suggest("стол", dict).empty());
+}
+
+TEST(SpellIndexTest, SaveAndMapFromDisk) {
+  std::string dir = TestHelper::getUniqueTestDir("test_spell");
+  fs::create_directories(dir);
+
+  TermDictionary dict;
+  dict.build({{"bird", 3}, {"cat", 3}, {"dog", 3}});
+
+  SpellIndex built;
+  built.build(dict, 2);
+  ASSERT_TRUE(built.save(dir + "/spell_index.bin"));
+
+  SpellIndex mapped;
+  ASSERT_TRUE(mapped.load(dir + "/spell_index.bin", dict));
+  EXPECT_EQ(mapped.entryCount(), built.entryCount());
+  ASSERT_FALSE(mapped.suggest("brid", dict).empty());
+  EXPECT_EQ(mapped.suggest("brid", dict)[0].term, "bird");
+
+  // Индекс от другого словаря не должен загружаться
+  TermDictionary other;
+  other.build({{"bird", 3}, {"cow", 1}, {"dog", 3}});
+  SpellIndex stale;
+  EXPECT_FALSE(stale.load(dir + "/spell_index.bin", other));
+
+  TestHelper::cleanupDir(dir);
+}
+
+TEST_F(RealSearchTest, DidYouMeanSuggestion) {
+  EXPECT_EQ(engine->suggestQuery("+cta -dgo bird"), "+cat -dog bird");
+  EXPECT_EQ(engine->suggestQuery("cat dog"), "");
+
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_TRUE(fs::exists(testIndexDir + "/spell_index.bin"));
+  EXPECT_EQ(reloaded->suggestQuery("brid"), "bird");
+}
+
+// ============================================================================
+// Триграммный индекс для инфиксных запросов
+// ============================================================================
+
+TEST(NgramIndexTest, InfixMatchesAgreeWithScan) {
+  std::vector<std::pair<std::string, uint32_t>> terms = {
+      {"банк", 9},     {"банкир", 2},   {"госбанк", 1},  {"сбербанк", 4},
+      {"бак", 3},      {"экономика", 5}, {"банкомат", 2}, {"обанкротиться", 1}};
+  std::sort(terms.begin(), terms.end());
+
+  TermDictionary dict;
+  dict.build(terms);
+
+  NgramIndex index;
+  index.build(dict);
+  EXPECT_FALSE(index.empty());
+
+  for (const std::string pattern :
+       {"*банк*", "*банк", "*бан?", "*ома?", "*кон*ка", "*нет*"}) {
+    std::vector<size_t> viaNgrams;
+    ASSERT_TRUE(index.matchWildcard(pattern, dict, 100, viaNgrams))
+        << pattern;
+    EXPECT_EQ(viaNgrams, dict.matchWildcard(pattern, 100)) << pattern;
+  }
+
+  std::vector<size_t> ids;
+  ASSERT_TRUE(index.matchWildcard("*банк*", dict, 100, ids));
+  EXPECT_EQ(ids.size(), 6);
+
+  // Шаблон без полной триграммы индекс сузить не может
+  std::vector<uint32_t> candidates;
+  EXPECT_FALSE(index.candidates("*ба*", candidates));
+}
+
+TEST_F(RealSearchTest, InfixQuery) {
+  createDoc("6.txt", "blackbird songbird");
+  engine->indexDocuments();
+
+  auto expanded = engine->expandTermPattern("*bird*");
+  ASSERT_EQ(expanded.size(), 3);
+  EXPECT_EQ(expanded[0], "bird");
+  EXPECT_EQ(expanded[1], "blackbird");
+  EXPECT_EQ(expanded[2], "songbird");
+
+  EXPECT_EQ(engine->searchBoolean("*bird").size(), 4);
+  EXPECT_EQ(engine->searchBoolean("+*ird -bird").size(), 1);
+}
+
+// ============================================================================
+// Автодополнение
+// ============================================================================
+
+TEST(CompletionTrieTest, TopKByWeight) {
+  std::vector<std::pair<std::string, uint64_t>> entries = {
+      {"банк", 50},     {"банка", 5},    {"банкир", 20}, {"банкомат", 35},
+      {"бант", 3},      {"экономика", 70}, {"эконом", 0}, {"экономист", 10}};
+  std::sort(entries.begin(), entries.end());
+
+  CompletionTrie trie;
+  trie.build(entries);
+
+  auto top = trie.complete("бан", 3);
+  ASSERT_EQ(top.size(), 3);
+  EXPECT_EQ(top[0].text, "банк");
+  EXPECT_EQ(top[1].text, "банкомат");
+  EXPECT_EQ(top[2].text, "банкир");
+  EXPECT_EQ(top[0].weight, 50);
+
+  // Строки с нулевым весом не предлагаются
+  auto econ = trie.complete("эконом", 10);
+  ASSERT_EQ(econ.size(), 2);
+  EXPECT_EQ(econ[0].text, "экономика");
+  EXPECT_EQ(econ[1].text, "экономист");
+
+  EXPECT_EQ(trie.complete("", 1)[0].text, "экономика");
+  EXPECT_TRUE(trie.complete("ж", 5).empty());
+}
+
+TEST(CompletionTrieTest, MatchesExhaustiveRanking) {
+  std::vector<std::pair<std::string, uint64_t>> entries;
+  for (int i = 0; i < 300; ++i) {
+    entries.emplace_back("w" + std::to_string(i), (i * 7919) % 101 + 1);
+  }
+  std::sort(entries.begin(), entries.end());
+
+  CompletionTrie trie;
+  trie.build(entries);
+
+  std::vector<uint64_t> expected;
+  for (const auto &entry : entries) {
+    if (entry.first.compare(0, 2, "w1") == 0) {
+      expected.push_back(entry.second);
+    }
+  }
+  std::sort(expected.rbegin(), expected.rend());
+  expected.resize(10);
+
+  auto top = trie.complete("w1", 10);
+  ASSERT_EQ(top.size(), 10);
+  for (size_t i = 0; i < top.size(); ++i) {
+    EXPECT_EQ(top[i].weight, expected[i]);
+  }
+}
+
+TEST_F(RealSearchTest, AutocompleteByCollectionFrequency) {
+  createDoc("6.txt", "birch birch birch birch birch birch bin");
+  engine->indexDocuments();
+
+  auto completions = engine->autocomplete("Bi", 2);
+  ASSERT_EQ(completions.size(), 2);
+  EXPECT_EQ(completions[0].text, "birch");
+  EXPECT_EQ(completions[0].weight, 6);
+  EXPECT_EQ(completions[1].text, "bird");
+  EXPECT_EQ(completions[1].weight, 5);
+}
+
+// ============================================================================
+// Тесты LZ-сжатия и хранилища документов
+// ============================================================================
+
+TEST(LzCompressionTest, RoundTrip) {
+  std::string text;
+  for (int i = 0; i < 200; ++i) {
+    text += "поисковая система индексирует документ " + std::to_string(i) +
+            "\n";
+  }
+
+  const auto *raw = reinterpret_cast<const uint8_t *>(text.data());
+  auto compressed = CompressionUtils::lzCompress(raw, text.size());
+  EXPECT_LT(compressed.size(), text.size() / 3);
+
+  auto restored = CompressionUtils::lzDecompress(
+      compressed.data(), compressed.size(), text.size());
+  EXPECT_EQ(std::string(restored.begin(), restored.end()), text);
+
+  // Короткие и несжимаемые входы
+  for (const std::string &small : {std::string(), std::string("abc"),
+                                   std::string("abcdefghijklmnop")}) {
+    auto packed = CompressionUtils::lzCompress(
+        reinterpret_cast<const uint8_t *>(small.data()), small.size());
+    auto unpacked = CompressionUtils::lzDecompress(packed.data(),
+                                                   packed.size(), small.size());
+    EXPECT_EQ(std::string(unpacked.begin(), unpacked.end()), small);
+  }
+}
+
+TEST(LzCompressionTest, RejectsCorruptedInput) {
+  std::string text(1000, 'a');
+  auto compressed = CompressionUtils::lzCompress(
+      reinterpret_cast<const uint8_t *>(text.data()), text.size());
+
+  EXPECT_THROW(CompressionUtils::lzDecompress(compressed.data(),
+                                              compressed.size() - 1,
+                                              text.size()),
+               std::runtime_error);
+  EXPECT_THROW(CompressionUtils::lzDecompress(
+                   compressed.data(), compressed.size(), text.size() + 1),
+               std::runtime_error);
+}
+
+TEST(DocumentStoreTest, AddGetSaveLoad) {
+  DocumentStore store(64);
+  std::vector<std::string> texts;
+  for (int id = 1; id <= 20; ++id) {
+    if (id == 7) {
+      continue; // пропуск в нумерации
+    }
+    texts.push_back("документ номер " + std::to_string(id) + " текст текст");
+    store.add(id, texts.back());
+  }
+  store.finish();
+
+  EXPECT_EQ(store.documentCount(), 19);
+  EXPECT_GT(store.blockCount(), 1);
+  EXPECT_FALSE(store.contains(7));
+  EXPECT_EQ(store.get(7), "");
+  EXPECT_EQ(store.get(3), "документ номер 3 текст текст");
+  EXPECT_EQ(store.get(20), "документ номер 20 текст текст");
+
+  std::string path =
+      (fs::temp_directory_path() / "search_engine_doc_store_test.bin").string();
+  ASSERT_TRUE(store.save(path));
+
+  DocumentStore loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.documentCount(), 19);
+  EXPECT_EQ(loaded.rawSize(), store.rawSize());
+  EXPECT_EQ(loaded.get(20), "документ номер 20 текст текст");
+  EXPECT_EQ(loaded.get(1), "документ номер 1 текст текст");
+  EXPECT_FALSE(loaded.contains(100));
+
+  // Файл, записанный для другого индекса, не загружается
+  ASSERT_TRUE(store.save(path, 42));
+  EXPECT_FALSE(loaded.load(path, 43));
+  ASSERT_TRUE(loaded.load(path, 42));
+  EXPECT_EQ(loaded.get(3), "документ номер 3 текст текст");
+
+  EXPECT_THROW(store.add(5, "назад"), std::invalid_argument);
+  fs::remove(path);
+}
+
+TEST(DocumentStoreTest, ConcurrentGet) {
+  DocumentStore store(32);
+  for (int id = 1; id <= 200; ++id) {
+    store.add(id, "текст " + std::to_string(id));
+  }
+  store.finish();
+
+  // Потоки читают разные блоки и вытесняют друг у друга кеш
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&store, &mismatches, t]() {
+      for (int round = 0; round < 50; ++round) {
+        for (int id = 1 + t; id <= 200; id += 4) {
+          if (store.get(id) != "текст " + std::to_string(id)) {
+            mismatches++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(DocumentStoreTest, RenumberKeepsDiskFile) {
+  DocumentStore store(16);
+  for (int id = 1; id <= 4; ++id) {
+    store.add(id, "текст " + std::to_string(id));
+  }
+  std::string path =
+      (fs::temp_directory_path() / "search_engine_renumber_test.bin").string();
+  ASSERT_TRUE(store.save(path));
+  ASSERT_TRUE(store.load(path));
+
+  // Новый docId 1 — прежний 3 и т.д.; файл на диске не меняется
+  store.renumber({3, 1, 4, 2});
+  EXPECT_EQ(store.get(1), "текст 3");
+  EXPECT_EQ(store.get(4), "текст 2");
+  EXPECT_EQ(store.documentCount(), 4);
+
+  DocumentStore onDisk;
+  ASSERT_TRUE(onDisk.load(path));
+  EXPECT_EQ(onDisk.get(1), "текст 1");
+
+  ASSERT_TRUE(store.save(path));
+  ASSERT_TRUE(onDisk.load(path));
+  EXPECT_EQ(onDisk.get(1), "текст 3");
+  fs::remove(path);
+}
+
+TEST_F(RealSearchTest, DocumentTextFromStore) {
+  EXPECT_TRUE(fs::exists(testIndexDir + "/doc_store.bin"));
+
+  SearchEngine reloaded(testDataDir, testIndexDir + "/lemmas.txt",
+                        testIndexDir);
+  ASSERT_TRUE(reloaded.loadIndex());
+
+  // Исходные файлы больше не нужны для доступа к тексту; docId назначаются
+  // в порядке обхода каталога, поэтому сверяем множество текстов
+  fs::remove_all(testDataDir);
+  std::multiset<std::string> texts;
+  for (int docId = 1; docId <= 5; ++docId) {
+    texts.insert(reloaded.documentText(docId));
+  }
+  std::multiset<std::string> expected = {"cat dog", "cat cat dog", "dog bird",
+                                         "cat bird", "bird bird bird"};
+  EXPECT_EQ(texts, expected);
+  EXPECT_EQ(reloaded.searchBoolean("+cat +dog").size(), 2);
+
+  // Хранилище от другого индекса не подменяет тексты
+  DocumentStore stale;
+  stale.add(1, "чужой текст");
+  ASSERT_TRUE(stale.save(testIndexDir + "/doc_store.bin"));
+  SearchEngine restarted(testDataDir, testIndexDir + "/lemmas.txt",
+                         testIndexDir);
+  ASSERT_TRUE(restarted.loadIndex());
+  EXPECT_EQ(restarted.documentText(1), "");
+}
+
+// ============================================================================
+// Тесты фрагментов с подсветкой
+// ============================================================================
+
+TEST(WordSpansTest, MatchesTokenize) {
+  std::string text = "Привет, МИР! hello-world 42 ёлка\nконец";
+  auto tokens = TextUtils::tokenize(text);
+  auto spans = TextUtils::wordSpans(text);
+
+  ASSERT_EQ(spans.size(), tokens.size());
+  for (size_t i = 0; i < spans.size(); ++i) {
+    EXPECT_EQ(spans[i].hash, TextUtils::wordHash(tokens[i]));
+    EXPECT_EQ(TextUtils::toLowerCase(text.substr(
+                  spans[i].begin, spans[i].end - spans[i].begin)),
+              tokens[i]);
+  }
+}
+
+TEST(SnippetGeneratorTest, PicksWindowWithAllTerms) {
+  std::string text;
+  for (int i = 0; i < 50; ++i) {
+    text += "слово" + std::to_string(i) + " ";
+  }
+  text += "Кот ловит мышь.\nПотом кот спит. ";
+  for (int i = 50; i < 100; ++i) {
+    text += "слово" + std::to_string(i) + " ";
+  }
+  text = "кот " + text;
+
+  SnippetGenerator generator(10);
+  auto snippet = generator.generate(text, {"кот", "мышь"});
+
+  EXPECT_EQ(snippet.distinctTerms, 2);
+  EXPECT_EQ(snippet.matchCount, 3);
+  EXPECT_NE(snippet.text.find("[Кот] ловит [мышь]. Потом [кот] спит"),
+            std::string::npos);
+  EXPECT_EQ(snippet.text.rfind("... ", 0), 0);
+  EXPECT_EQ(snippet.text.substr(snippet.text.size() - 4), " ...");
+}
+
+TEST(SnippetGeneratorTest, NoMatchesShowsBeginning) {
+  SnippetGenerator generator(3, "<b>", "</b>");
+
+  auto snippet = generator.generate("one two three four", {"five"});
+  EXPECT_EQ(snippet.text, "one two three ...");
+  EXPECT_EQ(snippet.matchCount, 0);
+
+  EXPECT_EQ(generator.generate("", {"one"}).text, "");
+  EXPECT_EQ(generator.generate("one two", {"two"}).text, "one <b>two</b>");
+}
+
+TEST(SnippetGeneratorTest, StopsReadingLongText) {
+  std::string tail;
+  for (int i = 0; i < 200000; ++i) {
+    tail += "слово ";
+  }
+
+  // Все термины найдены в начале: хвост в несколько мегабайт не читается,
+  // а окно дочитывается до нужной длины
+  SnippetGenerator generator(5);
+  auto snippet = generator.generate("кот ловит мышь " + tail, {"кот", "мышь"});
+  EXPECT_EQ(snippet.distinctTerms, 2);
+  EXPECT_EQ(snippet.text, "[кот] ловит [мышь] слово слово ...");
+
+  // Термин за пределом просмотра не ищется: показывается начало текста
+  SnippetGenerator limited(3, "[", "]", 1024);
+  auto far = limited.generate(tail + "кот", {"кот"});
+  EXPECT_EQ(far.matchCount, 0);
+  EXPECT_EQ(far.text, "слово слово слово ...");
+}
+
+TEST_F(RealSearchTest, SnippetHighlightsExpandedTerms) {
+  int docId = 1;
+  while (engine->documentText(docId).find("dog") == std::string::npos) {
+    ASSERT_LT(++docId, 5);
+  }
+
+  std::string snippet = engine->snippet(docId, "+do* -cat");
+  EXPECT_NE(snippet.find("\033[1mdog\033[0m"), std::string::npos);
+  EXPECT_EQ(snippet.find("\033[1mcat"), std::string::npos);
+}
+
+// ============================================================================
+// Тесты парсера булевых запросов и плана выполнения
+// ============================================================================
+
+namespace {
+
+size_t lengthAsFrequency(const std::string &term) { return term.size(); }
+
+std::string rewritten(const std::string &query) {
+  return QueryParser::rewrite(QueryParser::parse(query), lengthAsFrequency)
+      .toString();
+}
+
+} // namespace
+
+TEST(QueryParserTest, LegacySyntax) {
+  EXPECT_EQ(QueryParser::parse("cat dog").toString(), "(OR cat dog)");
+  EXPECT_EQ(QueryParser::parse("+cat +dog bird").toString(), "(AND cat dog)");
+  EXPECT_EQ(QueryParser::parse("cat dog -bird").toString(),
+            "(AND (OR cat dog) (NOT bird))");
+  EXPECT_EQ(QueryParser::parse("Кот").toString(), "кот");
+  EXPECT_TRUE(QueryParser::parse("").isEmpty());
+}
+
+TEST(QueryParserTest, OperatorsAndParentheses) {
+  EXPECT_EQ(QueryParser::parse("(a OR b) AND NOT c").toString(),
+            "(AND (OR a b) (AND (NOT c)))");
+  EXPECT_EQ(QueryParser::parse("a || b && !c").toString(),
+            "(OR a (AND b (AND (NOT c))))");
+  EXPECT_EQ(QueryParser::parse("-(a OR b) +c").toString(),
+            "(AND c (NOT (OR a b)))");
+
+  // Операторы пишутся заглавными, иначе это обычные слова
+  EXPECT_EQ(QueryParser::parse("cats and dogs").toString(),
+            "(OR cats and dogs)");
+
+  EXPECT_THROW(QueryParser::parse("(a OR b"), std::invalid_argument);
+  EXPECT_THROW(QueryParser::parse("a OR"), std::invalid_argument);
+  EXPECT_THROW(QueryParser::parse("a)"), std::invalid_argument);
+  EXPECT_THROW(QueryParser::parse("()"), std::invalid_argument);
+}
+
+TEST(QueryParserTest, RewriteFlattensAndOrders) {
+  // Вложенные AND/OR сливаются, повторы убираются, дети — по частоте
+  EXPECT_EQ(rewritten("(ccc AND (a AND bb)) AND a"), "(AND a bb ccc)");
+  EXPECT_EQ(rewritten("ccc OR (a OR ccc)"), "(OR a ccc)");
+  EXPECT_EQ(rewritten("(x)"), "x");
+
+  // NOT проталкивается через OR и двойное отрицание
+  EXPECT_EQ(rewritten("dddd AND NOT (a OR bb)"),
+            "(AND dddd (NOT a) (NOT bb))");
+  EXPECT_EQ(rewritten("a AND NOT NOT bb"), "(AND a bb)");
+  EXPECT_EQ(rewritten("a AND NOT (bb AND ccc)"),
+            "(AND a (NOT (AND bb ccc)))");
+
+  // Заведомо пустые ветви
+  EXPECT_TRUE(QueryParser::rewrite(QueryParser::parse("a AND NOT a"),
+                                   lengthAsFrequency)
+                  .isEmpty());
+  EXPECT_EQ(rewritten("a OR NOT b"), "a");
+}
+
+TEST(QueryPlanTest, ExecutesTree) {
+  auto encode = [](const std::vector<int> &docs) {
+    std::vector<std::pair<int, int>> postings;
+    for (int doc : docs) {
+      postings.emplace_back(doc, 1);
+    }
+    return CompressionUtils::compressPostingList(postings);
+  };
+
+  std::map<std::string, std::vector<uint8_t>> lists = {
+      {"a", encode({1, 2, 3, 5, 8, 13})},
+      {"b", encode({2, 3, 4, 8, 9})},
+      {"c", encode({3, 9, 13})},
+      {"d", encode({1, 4})}};
+
+  PostingLookup lookup = [&](const std::string &term) {
+    auto it = lists.find(term);
+    return std::vector<const std::vector<uint8_t> *>{
+        it == lists.end() ? nullptr : &it->second};
+  };
+
+  auto run = [&](const std::string &query) {
+    auto plan = QueryParser::rewrite(QueryParser::parse(query),
+                                     lengthAsFrequency);
+    auto iterator = QueryPlan::compile(plan, lookup);
+    return QueryPlan::collect(*iterator);
+  };
+
+  EXPECT_EQ(run("a AND b"), (std::vector<int>{2, 3, 8}));
+  EXPECT_EQ(run("(a OR b) AND NOT c"), (std::vector<int>{1, 2, 4, 5, 8}));
+  EXPECT_EQ(run("(c OR d) AND (a OR b)"), (std::vector<int>{1, 3, 4, 9, 13}));
+  EXPECT_EQ(run("a AND NOT (b AND c)"), (std::vector<int>{1, 2, 5, 8, 13}));
+  EXPECT_EQ(run("+a +b -c"), (std::vector<int>{2, 8}));
+  EXPECT_EQ(run("d zzz"), (std::vector<int>{1, 4}));
+  EXPECT_TRUE(run("a AND zzz").empty());
+  EXPECT_TRUE(run("NOT a").empty());
+}
+
+TEST_F(RealSearchTest, BooleanOperators) {
+  // cat: 1,2,4; dog: 1,2,3; bird: 3,4,5 (по содержимому документов)
+  EXPECT_EQ(engine->searchBoolean("(cat OR dog) AND NOT bird").size(), 2);
+  EXPECT_EQ(engine->searchBoolean("cat AND (dog OR bird)").size(), 3);
+  EXPECT_EQ(engine->searchBoolean("bird AND NOT (cat OR dog)").size(), 1);
+  EXPECT_EQ(engine->searchBoolean("(ca* OR brd~) -dog").size(), 2);
+  EXPECT_EQ(engine->searchBoolean("+cat +dog").size(),
+            engine->searchBoolean("cat AND dog").size());
+  EXPECT_THROW(engine->searchBoolean("(cat OR dog"), std::invalid_argument);
+
+  EXPECT_EQ(engine->suggestQuery("(cst OR dog) AND NOT brd"),
+            "(cat OR dog) AND NOT bird");
+}
+
+// ============================================================================
+// Тесты булева фильтра с ранжированием
+// ============================================================================
+
+TEST_F(RealSearchTest, BooleanRankedMatchesTfIdf) {
+  auto ranked = engine->searchBooleanRanked("cat dog", 10);
+  auto tfidf = engine->searchTfIdf("cat dog");
+
+  ASSERT_EQ(ranked.size(), tfidf.size());
+  for (size_t i = 0; i < ranked.size(); ++i) {
+    EXPECT_NEAR(ranked[i].score, tfidf[i].score, 1e-12);
+  }
+
+  auto top1 = engine->searchBooleanRanked("cat dog", 1);
+  ASSERT_EQ(top1.size(), 1);
+  EXPECT_EQ(top1[0].docId, ranked[0].docId);
+}
+
+TEST_F(RealSearchTest, BooleanRankedAppliesFilter) {
+  // +cat -bird оставляет "cat dog" и "cat cat dog"; у второго tf выше
+  auto results = engine->searchBooleanRanked("+cat -bird", 10);
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_EQ(engine->documentText(results[0].docId), "cat cat dog");
+  EXPECT_EQ(engine->documentText(results[1].docId), "cat dog");
+  EXPECT_GT(results[0].score, results[1].score);
+
+  EXPECT_TRUE(engine->searchBooleanRanked("+cat +zebra", 10).empty());
+  EXPECT_EQ(engine->searchBooleanRanked("(cat OR dog) AND NOT bird", 10)
+                .size(),
+            2);
+  EXPECT_THROW(engine->searchBooleanRanked("cat AND", 10),
+               std::invalid_argument);
+}
+
+// ============================================================================
+// Тесты битовых множеств и подсчёта результатов
+// ============================================================================
+
+TEST(DocBitmapTest, MatchesStdSet) {
+  std::mt19937 rng(7);
+  // Разреженное и плотное множества в нескольких фрагментах по 65536
+  std::set<uint32_t> sparse, dense;
+  DocBitmap a, b;
+  for (int i = 0; i < 3000; ++i) {
+    uint32_t doc = rng() % 200000;
+    sparse.insert(doc);
+    a.add(doc);
+  }
+  for (int i = 0; i < 60000; ++i) {
+    uint32_t doc = rng() % 140000;
+    dense.insert(doc);
+    b.add(doc);
+  }
+
+  EXPECT_EQ(a.cardinality(), sparse.size());
+  EXPECT_EQ(b.cardinality(), dense.size());
+  EXPECT_EQ(a.toVector(), std::vector<uint32_t>(sparse.begin(), sparse.end()));
+
+  std::vector<uint32_t> expected;
+  std::set_intersection(sparse.begin(), sparse.end(), dense.begin(),
+                        dense.end(), std::back_inserter(expected));
+  EXPECT_EQ((a & b).toVector(), expected);
+  EXPECT_EQ(a.andCardinality(b), expected.size());
+  EXPECT_EQ(b.andCardinality(b), dense.size());
+
+  expected.clear();
+  std::set_union(sparse.begin(), sparse.end(), dense.begin(), dense.end(),
+                 std::back_inserter(expected));
+  EXPECT_EQ((a | b).toVector(), expected);
+
+  expected.clear();
+  std::set_difference(dense.begin(), dense.end(), sparse.begin(),
+                      sparse.end(), std::back_inserter(expected));
+  EXPECT_EQ(b.andNot(a).toVector(), expected);
+
+  EXPECT_TRUE(b.contains(*dense.begin()));
+  EXPECT_FALSE(a.contains(300000));
+}
+
+TEST(DocBitmapTest, FromPostings) {
+  std::vector<std::pair<int, int>> postings = {{1, 2}, {5, 1}, {70000, 3}};
+  auto bitmap =
+      DocBitmap::fromPostings(CompressionUtils::compressPostingList(postings));
+  EXPECT_EQ(bitmap.toVector(), (std::vector<uint32_t>{1, 5, 70000}));
+}
+
+TEST(UnionEstimateTest, WithinErrorBound) {
+  // Три сильно пересекающихся списка: объединение = 0..29999
+  std::vector<std::vector<uint8_t>> encoded;
+  for (int shift : {0, 10000, 20000}) {
+    std::vector<std::pair<int, int>> postings;
+    for (int doc = shift + 1; doc <= shift + 10000; ++doc) {
+      postings.emplace_back(doc, 1);
+    }
+    for (int doc = 1; doc <= 5000; ++doc) {
+      if (doc <= shift) {
+        postings.emplace_back(doc, 1);
+      }
+    }
+    std::sort(postings.begin(), postings.end());
+    encoded.push_back(CompressionUtils::compressPostingList(postings));
+  }
+
+  std::vector<const std::vector<uint8_t> *> lists;
+  for (const auto &list : encoded) {
+    lists.push_back(&list);
+  }
+
+  UnionEstimate estimate = estimateUnionSize(lists, 4000, 42);
+  EXPECT_GT(estimate.errorBound, 0.0);
+  EXPECT_NEAR(estimate.size, 30000.0, 2 * estimate.errorBound);
+  EXPECT_LT(estimate.errorBound, 30000.0 * 0.05);
+
+  // Непересекающиеся списки: оценка точна
+  UnionEstimate single = estimateUnionSize({lists[0]}, 100, 1);
+  EXPECT_DOUBLE_EQ(single.size, 10000.0);
+  EXPECT_DOUBLE_EQ(single.errorBound, 0.0);
+}
+
+TEST_F(RealSearchTest, CountMatchesSearch) {
+  for (const std::string query :
+       {"cat", "cat dog", "+cat +dog", "+cat -bird", "(cat OR dog) AND NOT bird",
+        "ca* OR bi*", "cat AND (dog OR bird)", "zebra", "*ird", "-cat"}) {
+    auto count = engine->countBoolean(query);
+    EXPECT_TRUE(count.exact) << query;
+    EXPECT_EQ(count.count, engine->searchBoolean(query).size()) << query;
+  }
+
+  EXPECT_EQ(engine->searchBoolean("bird OR cat", 2).size(), 2);
+}
+
+// ============================================================================
+// Тесты постраничной выдачи
+// ============================================================================
+
+TEST_F(RealSearchTest, BooleanPagesConcatenate) {
+  auto all = engine->searchBoolean("cat OR bird");
+  ASSERT_EQ(all.size(), 5);
+
+  std::vector<int> paged;
+  int cursor = 0;
+  bool hasMore = true;
+  size_t pages = 0;
+  while (hasMore) {
+    auto page = engine->searchBooleanPage("cat OR bird", cursor, 2);
+    EXPECT_LE(page.docIds.size(), 2);
+    paged.insert(paged.end(), page.docIds.begin(), page.docIds.end());
+    cursor = page.next;
+    hasMore = page.hasMore;
+    pages++;
+  }
+
+  EXPECT_EQ(paged, all);
+  EXPECT_EQ(pages, 3);
+  EXPECT_TRUE(engine->searchBooleanPage("cat OR bird", cursor, 2)
+                  .docIds.empty());
+}
+
+TEST_F(RealSearchTest, RankedPagesConcatenate) {
+  createDoc("6.txt", "cat bird dog bird");
+  createDoc("7.txt", "dog dog cat");
+  engine->indexDocuments();
+
+  auto full = engine->searchTfIdfPage("cat dog bird",
+                                      SearchEngine::RankCursor(), 100);
+  EXPECT_FALSE(full.hasMore);
+  ASSERT_GE(full.results.size(), 5);
+
+  std::vector<SearchEngine::ScoredDocument> paged;
+  SearchEngine::RankCursor cursor;
+  bool hasMore = true;
+  while (hasMore) {
+    auto page = engine->searchTfIdfPage("cat dog bird", cursor, 2);
+    paged.insert(paged.end(), page.results.begin(), page.results.end());
+    cursor = page.next;
+    hasMore = page.hasMore;
+  }
+
+  ASSERT_EQ(paged.size(), full.results.size());
+  for (size_t i = 0; i < paged.size(); ++i) {
+    EXPECT_EQ(paged[i].docId, full.results[i].docId);
+    EXPECT_DOUBLE_EQ(paged[i].score, full.results[i].score);
+    if (i > 0) {
+      EXPECT_GE(paged[i - 1].score, paged[i].score);
+    }
+  }
+
+  // Ранжированный булев режим с тем же курсором
+  auto first =
+      engine->searchBooleanRankedPage("+cat", SearchEngine::RankCursor(), 1);
+  ASSERT_EQ(first.results.size(), 1);
+  EXPECT_TRUE(first.hasMore);
+  auto second = engine->searchBooleanRankedPage("+cat", first.next, 10);
+  EXPECT_EQ(second.results.size() + 1, engine->searchBoolean("+cat").size());
+  for (const auto &doc : second.results) {
+    EXPECT_NE(doc.docId, first.results[0].docId);
+  }
+}
+
+// ============================================================================
+// Тесты фасетов по хостам
+// ============================================================================
+
+TEST(FacetIndexTest, ExtractHost) {
+  EXPECT_EQ(extractHost("https://www.Lenta.ru/news/1"), "lenta.ru");
+  EXPECT_EQ(extractHost("http://user@ria.ru:8080?q=1"), "ria.ru:8080");
+  EXPECT_EQ(extractHost("tass.ru/path"), "tass.ru");
+}
+
+TEST(FacetIndexTest, CountsByIntersection) {
+  FacetIndex facets;
+  for (int doc = 1; doc <= 100; ++doc) {
+    facets.add(doc, doc % 3 == 0 ? "a.ru" : "b.ru");
+  }
+
+  DocBitmap results;
+  for (uint32_t doc = 1; doc <= 30; ++doc) {
+    results.add(doc);
+  }
+
+  auto counts = facets.counts(results, 10);
+  ASSERT_EQ(counts.size(), 2);
+  EXPECT_EQ(counts[0].value, "b.ru");
+  EXPECT_EQ(counts[0].count, 20);
+  EXPECT_EQ(counts[1].value, "a.ru");
+  EXPECT_EQ(counts[1].count, 10);
+  EXPECT_EQ(facets.counts(results, 1).size(), 1);
+  EXPECT_EQ(facets.documents("a.ru")->cardinality(), 33);
+  EXPECT_EQ(facets.documents("c.ru"), nullptr);
+}
+
+TEST(QueryParserTest, SiteFilter) {
+  EXPECT_EQ(QueryParser::parse("cat site:WWW.Lenta.ru").toString(),
+            "(AND cat site:lenta.ru)");
+  EXPECT_EQ(QueryParser::parse("cat -site:a.ru").toString(),
+            "(AND cat (NOT site:a.ru))");
+  EXPECT_EQ(QueryParser::parse("site:a.ru OR site:b.ru").toString(),
+            "(OR site:a.ru site:b.ru)");
+  EXPECT_TRUE(QueryParser::positiveTerms(QueryParser::parse("cat site:a.ru"))
+                  .size() == 1);
+}
+
+TEST_F(RealSearchTest, HostFacetsAndSiteFilter) {
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  urls << "1\thttp://a.com/1\n2\thttps://www.a.com/2\n3\thttp://b.org/3\n";
+  urls << "4\thttp://c.net/4\n5\thttp://c.net/5\n";
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->indexDocuments();
+
+  // cat: 1,2,4; bird: 3,4,5 (номера файлов)
+  EXPECT_EQ(engine->searchBoolean("cat site:a.com").size(), 2);
+  EXPECT_EQ(engine->searchBoolean("bird -site:c.net").size(), 1);
+  EXPECT_EQ(engine->searchBoolean("site:B.org").size(), 1);
+  EXPECT_EQ(engine->searchBoolean("(site:a.com OR site:b.org) dog").size(), 3);
+  EXPECT_TRUE(engine->searchBoolean("cat site:unknown.ru").empty());
+  EXPECT_EQ(engine->countBoolean("cat site:a.com").count, 2);
+
+  auto facets = engine->hostFacets("cat", 10);
+  ASSERT_EQ(facets.size(), 2);
+  EXPECT_EQ(facets[0].value, "a.com");
+  EXPECT_EQ(facets[0].count, 2);
+  EXPECT_EQ(facets[1].value, "c.net");
+  EXPECT_EQ(facets[1].count, 1);
+
+  auto ranked = engine->searchBooleanRanked("cat site:c.net", 10);
+  ASSERT_EQ(ranked.size(), 1);
+  EXPECT_EQ(engine->documentText(ranked[0].docId), "cat bird");
+}
+
+// ============================================================================
+// Тесты числовых столбцов (docvalues)
+// ============================================================================
+
+TEST(DocValuesTest, PackedValuesAndRanges) {
+  DocValuesColumn column;
+  std::vector<std::pair<int, int64_t>> expected;
+  std::mt19937 rng(7);
+  for (int doc = 1; doc < 1000; doc += 1 + rng() % 3) {
+    int64_t value = 1700000000 + doc * 60 + rng() % 50;
+    column.add(doc, value);
+    expected.emplace_back(doc, value);
+  }
+  column.add(5000, -42);
+  expected.emplace_back(5000, -42);
+  column.finish();
+
+  EXPECT_EQ(column.valueCount(), expected.size());
+  EXPECT_EQ(column.blockCount(), 5000 / DocValuesColumn::BLOCK_SIZE + 1);
+
+  int64_t value = 0;
+  for (const auto &entry : expected) {
+    ASSERT_TRUE(column.get(entry.first, value));
+    EXPECT_EQ(value, entry.second);
+  }
+  EXPECT_FALSE(column.get(0, value));
+  EXPECT_FALSE(column.get(4000, value));
+  EXPECT_FALSE(column.get(100000, value));
+
+  int64_t min = 1700000000 + 300 * 60;
+  int64_t max = 1700000000 + 600 * 60;
+  std::vector<int> brute;
+  for (const auto &entry : expected) {
+    if (entry.second >= min && entry.second <= max) {
+      brute.push_back(entry.first);
+    }
+  }
+
+  auto iterator = column.range(min, max);
+  EXPECT_EQ(QueryPlan::collect(*iterator), brute);
+  EXPECT_EQ(column.rangeBitmap(min, max).toVector(),
+            std::vector<uint32_t>(brute.begin(), brute.end()));
+  EXPECT_GE(column.estimateRange(min, max), brute.size());
+  EXPECT_EQ(QueryPlan::collect(*column.range(-100, 0)),
+            std::vector<int>{5000});
+
+  // advance перескакивает через блоки вне диапазона
+  auto skipping = column.range(min, max);
+  EXPECT_EQ(skipping->advance(brute[brute.size() / 2]),
+            brute[brute.size() / 2]);
+}
+
+TEST(DocValuesTest, SaveAndLoad) {
+  DocValues values;
+  values.column("download_timestamp").add(3, 100);
+  values.column("download_timestamp").add(300, 200);
+  values.column("size").add(1, 7);
+  values.finish();
+
+  std::string path = "test_doc_values.bin";
+  ASSERT_TRUE(values.save(path));
+
+  DocValues loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.fields(),
+            (std::vector<std::string>{"download_timestamp", "size"}));
+
+  int64_t value = 0;
+  ASSERT_NE(loaded.find("download_timestamp"), nullptr);
+  EXPECT_TRUE(loaded.find("download_timestamp")->get(300, value));
+  EXPECT_EQ(value, 200);
+  EXPECT_EQ(loaded.find("missing"), nullptr);
+  fs::remove(path);
+}
+
+TEST(DocValuesTest, ParseRangeFilter) {
+  int64_t min = 0;
+  int64_t max = 0;
+  int64_t now = 1700000000;
+
+  ASSERT_TRUE(parseRangeFilter("10..20", now, min, max));
+  EXPECT_EQ(min, 10);
+  EXPECT_EQ(max, 20);
+
+  ASSERT_TRUE(parseRangeFilter("7d..", now, min, max));
+  EXPECT_EQ(min, now - 7 * 86400);
+  EXPECT_EQ(max, std::numeric_limits<int64_t>::max());
+
+  ASSERT_TRUE(parseRangeFilter("2024-01-01..2024-01-01", now, min, max));
+  EXPECT_EQ(min, 1704067200);
+  EXPECT_EQ(max, 1704067200 + 86399);
+
+  EXPECT_FALSE(parseRangeFilter("10", now, min, max));
+  EXPECT_FALSE(parseRangeFilter("abc..", now, min, max));
+}
+
+TEST(QueryParserTest, RangeFilter) {
+  EXPECT_EQ(QueryParser::parse("cat download_timestamp:7d..").toString(),
+            "(AND cat download_timestamp:7d..)");
+  EXPECT_EQ(QueryParser::parse("ratio:1..2 -size:..10").toString(),
+            "(AND ratio:1..2 (NOT size:..10))");
+  EXPECT_EQ(QueryParser::parse("http://a.ru").toString(), "http");
+}
+
+TEST_F(RealSearchTest, RangeFilterFromRegistry) {
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  for (int id = 1; id <= 5; ++id) {
+    urls << id << "\thttp://example.com/doc" << id
+         << "\tdownload_timestamp=" << 1000 * id << "\tbroken=x\n";
+  }
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->indexDocuments();
+
+  // cat: 1,2,4 (номера файлов)
+  EXPECT_EQ(engine->searchBoolean("cat download_timestamp:1500..").size(), 2);
+  EXPECT_EQ(engine->searchBoolean("download_timestamp:..3000").size(), 3);
+  EXPECT_TRUE(engine->searchBoolean("cat broken:1..").empty());
+  EXPECT_EQ(engine->countBoolean("bird download_timestamp:3000..4000").count,
+            2);
+
+  auto ranked =
+      engine->searchBooleanRanked("cat download_timestamp:4000..4000", 10);
+  ASSERT_EQ(ranked.size(), 1);
+  EXPECT_EQ(engine->documentText(ranked[0].docId), "cat bird");
+
+  // Столбцы читаются из индекса, а не из реестра
+  ASSERT_TRUE(engine->saveIndex());
+  createUrlsFile();
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_EQ(reloaded->searchBoolean("download_timestamp:2000..4000").size(),
+            3);
+}
+
+// ============================================================================
+// Тесты порядка docId по априорной оценке
+// ============================================================================
+
+TEST_F(RealSearchTest, RecencyOrderedDocIds) {
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  for (int id = 1; id <= 5; ++id) {
+    urls << id << "\thttp://example.com/doc" << id
+         << "\tdownload_timestamp=" << 1000 * id << "\n";
+  }
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDocOrder(SearchEngine::DocOrder::Recency, 2.0);
+  engine->indexDocuments();
+
+  // Самый свежий документ (5.txt) получает docId 1
+  EXPECT_EQ(engine->documentText(1), "bird bird bird");
+  EXPECT_EQ(engine->documentText(5), "cat dog");
+
+  // bird: априорные оценки 2.0, 1.5, 1.0 и TF-IDF не больше idf(bird);
+  // после двух документов третий уже не может попасть в кучу
+  auto page = engine->searchTfIdfPage("bird", SearchEngine::RankCursor(), 1);
+  ASSERT_EQ(page.results.size(), 1);
+  EXPECT_EQ(page.results[0].docId, 1);
+  EXPECT_TRUE(page.hasMore);
+  EXPECT_EQ(page.scored, 2);
+
+  // Оценки совпадают с полным перебором
+  for (const std::string query : {"bird", "cat dog", "cat bird", "dog"}) {
+    auto full = engine->searchTfIdf(query);
+    auto top = engine->searchTfIdfPage(query, SearchEngine::RankCursor(), 3);
+    ASSERT_EQ(top.results.size(), std::min<size_t>(3, full.size())) << query;
+    for (size_t i = 0; i < top.results.size(); ++i) {
+      EXPECT_DOUBLE_EQ(top.results[i].score, full[i].score) << query;
+    }
+  }
+
+  // Порядок сохраняется в индексе вместе со столбцом static_rank
+  ASSERT_TRUE(engine->saveIndex());
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  reloaded->setDocOrder(SearchEngine::DocOrder::Recency, 2.0);
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_EQ(
+      reloaded->searchTfIdfPage("bird", SearchEngine::RankCursor(), 1).scored,
+      2);
+  EXPECT_EQ(reloaded->searchBoolean("static_rank:1000000..").size(), 1);
+}
+
+TEST_F(RealSearchTest, UrlDepthAndLengthOrder) {
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  urls << "1\thttp://a.ru/x/y/z\n2\thttp://a.ru/\n3\thttp://a.ru/x/y\n";
+  urls << "4\thttp://a.ru/x?q=/1/2\n5\thttp://a.ru/x/y/z/w\n";
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDocOrder(SearchEngine::DocOrder::UrlDepth, 0.0);
+  engine->indexDocuments();
+  EXPECT_EQ(engine->documentText(1), "cat cat dog");
+  EXPECT_EQ(engine->documentText(2), "cat bird");
+  EXPECT_EQ(engine->documentText(5), "bird bird bird");
+
+  engine->setDocOrder(SearchEngine::DocOrder::Length, 0.0);
+  engine->indexDocuments();
+  EXPECT_EQ(engine->documentText(1), "bird bird bird");
+  EXPECT_EQ(engine->documentText(2), "cat cat dog");
+}
+
+TEST_F(RealSearchTest, EarlyTerminationMatchesFullRanking) {
+  std::mt19937 rng(11);
+  std::vector<std::string> vocab = {"alpha", "beta", "gamma", "delta",
+                                    "omega"};
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  for (int id = 100; id < 400; ++id) {
+    std::string text;
+    size_t words = 3 + rng() % 20;
+    for (size_t w = 0; w < words; ++w) {
+      text += vocab[rng() % (w == 0 ? vocab.size() : 3)] + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+    urls << id << "\thttp://example.com/" << id
+         << "\tdownload_timestamp=" << rng() % 100000 << "\n";
+  }
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDocOrder(SearchEngine::DocOrder::Recency, 1.0);
+  engine->indexDocuments();
+
+  for (const std::string query : {"alpha", "delta omega", "beta gamma"}) {
+    auto full = engine->searchTfIdf(query);
+    auto page = engine->searchTfIdfPage(query, SearchEngine::RankCursor(), 10);
+    ASSERT_EQ(page.results.size(), 10) << query;
+    for (size_t i = 0; i < page.results.size(); ++i) {
+      EXPECT_DOUBLE_EQ(page.results[i].score, full[i].score) << query;
+    }
+  }
+
+  // Частые термины: граница TF-IDF мала, и обход обрывается рано
+  auto frequent =
+      engine->searchTfIdfPage("beta gamma", SearchEngine::RankCursor(), 10);
+  EXPECT_LT(frequent.scored, engine->searchTfIdf("beta gamma").size() / 2);
+}
+
+// ============================================================================
+// Тесты перенумерации документов
+// ============================================================================
+
+TEST(DocReorderTest, BisectionGroupsSimilarDocuments) {
+  // Чётные документы используют термины 0..9, нечётные — 10..19
+  std::mt19937 rng(5);
+  std::vector<std::vector<uint32_t>> forward(256);
+  for (size_t doc = 0; doc < forward.size(); ++doc) {
+    uint32_t base = doc % 2 == 0 ? 0 : 10;
+    for (uint32_t term = 0; term < 10; ++term) {
+      if (rng() % 3 != 0) {
+        forward[doc].push_back(base + term);
+      }
+    }
+  }
+
+  std::vector<uint32_t> identity(forward.size());
+  std::iota(identity.begin(), identity.end(), 0);
+  auto order = DocReorder::graphBisection(forward, 20);
+
+  std::vector<uint32_t> sorted = order;
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(sorted, identity);
+
+  EXPECT_LT(DocReorder::logGapCost(forward, order, 20),
+            DocReorder::logGapCost(forward, identity, 20));
+
+  // Первая половина целиком из одной группы
+  size_t even = 0;
+  for (size_t i = 0; i < order.size() / 2; ++i) {
+    even += order[i] % 2 == 0 ? 1 : 0;
+  }
+  EXPECT_TRUE(even == 0 || even == order.size() / 2);
+}
+
+TEST_F(RealSearchTest, ReorderKeepsIndexConsistent) {
+  std::ofstream urls(testIndexDir + "/urls.txt");
+  urls << "1\thttp://b.ru/2\tdownload_timestamp=10\n";
+  urls << "2\thttp://a.ru/1\tdownload_timestamp=20\n";
+  urls << "3\thttp://c.ru/1\tdownload_timestamp=30\n";
+  urls << "4\thttp://a.ru/2\tdownload_timestamp=40\n";
+  urls << "5\thttp://b.ru/1\tdownload_timestamp=50\n";
+  urls.close();
+
+  ASSERT_TRUE(engine->initialize());
+  engine->indexDocuments();
+  ASSERT_TRUE(engine->saveIndex());
+
+  std::string storePath = testIndexDir + "/doc_store.bin";
+  auto fileBytes = [](const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+  };
+  std::string savedStore = fileBytes(storePath);
+
+  auto texts = [](SearchEngine &target, const std::string &query) {
+    std::multiset<std::string> result;
+    for (int docId : target.searchBoolean(query)) {
+      result.insert(target.documentText(docId));
+    }
+    return result;
+  };
+
+  std::vector<std::string> queries = {"cat", "bird -dog", "site:a.ru",
+                                      "download_timestamp:30.."};
+  std::vector<std::multiset<std::string>> before;
+  for (const auto &query : queries) {
+    before.push_back(texts(*engine, query));
+  }
+
+  for (auto method : {SearchEngine::ReorderMethod::Url,
+                      SearchEngine::ReorderMethod::GraphBisection}) {
+    auto stats = engine->reorderDocuments(method);
+    EXPECT_EQ(stats.postings, 9);
+    EXPECT_GT(stats.bitsPerPostingAfter(), 0.0);
+    for (size_t i = 0; i < queries.size(); ++i) {
+      EXPECT_EQ(texts(*engine, queries[i]), before[i]) << queries[i];
+    }
+  }
+
+  engine->reorderDocuments(SearchEngine::ReorderMethod::Url);
+  // Порядок по URL: a.ru/1, a.ru/2, b.ru/1, b.ru/2, c.ru/1
+  EXPECT_EQ(engine->documentText(1), "cat cat dog");
+  EXPECT_EQ(engine->documentText(5), "dog bird");
+  // Перенумерованное хранилище пишется только в saveIndex
+  EXPECT_EQ(fileBytes(storePath), savedStore);
+
+  ASSERT_TRUE(engine->saveIndex());
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_EQ(reloaded->documentText(1), "cat cat dog");
+  for (size_t i = 0; i < queries.size(); ++i) {
+    EXPECT_EQ(texts(*reloaded, queries[i]), before[i]) << queries[i];
+  }
+}
+
+// ============================================================================
+// Почти-дубликаты: SimHash и кластеры
+// ============================================================================
+
+namespace {
+
+// Документ из count различных слов вида "w<буквы>", начиная с first;
+// слово i повторяется 1 + i % 4 раз
+std::string syntheticText(int first, int count) {
+  std::string text;
+  for (int i = first; i < first + count; ++i) {
+    std::string word =
+        std::string("w") + char('a' + i / 26 % 26) + char('a' + i % 26);
+    for (int repeat = 0; repeat <= i % 4; ++repeat) {
+      text += word + " ";
+    }
+  }
+  return text;
+}
+
+std::map<std::string, int> termCounts(const std::string &text) {
+  std::map<std::string, int> counts;
+  std::istringstream in(text);
+  std::string word;
+  while (in >> word) {
+    counts[word]++;
+  }
+  return counts;
+}
+
+} // namespace
+
+TEST(NearDuplicatesTest, SimHashDistance) {
+  auto base = termCounts(syntheticText(0, 200));
+  auto edited = base;
+  edited["wab"]++;
+  auto other = termCounts(syntheticText(300, 200));
+
+  EXPECT_EQ(simHash(base), simHash(termCounts(syntheticText(0, 200))));
+  EXPECT_LE(hammingDistance(simHash(base), simHash(edited)), 3);
+  EXPECT_GT(hammingDistance(simHash(base), simHash(other)), 10);
+}
+
+TEST(NearDuplicatesTest, ClustersByBands) {
+  DuplicateClusters clusters(3);
+  uint64_t fp = 0x0123456789abcdefULL;
+
+  EXPECT_EQ(clusters.add(1, fp), 1);
+  EXPECT_EQ(clusters.add(2, ~fp), 2);
+  // Три бита в разных полосах: совпадает четвёртая полоса
+  EXPECT_EQ(clusters.add(3, fp ^ 1ULL ^ (1ULL << 20) ^ (1ULL << 40)), 1);
+  EXPECT_EQ(clusters.add(4, fp ^ 0xFULL), 4);
+  EXPECT_EQ(clusters.find(fp ^ 2ULL), 1);
+
+  EXPECT_FALSE(clusters.isDuplicate(1));
+  EXPECT_TRUE(clusters.isDuplicate(3));
+  EXPECT_EQ(clusters.representative(3), 1);
+  EXPECT_EQ(clusters.representative(2), 2);
+  EXPECT_EQ(clusters.clusterSize(1), 2);
+  EXPECT_EQ(clusters.clusterSize(4), 1);
+  EXPECT_EQ(clusters.duplicateCount(), 1);
+}
+
+TEST_F(RealSearchTest, NearDuplicatesCollapsedAndSkipped) {
+  std::string zebras;
+  for (int i = 0; i < 40; ++i) {
+    zebras += "zebra ";
+  }
+  std::string base = zebras + syntheticText(0, 200);
+  createDoc("6.txt", "cat " + base);
+  createDoc("7.txt", "cat " + base + "wab");
+  createDoc("8.txt", "cat " + syntheticText(300, 200));
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Collapse);
+  engine->indexDocuments();
+
+  // 7.txt свёрнут в 6.txt, короткие документы не получают отпечатков
+  EXPECT_EQ(engine->searchBoolean("cat").size(), 6);
+  auto page =
+      engine->searchTfIdfPage("zebra", SearchEngine::RankCursor(), 10);
+  ASSERT_EQ(page.results.size(), 1);
+  EXPECT_EQ(engine->duplicateClusterSize(page.results[0].docId), 2);
+  EXPECT_EQ(engine->searchTfIdf("zebra").size(), 1);
+  EXPECT_EQ(engine->duplicateClusterSize(1), 1);
+
+  ASSERT_TRUE(engine->saveIndex());
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  ASSERT_TRUE(reloaded->loadIndex());
+  reloaded->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Collapse);
+  EXPECT_EQ(reloaded->searchTfIdf("zebra").size(), 1);
+
+  reloaded->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Keep);
+  EXPECT_EQ(reloaded->searchTfIdf("zebra").size(), 2);
+
+  // Skip не индексирует дубликат вовсе
+  engine->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Skip);
+  engine->indexDocuments();
+  EXPECT_EQ(engine->searchBoolean("cat").size(), 5);
+  EXPECT_EQ(engine->searchBoolean("zebra").size(), 1);
+}
+
+TEST_F(RealSearchTest, CollapseKeepsBestMatchingDuplicate) {
+  std::string base = syntheticText(0, 200);
+  createDoc("6.txt", "cat " + base);
+  createDoc("7.txt", "cat " + base + "quagga");
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Collapse);
+  // Одно вхождение в длинном документе проходит порог оценки только в BM25
+  engine->setScoringModel(SearchEngine::ScoringModel::Bm25);
+  engine->indexDocuments();
+  auto isDuplicate = [&](int docId) {
+    return engine->documentText(docId).find("quagga") != std::string::npos;
+  };
+
+  // Совпадает только дубликат: он и остаётся в выдаче
+  auto byTfIdf = engine->searchTfIdf("quagga");
+  ASSERT_EQ(byTfIdf.size(), 1);
+  EXPECT_TRUE(isDuplicate(byTfIdf[0].docId));
+  EXPECT_EQ(engine->duplicateClusterSize(byTfIdf[0].docId), 2);
+  auto byBoolean = engine->searchBooleanRanked("quagga", 10);
+  ASSERT_EQ(byBoolean.size(), 1);
+  EXPECT_TRUE(isDuplicate(byBoolean[0].docId));
+
+  // Совпадают оба: остаётся член кластера с лучшей оценкой
+  for (size_t partitions : {1, 3}) {
+    engine->setQueryPartitions(partitions);
+    auto page = engine->searchBooleanRankedPage(
+        "wab OR quagga", SearchEngine::RankCursor(), 10);
+    ASSERT_EQ(page.results.size(), 1) << partitions;
+    EXPECT_TRUE(isDuplicate(page.results[0].docId)) << partitions;
+    EXPECT_EQ(engine->searchTfIdf("wab quagga").size(), 1) << partitions;
+  }
+}
+
+TEST_F(RealSearchTest, CollapsePagesMatchSinglePage) {
+  // Кластер из двух лучших документов: более короткий оценивается выше.
+  // docId назначаются по убыванию длины, поэтому лучший член кластера
+  // обходится последним, после своего дубликата и остальных документов
+  std::string base = syntheticText(0, 200);
+  createDoc("6.txt", base + "quagga");
+  createDoc("7.txt", base + syntheticText(0, 2) + "quagga");
+  for (int i = 0; i < 6; ++i) {
+    createDoc(std::to_string(10 + i) + ".txt",
+              syntheticText(300 + 200 * i, 204 + 2 * i) + "quagga");
+  }
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setDocOrder(SearchEngine::DocOrder::Length, 0.0);
+  engine->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Collapse);
+  engine->setScoringModel(SearchEngine::ScoringModel::Bm25);
+  engine->indexDocuments();
+
+  auto all = engine->searchBooleanRankedPage(
+      "quagga", SearchEngine::RankCursor(), 100);
+  ASSERT_EQ(all.results.size(), 7);
+  EXPECT_EQ(engine->documentText(all.results[0].docId), base + "quagga");
+  EXPECT_EQ(engine->duplicateClusterSize(all.results[0].docId), 2);
+
+  // Страницы по 1 и 2 документа дают ту же выдачу, что и одна страница
+  for (size_t pageSize : {1, 2}) {
+    std::vector<int> paged;
+    SearchEngine::RankCursor cursor;
+    for (int page = 0; page < 10; ++page) {
+      auto result =
+          engine->searchBooleanRankedPage("quagga", cursor, pageSize);
+      for (const auto &doc : result.results) {
+        paged.push_back(doc.docId);
+      }
+      if (!result.hasMore) {
+        break;
+      }
+      cursor = result.next;
+    }
+    ASSERT_EQ(paged.size(), all.results.size()) << pageSize;
+    for (size_t i = 0; i < paged.size(); ++i) {
+      EXPECT_EQ(paged[i], all.results[i].docId) << pageSize << " " << i;
+    }
+  }
+}
+
+// ============================================================================
+// Статическое прореживание индекса
+// ============================================================================
+
+TEST(IndexPruningTest, TermCentricKeepsTopK) {
+  std::vector<IndexPruning::ScoredList> lists = {
+      {{1, 0.9}, {2, 0.1}, {3, 0.5}, {4, 0.3}},
+      {{1, 0.2}},
+  };
+
+  // k = 2: вторая оценка 0.5, порог 0.5 * 0.5
+  auto keep = IndexPruning::termCentric(lists, 2, 0.5);
+  EXPECT_EQ(keep[0], std::vector<bool>({true, false, true, true}));
+  EXPECT_EQ(keep[1], std::vector<bool>({true}));
+
+  keep = IndexPruning::termCentric(lists, 2, 1.0);
+  EXPECT_EQ(keep[0], std::vector<bool>({true, false, true, false}));
+}
+
+TEST(IndexPruningTest, DocumentCentricKeepsBestTerms) {
+  std::vector<IndexPruning::ScoredList> lists = {
+      {{1, 0.9}, {2, 0.1}},
+      {{1, 0.2}, {2, 0.8}},
+      {{1, 0.1}},
+  };
+
+  // Половина терминов документа с округлением вверх
+  auto keep = IndexPruning::documentCentric(lists, 0.5);
+  EXPECT_EQ(keep[0], std::vector<bool>({true, false}));
+  EXPECT_EQ(keep[1], std::vector<bool>({true, true}));
+  // Термин без оставленных postings сохраняет лучший
+  EXPECT_EQ(keep[2], std::vector<bool>({true}));
+}
+
+TEST(IndexPruningTest, Recall) {
+  EXPECT_DOUBLE_EQ(IndexPruning::recall({1, 2, 3, 4}, {4, 2, 7}), 0.5);
+  EXPECT_DOUBLE_EQ(IndexPruning::recall({}, {1}), 1.0);
+}
+
+TEST_F(RealSearchTest, PrunedHotTier) {
+  ASSERT_TRUE(engine->initialize());
+  ASSERT_TRUE(engine->loadIndex());
+  std::vector<std::string> queries = {"cat", "dog bird", "bird", "cat dog"};
+
+  // epsilon = 0 сохраняет всё
+  auto full = engine->pruneIndex(SearchEngine::PruneMethod::TermCentric, 0.0,
+                                 queries);
+  EXPECT_TRUE(full.saved);
+  EXPECT_EQ(full.postingsAfter, full.postingsBefore);
+  EXPECT_EQ(full.queries, 4);
+  EXPECT_DOUBLE_EQ(full.recall, 1.0);
+
+  auto pruned = engine->pruneIndex(SearchEngine::PruneMethod::DocumentCentric,
+                                   0.5, queries, 1);
+  EXPECT_LT(pruned.postingsAfter, pruned.postingsBefore);
+  EXPECT_LT(pruned.bytesAfter, pruned.bytesBefore);
+  EXPECT_GT(pruned.recall, 0.0);
+  EXPECT_LE(pruned.recall, 1.0);
+
+  // У каждого документа остаётся один термин (и лучший posting термина):
+  // не больше 6 postings на 9 эталонных документов. Recall считается по
+  // прореженным спискам, а не по чемпионам полного индекса
+  auto heavy = engine->pruneIndex(SearchEngine::PruneMethod::DocumentCentric,
+                                  0.01, {"cat", "dog", "bird"}, 3);
+  EXPECT_LE(heavy.postingsAfter, 6);
+  EXPECT_EQ(heavy.queries, 3);
+  EXPECT_LE(heavy.recall, 6.0 / 9.0 + 1e-9);
+  EXPECT_GT(heavy.recall, 0.0);
+
+  // Уровень вне [0, 1] отвергается до прореживания
+  EXPECT_THROW(engine->pruneIndex(SearchEngine::PruneMethod::DocumentCentric,
+                                  -0.5, queries),
+               std::invalid_argument);
+  EXPECT_THROW(engine->pruneIndex(SearchEngine::PruneMethod::TermCentric, 1.5,
+                                  queries),
+               std::invalid_argument);
+  EXPECT_THROW(engine->pruneIndex(SearchEngine::PruneMethod::TermCentric,
+                                  std::nan(""), queries),
+               std::invalid_argument);
+  // Полный индекс в памяти не изменился
+  EXPECT_EQ(engine->searchBoolean("cat").size(), 3);
+
+  // Незаписанный горячий уровень возвращается как ошибка без замера
+  // recall, прежний hot_index.bin остаётся
+  fs::create_directory(testIndexDir + "/hot_index.bin.tmp");
+  auto failed = engine->pruneIndex(SearchEngine::PruneMethod::TermCentric,
+                                   0.0, queries);
+  EXPECT_FALSE(failed.saved);
+  EXPECT_EQ(failed.queries, 0);
+  fs::remove(testIndexDir + "/hot_index.bin.tmp");
+
+  auto hot = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(hot->initialize());
+  hot->setHotTier(true);
+  ASSERT_TRUE(hot->loadIndex());
+  EXPECT_TRUE(hot->hotTierLoaded());
+  EXPECT_LT(hot->searchBoolean("cat").size(), 3);
+  EXPECT_FALSE(hot->searchBoolean("cat").empty());
+  EXPECT_FALSE(hot->saveIndex());
+
+  // Счётчик совпадает с выдачей горячего уровня, а обе ранжирующие выдачи
+  // берут df из словаря и оценивают документы одинаково
+  EXPECT_EQ(hot->countBoolean("cat").count, hot->searchBoolean("cat").size());
+  for (const std::string query : {"cat", "cat dog", "dog bird"}) {
+    auto scored = hot->searchTfIdf(query);
+    auto page = hot->searchTfIdfPage(query, SearchEngine::RankCursor(), 10);
+    EXPECT_FALSE(page.fromChampions);
+    ASSERT_EQ(page.results.size(), scored.size()) << query;
+    for (size_t i = 0; i < scored.size(); ++i) {
+      EXPECT_EQ(page.results[i].docId, scored[i].docId) << query;
+      EXPECT_NEAR(page.results[i].score, scored[i].score, 1e-9) << query;
+    }
+  }
+
+  // Сохранение перестроенного индекса удаляет горячий уровень, а чужой
+  // файл не загружается
+  std::string hotPath = testIndexDir + "/hot_index.bin";
+  std::string stalePath = testIndexDir + "/stale_hot.bin";
+  fs::copy_file(hotPath, stalePath);
+  fs::remove(testDataDir + "/1.txt");
+  engine->indexDocuments();
+  ASSERT_TRUE(engine->saveIndex());
+  EXPECT_FALSE(fs::exists(hotPath));
+
+  fs::rename(stalePath, hotPath);
+  auto stale = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(stale->initialize());
+  stale->setHotTier(true);
+  ASSERT_TRUE(stale->loadIndex());
+  EXPECT_FALSE(stale->hotTierLoaded());
+  EXPECT_EQ(stale->searchBoolean("cat").size(), 2);
+}
+
+// ============================================================================
+// Списки чемпионов
+// ============================================================================
+
+TEST(ChampionListsTest, TopByScoreSavedAndValidated) {
+  TermDictionary dict;
+  dict.build({{"a", 5}, {"b", 2}});
+
+  ChampionLists champions;
+  champions.reset(3, dict);
+  champions.add({{1, 1}, {2, 4}, {3, 2}, {4, 4}, {5, 3}},
+                {0.1, 0.4, 0.2, 0.4, 0.3});
+  champions.add({{7, 1}, {9, 2}}, {0.5, 0.6});
+
+  using Postings = std::vector<std::pair<int, int>>;
+  EXPECT_EQ(champions.list(0), Postings({{2, 4}, {4, 4}, {5, 3}}));
+  EXPECT_EQ(champions.list(1), Postings({{7, 1}, {9, 2}}));
+  EXPECT_TRUE(champions.list(2).empty());
+
+  std::string path = "test_champions.bin";
+  ASSERT_TRUE(champions.save(path));
+
+  ChampionLists loaded;
+  ASSERT_TRUE(loaded.load(path, dict, 3));
+  EXPECT_EQ(loaded.list(0), champions.list(0));
+  EXPECT_FALSE(loaded.load(path, dict, 4));
+
+  TermDictionary other;
+  other.build({{"a", 5}, {"c", 2}});
+  EXPECT_FALSE(loaded.load(path, other, 3));
+  EXPECT_TRUE(loaded.empty());
+  std::remove(path.c_str());
+}
+
+TEST_F(RealSearchTest, ChampionListsMatchFullRanking) {
+  // tf / длина у zeta равен i / 20 и у всех документов различен
+  for (int i = 1; i <= 12; ++i) {
+    std::string text;
+    for (int w = 0; w < 20; ++w) {
+      text += w < i ? "zeta " : (w % 2 ? "eta " : "theta ");
+    }
+    createDoc(std::to_string(100 + i) + ".txt", text);
+  }
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setChampionListSize(6);
+  engine->indexDocuments();
+
+  auto check = [](SearchEngine &target, const std::string &query) {
+    auto full = target.searchTfIdf(query);
+    auto page = target.searchTfIdfPage(query, SearchEngine::RankCursor(), 3);
+    EXPECT_EQ(page.results.size(), std::min<size_t>(3, full.size()));
+    for (size_t i = 0; i < page.results.size(); ++i) {
+      EXPECT_EQ(page.results[i].docId, full[i].docId) << query;
+      EXPECT_DOUBLE_EQ(page.results[i].score, full[i].score) << query;
+    }
+    EXPECT_EQ(page.hasMore, full.size() > 3) << query;
+    return page.fromChampions;
+  };
+
+  // Четвёртый результат (9 / 20) выше худшего чемпиона (7 / 20)
+  EXPECT_TRUE(check(*engine, "zeta"));
+  // Короткий список полон: ответ точен
+  EXPECT_TRUE(check(*engine, "bird"));
+  for (const std::string query : {"zeta eta", "cat zeta", "theta eta cat"}) {
+    check(*engine, query);
+  }
+
+  // Страницы после первой считаются по полным спискам
+  auto first = engine->searchTfIdfPage("zeta", SearchEngine::RankCursor(), 3);
+  EXPECT_FALSE(engine->searchTfIdfPage("zeta", first.next, 3).fromChampions);
+
+  ASSERT_TRUE(engine->saveIndex());
+  auto reloaded = std::make_unique<SearchEngine>(
+      testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+  ASSERT_TRUE(reloaded->initialize());
+  reloaded->setChampionListSize(6);
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_TRUE(check(*reloaded, "zeta"));
+
+  reloaded->setChampionListSize(0);
+  ASSERT_TRUE(reloaded->loadIndex());
+  EXPECT_FALSE(check(*reloaded, "zeta"));
+}
+
+// ============================================================================
+// Поблочная оценка postings
+// ============================================================================
+
+TEST(ScoreKernelTest, BlocksMatchScalarScoring) {
+  std::mt19937 rng(5);
+  std::vector<std::pair<int, int>> postings;
+  int docId = 0;
+  for (int i = 0; i < 300; ++i) {
+    docId += 1 + rng() % 3;
+    postings.emplace_back(docId, 1 + rng() % 7);
+  }
+  auto data = CompressionUtils::compressPostingList(postings);
+
+  std::vector<double> lengths(docId + 1);
+  for (auto &length : lengths) {
+    length = 5 + rng() % 50;
+  }
+
+  // 300 postings: два полных блока и хвост не кратный числу дорожек
+  size_t offset = 0;
+  int lastDocId = 0;
+  int docIds[ScoreKernel::BLOCK_SIZE];
+  int tfs[ScoreKernel::BLOCK_SIZE];
+  std::vector<size_t> blocks;
+  while (size_t count = ScoreKernel::decodeBlock(data, offset, lastDocId,
+                                                 docIds, tfs)) {
+    blocks.push_back(count);
+  }
+  EXPECT_EQ(blocks, std::vector<size_t>({128, 128, 44}));
+
+  Scoring::TermScorer<Scoring::TfIdf> tfIdf{1.5, 30.0};
+  Scoring::TermScorer<Scoring::Bm25> bm25{1.5, 30.0};
+  std::vector<double> tfIdfScores(lengths.size(), 0.0);
+  std::vector<double> bm25Scores(lengths.size(), 0.0);
+  ScoreKernel::scoreList(tfIdf, data, lengths.data(), tfIdfScores.data());
+  ScoreKernel::scoreList(bm25, data, lengths.data(), bm25Scores.data());
+
+  for (const auto &posting : postings) {
+    double tf = posting.second;
+    double length = lengths[posting.first];
+    EXPECT_EQ(tfIdfScores[posting.first], tf / length * 1.5);
+    EXPECT_DOUBLE_EQ(bm25Scores[posting.first],
+                     1.5 * tf * 2.2 / (tf + 1.2 * (0.25 + 0.75 * length / 30)));
+  }
+  EXPECT_EQ(tfIdfScores[0], 0.0);
+}
+
+// ============================================================================
+// Политики оценки
+// ============================================================================
+
+template <typename Policy> void expectBoundHolds(std::mt19937 &rng) {
+  Scoring::TermBounds bounds = {0.5, 6.0, 4.0};
+  double weight = Policy::weight(3.0, 100.0);
+  double bound = Policy::bound(weight, bounds, 20.0);
+
+  for (int i = 0; i < 1000; ++i) {
+    double length = 4.0 + rng() % 60;
+    double tf = 1.0 + rng() % 6;
+    if (tf / length > bounds.maxRatio) {
+      continue;
+    }
+    EXPECT_LE(Policy::score(weight, tf, length, 20.0), bound);
+  }
+  // Общие границы годятся для любого списка
+  EXPECT_GE(Policy::bound(weight, Scoring::TermBounds(), 20.0), bound);
+}
+
+TEST(ScoringPolicyTest, BoundsHold) {
+  std::mt19937 rng(3);
+  expectBoundHolds<Scoring::TfIdf>(rng);
+  expectBoundHolds<Scoring::Bm25>(rng);
+  expectBoundHolds<Scoring::Bm25Plus>(rng);
+  expectBoundHolds<Scoring::Count>(rng);
+
+  EXPECT_DOUBLE_EQ(Scoring::TfIdf::score(2.0, 1.0, 4.0, 10.0), 0.5);
+  EXPECT_DOUBLE_EQ(Scoring::Count::score(0.0, 3.0, 10.0, 5.0), 3.0);
+  // BM25 насыщается: вклад ограничен (k1 + 1) * вес
+  EXPECT_LT(Scoring::Bm25::score(1.0, 1000.0, 10.0, 10.0), 2.2);
+  EXPECT_GT(Scoring::Bm25Plus::score(1.0, 1.0, 1000.0, 10.0), 1.0);
+}
+
+TEST_F(RealSearchTest, ScoringModelsAgreeAcrossEvaluators) {
+  std::mt19937 rng(17);
+  std::vector<std::string> vocab = {"alpha", "beta", "gamma", "delta",
+                                    "omega"};
+  for (int id = 100; id < 300; ++id) {
+    std::string text;
+    size_t words = 3 + rng() % 30;
+    for (size_t w = 0; w < words; ++w) {
+      text += vocab[rng() % (w == 0 ? vocab.size() : 3)] + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+  }
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setChampionListSize(8);
+  engine->indexDocuments();
+
+  using Model = SearchEngine::ScoringModel;
+  for (Model model :
+       {Model::TfIdf, Model::Bm25, Model::Bm25Plus, Model::Count}) {
+    engine->setScoringModel(model);
+    for (const std::string query : {"alpha", "delta omega", "beta gamma"}) {
+      auto full = engine->searchTfIdf(query);
+      auto page =
+          engine->searchTfIdfPage(query, SearchEngine::RankCursor(), 10);
+      auto next = engine->searchTfIdfPage(query, page.next, 10);
+      page.results.insert(page.results.end(), next.results.begin(),
+                          next.results.end());
+
+      ASSERT_EQ(page.results.size(), std::min<size_t>(20, full.size()));
+      for (size_t i = 0; i < page.results.size(); ++i) {
+        EXPECT_EQ(page.results[i].docId, full[i].docId) << query;
+        EXPECT_DOUBLE_EQ(page.results[i].score, full[i].score) << query;
+      }
+    }
+  }
+
+  // Count: оценка — сумма tf, «bird bird bird» впереди
+  engine->setScoringModel(Model::Count);
+  auto top = engine->searchTfIdf("bird");
+  ASSERT_FALSE(top.empty());
+  EXPECT_DOUBLE_EQ(top[0].score, 3.0);
+  EXPECT_EQ(engine->documentText(top[0].docId), "bird bird bird");
+}
+
+// ============================================================================
+// Разбиение запроса по диапазонам docId
+// ============================================================================
+
+TEST(QueryPartitionTest, ClipResumesFromPosition) {
+  std::vector<std::pair<int, int>> postings;
+  for (int docId = 3; docId <= 60; docId += 3) {
+    postings.emplace_back(docId, docId % 5 + 1);
+  }
+  auto data = CompressionUtils::compressPostingList(postings);
+
+  // Позиция перед первым документом >= 20 продолжает обход с него
+  PostingIterator scan(&data);
+  PostingIterator::Position start = scan.position();
+  while (scan.next() < 20) {
+    start = scan.position();
+  }
+  PostingIterator resumed(&data, start);
+  EXPECT_EQ(resumed.next(), 21);
+  EXPECT_EQ(resumed.freq(), 2);
+
+  PostingLookup lookup = [&](const std::string &) {
+    return std::vector<const std::vector<uint8_t> *>{&data};
+  };
+  auto clipped = QueryPlan::clip(
+      QueryPlan::compile(QueryNode::makeTerm("x"), lookup), 10, 30);
+  EXPECT_EQ(QueryPlan::collect(*clipped),
+            (std::vector<int>{12, 15, 18, 21, 24, 27}));
+
+  auto skipped = QueryPlan::clip(
+      QueryPlan::compile(QueryNode::makeTerm("x"), lookup, {},
+                         [&](const std::vector<uint8_t> *) { return start; }),
+      20, 40);
+  EXPECT_EQ(skipped->advance(35), 36);
+  EXPECT_EQ(skipped->next(), 39);
+  EXPECT_EQ(skipped->next(), DocIterator::NO_MORE_DOCS);
+}
+
+TEST_F(RealSearchTest, PartitionedQueriesMatchSequential) {
+  std::mt19937 rng(23);
+  std::vector<std::string> vocab = {"alpha", "beta", "gamma", "delta",
+                                    "omega"};
+  for (int id = 100; id < 400; ++id) {
+    std::string text;
+    size_t words = 3 + rng() % 30;
+    for (size_t w = 0; w < words; ++w) {
+      text += vocab[rng() % (w == 0 ? vocab.size() : 3)] + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+  }
+
+  ASSERT_TRUE(engine->initialize());
+  engine->setChampionListSize(0);
+  engine->indexDocuments();
+
+  std::vector<std::string> booleanQueries = {"alpha", "+beta +gamma",
+                                             "delta omega", "+gamma -alpha",
+                                             "gam*"};
+  std::vector<std::string> rankedQueries = {"alpha", "delta omega",
+                                            "beta gamma"};
+
+  std::vector<std::vector<int>> booleanResults;
+  std::vector<std::vector<SearchEngine::ScoredDocument>> rankedResults;
+  auto runQueries = [&]() {
+    booleanResults.clear();
+    rankedResults.clear();
+    for (const auto &query : booleanQueries) {
+      booleanResults.push_back(engine->searchBoolean(query));
+      booleanResults.push_back(engine->searchBoolean(query, 7));
+    }
+    for (const auto &query : rankedQueries) {
+      rankedResults.push_back(engine->searchTfIdf(query));
+      auto page =
+          engine->searchTfIdfPage(query, SearchEngine::RankCursor(), 10);
+      auto next = engine->searchTfIdfPage(query, page.next, 10);
+      page.results.insert(page.results.end(), next.results.begin(),
+                          next.results.end());
+      rankedResults.push_back(page.results);
+    }
+  };
+
+  runQueries();
+  auto expectedBoolean = booleanResults;
+  auto expectedRanked = rankedResults;
+
+  for (size_t partitions : {3, 4}) {
+    engine->setQueryPartitions(partitions);
+    ASSERT_EQ(engine->queryPartitions(), partitions);
+    runQueries();
+
+    EXPECT_EQ(booleanResults, expectedBoolean);
+    ASSERT_EQ(rankedResults.size(), expectedRanked.size());
+    for (size_t i = 0; i < rankedResults.size(); ++i) {
+      ASSERT_EQ(rankedResults[i].size(), expectedRanked[i].size());
+      for (size_t j = 0; j < rankedResults[i].size(); ++j) {
+        EXPECT_EQ(rankedResults[i][j].docId, expectedRanked[i][j].docId);
+        // Суммы по терминам идут в том же порядке: оценки совпадают точно
+        EXPECT_EQ(rankedResults[i][j].score, expectedRanked[i][j].score);
+      }
+    }
+  }
+
+  engine->setQueryPartitions(1);
+  EXPECT_EQ(engine->queryPartitions(), 1u);
+}
+
+// ============================================================================
+// Шарды и координатор
+// ============================================================================
+
+TEST(ShardStatsTest, MergePrefersExactTerms) {
+  SearchEngine::CollectionStats total;
+  SearchEngine::CollectionStats first;
+  first.documents = 3;
+  first.totalLength = 12.0;
+  first.terms["zeta"] = {4, false}; // нечёткое раскрытие в шарде без термина
+  first.terms["gam*"] = {2, false};
+  SearchEngine::CollectionStats second;
+  second.documents = 5;
+  second.totalLength = 20.0;
+  second.terms["zeta"] = {1, true};
+  second.terms["gam*"] = {3, false};
+
+  total.merge(first);
+  total.merge(second);
+  EXPECT_EQ(total.documents, 8);
+  EXPECT_DOUBLE_EQ(total.averageLength(), 4.0);
+  EXPECT_EQ(total.terms["zeta"].docFrequency, 1u);
+  EXPECT_TRUE(total.terms["zeta"].exact);
+  EXPECT_EQ(total.terms["gam*"].docFrequency, 5u);
+}
+
+TEST_F(RealSearchTest, ShardedSearchMatchesSingleIndex) {
+  std::mt19937 rng(29);
+  std::vector<std::string> vocab = {"alpha", "beta", "gamma", "delta",
+                                    "omega"};
+  for (int id = 100; id < 220; ++id) {
+    std::string text = id == 150 ? "zeta " : "";
+    size_t words = 3 + rng() % 30;
+    for (size_t w = 0; w < words; ++w) {
+      text += vocab[rng() % (w == 0 ? vocab.size() : 3)] + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+  }
+
+  engine->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Keep);
+  engine->indexDocuments();
+
+  const size_t shardCount = 3;
+  using ShardBy = SearchEngine::ShardBy;
+  for (ShardBy by : {ShardBy::DocId, ShardBy::Hash}) {
+    std::vector<std::unique_ptr<SearchEngine>> shards;
+    std::vector<std::unique_ptr<ShardServer>> servers;
+    std::vector<std::thread> threads;
+    std::vector<std::string> sockets;
+
+    for (size_t i = 0; i < shardCount; ++i) {
+      auto shard = std::make_unique<SearchEngine>(
+          testDataDir, testIndexDir + "/lemmas.txt", testIndexDir);
+      shard->setShard(i, shardCount, by);
+      shard->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Keep);
+      ASSERT_TRUE(shard->initialize());
+      shard->indexDocuments();
+      ASSERT_TRUE(shard->saveIndex());
+      // Сервер работает с индексом, загруженным с диска
+      ASSERT_TRUE(shard->loadIndex());
+
+      sockets.push_back(testIndexDir + "/shard_" + std::to_string(i) +
+                        ".sock");
+      servers.push_back(std::make_unique<ShardServer>(*shard, sockets.back()));
+      ASSERT_TRUE(servers.back()->listen());
+      shards.push_back(std::move(shard));
+    }
+    for (auto &server : servers) {
+      threads.emplace_back([&server] { server->serve(); });
+    }
+
+    ShardCoordinator coordinator(sockets);
+    ASSERT_TRUE(coordinator.connect());
+    EXPECT_EQ(coordinator.collectionStats("alpha").documents,
+              engine->collectionStats("alpha").documents);
+
+    // Второй координатор обслуживается, пока первый держит соединения
+    ShardCoordinator second(sockets);
+    ASSERT_TRUE(second.connect());
+    EXPECT_EQ(second.collectionStats("alpha").documents,
+              engine->collectionStats("alpha").documents);
+
+    using Model = SearchEngine::ScoringModel;
+    for (Model model : {Model::TfIdf, Model::Bm25}) {
+      engine->setScoringModel(model);
+      for (auto &shard : shards) {
+        shard->setScoringModel(model);
+      }
+
+      // zeta есть только в одном шарде: остальные не должны раскрывать её
+      // нечётким поиском до beta
+      for (const std::string query :
+           {"alpha", "delta omega", "beta gamma", "gam*", "zeta gamma"}) {
+        auto expected = engine->searchTfIdf(query);
+        expected.resize(std::min<size_t>(expected.size(), 10));
+        auto merged = coordinator.searchTfIdf(query, 10);
+
+        ASSERT_EQ(merged.size(), expected.size()) << query;
+        for (size_t i = 0; i < merged.size(); ++i) {
+          EXPECT_EQ(merged[i].docId, expected[i].docId) << query;
+          EXPECT_EQ(merged[i].score, expected[i].score) << query;
+        }
+      }
+    }
+
+    for (auto &server : servers) {
+      server->stop();
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+// ============================================================================
+// Слияние индексов
+// ============================================================================
+
+TEST_F(RealSearchTest, MergedIndexMatchesInputs) {
+  // Два набора документов индексируются отдельно и вместе
+  std::string firstDir = testIndexDir + "/first_data";
+  std::string secondDir = testIndexDir + "/second_data";
+  std::string allDir = testIndexDir + "/all_data";
+  for (const auto &dir : {firstDir, secondDir, allDir}) {
+    fs::create_directories(dir);
+  }
+
+  std::mt19937 rng(31);
+  std::vector<std::string> vocab = {"alpha", "beta", "gamma", "delta",
+                                    "omega"};
+  for (int id = 100; id < 260; ++id) {
+    std::string text = "doc" + std::to_string(id) + " ";
+    size_t words = 3 + rng() % 30;
+    for (size_t w = 0; w < words; ++w) {
+      text += vocab[rng() % (w == 0 ? vocab.size() : 3)] + " ";
+    }
+    std::string name = "/" + std::to_string(id) + ".txt";
+    TestHelper::createFile((id < 180 ? firstDir : secondDir) + name, text);
+    TestHelper::createFile(allDir + name, text);
+  }
+
+  auto build = [&](const std::string &dataDir, const std::string &indexDir) {
+    fs::create_directories(indexDir);
+    auto built = std::make_unique<SearchEngine>(
+        dataDir, testIndexDir + "/lemmas.txt", indexDir);
+    built->setDuplicatePolicy(SearchEngine::DuplicatePolicy::Keep);
+    EXPECT_TRUE(built->initialize());
+    built->indexDocuments();
+    EXPECT_TRUE(built->saveIndex());
+    return built;
+  };
+  auto first = build(firstDir, testIndexDir + "/first");
+  auto second = build(secondDir, testIndexDir + "/second");
+  auto single = build(allDir, testIndexDir + "/all");
+
+  // Столбец doc values, которого нет в реестре, переносится со сдвигом;
+  // глобальные docId шардов отбрасываются
+  for (const std::string input : {"/first", "/second"}) {
+    DocValues values;
+    DocValuesColumn &column = values.column("rank");
+    for (int docId = 1; docId <= 80; docId += 3) {
+      column.add(docId, input == "/first" ? docId : -docId);
+    }
+    DocValuesColumn &globalIds = values.column("global_id");
+    for (int docId = 1; docId <= 80; ++docId) {
+      globalIds.add(docId, 2 * docId);
+    }
+    values.finish();
+    ASSERT_TRUE(values.save(testIndexDir + input + "/doc_values.bin"));
+  }
+
+  IndexMerge::MergeStats stats;
+  // Маленький буфер: списки копируются в несколько порций
+  ASSERT_TRUE(IndexMerge::mergeIndexes(
+      {testIndexDir + "/first", testIndexDir + "/second"},
+      testIndexDir + "/merged", stats, 16));
+  EXPECT_EQ(stats.inputs, 2u);
+  EXPECT_EQ(stats.documents, 160u);
+
+  DocValues mergedValues;
+  ASSERT_TRUE(mergedValues.load(testIndexDir + "/merged/doc_values.bin"));
+  const DocValuesColumn *rank = mergedValues.find("rank");
+  ASSERT_NE(rank, nullptr);
+  EXPECT_EQ(rank->valueCount(), 54u);
+  int64_t value = 0;
+  EXPECT_TRUE(rank->get(79, value));
+  EXPECT_EQ(value, 79);
+  EXPECT_TRUE(rank->get(81, value));
+  EXPECT_EQ(value, -1);
+  EXPECT_FALSE(rank->get(82, value));
+  EXPECT_EQ(mergedValues.find("global_id"), nullptr);
+
+  SearchEngine merged(allDir, testIndexDir + "/lemmas.txt",
+                      testIndexDir + "/merged");
+  merged.setDuplicatePolicy(SearchEngine::DuplicatePolicy::Keep);
+  ASSERT_TRUE(merged.initialize());
+  ASSERT_TRUE(merged.loadIndex());
+  EXPECT_EQ(merged.globalDocId(81), 81);
+
+  // Списки: документы первого входа, затем второго со сдвигом docId
+  for (const std::string query : {"alpha", "+beta +omega", "-delta +gamma"}) {
+    auto expected = first->searchBoolean(query);
+    for (int docId : second->searchBoolean(query)) {
+      expected.push_back(docId + 80);
+    }
+    EXPECT_EQ(merged.searchBoolean(query), expected) << query;
+  }
+
+  // Оценки совпадают с индексом, построенным сразу по всем документам
+  for (const std::string query : {"alpha", "delta omega", "beta gamma"}) {
+    auto byText = [](const SearchEngine &engine, const std::string &query) {
+      std::vector<std::pair<std::string, double>> results;
+      for (const auto &result : engine.searchTfIdf(query)) {
+        results.emplace_back(engine.documentText(result.docId), result.score);
+      }
+      std::sort(results.begin(), results.end());
+      return results;
+    };
+    EXPECT_EQ(byText(merged, query), byText(*single, query)) << query;
+  }
+
+  // Оборванное слияние не трогает прежний результат и не оставляет
+  // временных файлов
+  std::string broken = testIndexDir + "/broken";
+  fs::copy(testIndexDir + "/second", broken);
+  // Обрыв посреди записи термина, а не на её границе; длины входа
+  // отличаются, чтобы частичная запись была заметна
+  fs::resize_file(broken + "/inverted_index.bin",
+                  fs::file_size(broken + "/inverted_index.bin") / 2 + 3);
+  std::ofstream(broken + "/doc_lengths.txt", std::ios::app) << "90 4\n";
+  std::string lengthsPath = testIndexDir + "/merged/doc_lengths.txt";
+  std::string lengthsBefore = FileUtils::readFileContent(lengthsPath);
+  EXPECT_FALSE(IndexMerge::mergeIndexes({testIndexDir + "/first", broken},
+                                        testIndexDir + "/merged", stats));
+  EXPECT_EQ(FileUtils::readFileContent(lengthsPath), lengthsBefore);
+  for (const auto &entry : fs::directory_iterator(testIndexDir + "/merged")) {
+    EXPECT_NE(entry.path().extension(), ".tmp") << entry.path();
+  }
+  EXPECT_TRUE(fs::exists(testIndexDir + "/merged/inverted_index.bin"));
+}
+
+// ============================================================================
+// Параллельное сжатие списков при индексации
+// ============================================================================
+
+TEST_F(RealSearchTest, ParallelCompressionIsDeterministic) {
+  std::mt19937 rng(37);
+  for (int id = 100; id < 400; ++id) {
+    std::string text;
+    size_t words = 3 + rng() % 40;
+    for (size_t w = 0; w < words; ++w) {
+      text += "w" + std::to_string(rng() % (w == 0 ? 2000 : 50)) + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+  }
+
+  // Параллельно сжимаются только накопленные пары
+  engine->setDirectPostings(false);
+  auto indexBytes = [&](size_t threads) {
+    engine->setIndexThreads(threads);
+    engine->indexDocuments();
+    EXPECT_TRUE(engine->saveIndex());
+    std::ifstream file(testIndexDir + "/inverted_index.bin",
+                       std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+  };
+
+  std::string serial = indexBytes(1);
+  auto expected = engine->searchBoolean("w7");
+  ASSERT_FALSE(expected.empty());
+
+  for (size_t threads : {2, 4, 7}) {
+    EXPECT_EQ(indexBytes(threads), serial) << threads;
+    EXPECT_EQ(engine->searchBoolean("w7"), expected) << threads;
+  }
+}
+
+// ============================================================================
+// Прямое накопление списков в delta-VByte
+// ============================================================================
+
+TEST(PostingAccumulatorTest, MatchesCompressedPairs) {
+  std::mt19937 rng(41);
+  std::map<std::string, std::vector<std::pair<int, int>>> expected;
+  PostingAccumulator accumulator;
+
+  // Длинные списки переходят через много срезов и блоков арены, большие
+  // разности и частоты кодируются несколькими байтами
+  for (int docId = 1; docId <= 20000; docId += 1 + rng() % 50) {
+    for (int term = 0; term < 30; ++term) {
+      if (term >= 3 && rng() % (term + 1) != 0) {
+        continue;
+      }
+      int frequency = 1 + static_cast<int>(rng() % (term == 0 ? 100000 : 5));
+      std::string name = "t" + std::to_string(term);
+      accumulator.add(name, docId, frequency);
+      expected[name].emplace_back(docId, frequency);
+    }
+  }
+  accumulator.add("rare", 1 << 24, 1);
+  expected["rare"].emplace_back(1 << 24, 1);
+
+  EXPECT_EQ(accumulator.termCount(), expected.size());
+  for (const auto &entry : expected) {
+    EXPECT_EQ(accumulator.postings(entry.first),
+              CompressionUtils::compressPostingList(entry.second))
+        << entry.first;
+  }
+  EXPECT_TRUE(accumulator.postings("missing").empty());
+
+  // docId термина должны возрастать
+  EXPECT_THROW(accumulator.add("rare", 5, 1), std::invalid_argument);
+
+  std::vector<std::string> order;
+  accumulator.finish(
+      [&](const std::string &term, std::vector<uint8_t> data) {
+        order.push_back(term);
+        EXPECT_EQ(data, CompressionUtils::compressPostingList(expected[term]));
+      });
+  ASSERT_EQ(order.size(), expected.size());
+  EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+  EXPECT_EQ(accumulator.termCount(), 0u);
+}
+
+TEST_F(RealSearchTest, DirectPostingsMatchSortedPairs) {
+  std::mt19937 rng(43);
+  for (int id = 100; id < 400; ++id) {
+    std::string text;
+    size_t words = 3 + rng() % 40;
+    for (size_t w = 0; w < words; ++w) {
+      text += "w" + std::to_string(rng() % (w == 0 ? 2000 : 50)) + " ";
+    }
+    createDoc(std::to_string(id) + ".txt", text);
+  }
+
+  auto indexBytes = [&](bool direct) {
+    engine->setDirectPostings(direct);
+    engine->indexDocuments();
+    EXPECT_TRUE(engine->saveIndex());
+    std::ifstream file(testIndexDir + "/inverted_index.bin",
+                       std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>());
+  };
+
+  std::string pairs = indexBytes(false);
+  auto expected = engine->searchTfIdf("w3 w11");
+  ASSERT_FALSE(expected.empty());
+
+  EXPECT_EQ(indexBytes(true), pairs);
+  auto results = engine->searchTfIdf("w3 w11");
+  ASSERT_EQ(results.size(), expected.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].docId, expected[i].docId);
+    EXPECT_DOUBLE_EQ(results[i].score, expected[i].score);
+  }
+}
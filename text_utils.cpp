@@ -149,4 +149,123 @@ std::vector<std::string> tokenize(const std::string &text) {
   return tokens;
 }
 
+std::vector<std::string> tokenizeQuery(const std::string &text) {
+  std::vector<std::string> tokens;
+  std::vector<uint32_t> codes = stringToCodes(text);
+  std::vector<uint32_t> currentToken;
+  bool hasSymbol = false;
+
+  auto flush = [&]() {
+    if (hasSymbol) {
+      tokens.push_back(codesToString(currentToken));
+    }
+    currentToken.clear();
+    hasSymbol = false;
+  };
+
+  for (uint32_t codepoint : codes) {
+    if (isValidSymbol(codepoint)) {
+      currentToken.push_back(charToLower(codepoint));
+      hasSymbol = true;
+    } else if (codepoint == '*' || codepoint == '?' || codepoint == '~') {
+      currentToken.push_back(codepoint);
+    } else {
+      flush();
+    }
+  }
+
+  flush();
+  return tokens;
+}
+
+namespace {
+
+constexpr uint64_t WORD_HASH_SEED = 14695981039346656037ULL;
+constexpr uint64_t WORD_HASH_PRIME = 1099511628211ULL;
+
+inline uint64_t hashCode(uint64_t hash, uint32_t codepoint) {
+  return (hash ^ codepoint) * WORD_HASH_PRIME;
+}
+
+} // namespace
+
+bool nextWordSpan(const std::string &text, size_t &offset, WordSpan &span) {
+  const unsigned char *ptr =
+      reinterpret_cast<const unsigned char *>(text.data());
+  const size_t length = text.size();
+
+  size_t i = offset;
+  bool inWord = false;
+
+  while (i < length) {
+    unsigned char byte = ptr[i];
+    uint32_t codepoint = byte;
+    size_t numContinuationBytes = 0;
+
+    if ((byte & 0xE0) == 0xC0) {
+      codepoint = byte & 0x1F;
+      numContinuationBytes = 1;
+    } else if ((byte & 0xF0) == 0xE0) {
+      codepoint = byte & 0x0F;
+      numContinuationBytes = 2;
+    } else if ((byte & 0xF8) == 0xF0) {
+      codepoint = byte & 0x07;
+      numContinuationBytes = 3;
+    } else if (byte >= 0x80) {
+      codepoint = 0;
+    }
+
+    if (i + numContinuationBytes >= length) {
+      numContinuationBytes = 0;
+      codepoint = 0;
+    }
+    for (size_t j = 1; j <= numContinuationBytes; ++j) {
+      if (!isContinuationByte(ptr[i + j])) {
+        numContinuationBytes = 0;
+        codepoint = 0;
+        break;
+      }
+      codepoint = (codepoint << 6) | (ptr[i + j] & 0x3F);
+    }
+
+    if (isValidSymbol(codepoint)) {
+      if (!inWord) {
+        span = {static_cast<uint32_t>(i), 0, WORD_HASH_SEED};
+        inWord = true;
+      }
+      span.hash = hashCode(span.hash, charToLower(codepoint));
+    } else if (inWord) {
+      span.end = static_cast<uint32_t>(i);
+      offset = i;
+      return true;
+    }
+
+    i += 1 + numContinuationBytes;
+  }
+
+  offset = length;
+  if (inWord) {
+    span.end = static_cast<uint32_t>(length);
+  }
+  return inWord;
+}
+
+std::vector<WordSpan> wordSpans(const std::string &text) {
+  std::vector<WordSpan> spans;
+  size_t offset = 0;
+  WordSpan span;
+  while (nextWordSpan(text, offset, span)) {
+    spans.push_back(span);
+  }
+  return spans;
+}
+
+uint64_t wordHash(const std::string &word) {
+  uint64_t hash = WORD_HASH_SEED;
+  for (uint32_t codepoint : stringToCodes(word)) {
+    hash = hashCode(hash, charToLower(codepoint));
+  }
+  return hash;
+}
+
 } // namespace TextUtils
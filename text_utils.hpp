@@ -21,6 +21,32 @@ std::string toLowerCase(const std::string &s);
 
 std::vector<std::string> tokenize(const std::string &text);
 
+std::vector<std::string> tokenizeQuery(const std::string &text);
+
+/**
+ * @brief Границы слова в байтах исходной строки и хеш его нижнего регистра
+ */
+struct WordSpan {
+  uint32_t begin;
+  uint32_t end;
+  uint64_t hash;
+};
+
+/**
+ * @brief Находит слова по тем же правилам, что и tokenize, без копирования
+ * @return Границы слов и хеши, совпадающие с wordHash() токенов tokenize
+ */
+std::vector<WordSpan> wordSpans(const std::string &text);
+
+/**
+ * @brief Находит следующее слово, начиная с байта offset
+ * @param offset Сдвигается за найденное слово
+ * @return false, если слов до конца текста больше нет
+ */
+bool nextWordSpan(const std::string &text, size_t &offset, WordSpan &span);
+
+uint64_t wordHash(const std::string &word);
+
 }
 
 #endif
@@ -0,0 +1,35 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threads) {
+  m_workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    m_workers.emplace_back([this] { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_ready.notify_all();
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_ready.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop();
+    }
+    task();
+  }
+}
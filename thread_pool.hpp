@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ============================================================================
+// ThreadPool
+// ============================================================================
+
+/**
+ * @brief Фиксированный набор рабочих потоков с общей очередью задач
+ *
+ * Потоки создаются один раз, поэтому запуск задачи на запрос не платит за
+ * создание потока. Деструктор дожидается выполнения уже поставленных задач.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t size() const { return m_workers.size(); }
+
+  /**
+   * @brief Ставит задачу в очередь
+   * @return Future с результатом задачи (исключение передаётся через get())
+   */
+  template <typename Task>
+  std::future<std::invoke_result_t<Task>> submit(Task task) {
+    auto packaged =
+        std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(
+            std::move(task));
+    auto result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.emplace([packaged] { (*packaged)(); });
+    }
+    m_ready.notify_one();
+    return result;
+  }
+
+private:
+  void workerLoop();
+
+  std::vector<std::thread> m_workers;
+  std::queue<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  bool m_stopping = false;
+};
+
+#endif // THREAD_POOL_HPP